@@ -0,0 +1,39 @@
+// Counting replacements for the global allocation functions.
+//
+// Linked into every benchmark executable so that benchmark cases can report
+// heap allocations per operation alongside their timings.
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "bench_common.hpp"
+
+namespace {
+    std::atomic<uint64_t> g_alloc_count{0};
+    std::atomic<uint64_t> g_alloc_bytes{0};
+
+    void* counted_alloc(std::size_t size) {
+        g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+        g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+        if (void* p = std::malloc(size == 0 ? 1 : size)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+namespace bench {
+
+AllocationSnapshot allocation_snapshot()
+{
+    return {g_alloc_count.load(std::memory_order_relaxed),
+            g_alloc_bytes.load(std::memory_order_relaxed)};
+}
+
+} // namespace bench
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,188 @@
+#pragma once
+
+/**
+ * @file bench_common.hpp
+ * @brief Minimal timing, allocation-counting and JSON reporting for benchmarks.
+ *
+ * Benchmark executables link alloc_counter.cpp, which replaces the global
+ * allocation functions with counting versions. Each benchmark case reports
+ * the median time per operation over several repetitions together with the
+ * number of heap allocations and bytes allocated per operation.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+/// Heap allocation totals since program start
+struct AllocationSnapshot {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+/// Current allocation totals (defined in alloc_counter.cpp)
+AllocationSnapshot allocation_snapshot();
+
+/// One benchmark result; per-op values are medians over repetitions
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double allocs_per_op = 0.0;
+    double bytes_per_op = 0.0;
+    std::vector<std::pair<std::string, double>> counters;  ///< Extra metrics
+};
+
+/// Options shared by all benchmark executables
+struct Options {
+    std::string json_path;   ///< Write JSON results here (empty: stdout only)
+    std::string filter;      ///< Only run cases whose name contains this
+    double min_time = 0.1;   ///< Minimum seconds per repetition
+    int repetitions = 5;     ///< Repetitions to take the median over
+    std::vector<std::string> extra;  ///< Unrecognized arguments
+
+    static Options parse(int argc, char** argv) {
+        Options opts;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    std::cerr << "Missing value for " << arg << "\n";
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+            if (arg == "--json") {
+                opts.json_path = value();
+            } else if (arg == "--filter") {
+                opts.filter = value();
+            } else if (arg == "--min-time") {
+                opts.min_time = std::stod(value());
+            } else if (arg == "--repetitions") {
+                opts.repetitions = std::max(1, std::stoi(value()));
+            } else {
+                opts.extra.push_back(arg);
+            }
+        }
+        return opts;
+    }
+
+    bool selected(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+};
+
+/// Prevent the optimizer from discarding a computed value
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Time `op` (one call = `ops_per_call` operations).
+ *
+ * Each repetition doubles the batch size until it runs for at least
+ * `min_time` seconds; `between_batches` runs untimed after every batch.
+ */
+inline Result measure(const std::string& name, const Options& opts,
+                      const std::function<void()>& op,
+                      uint64_t ops_per_call = 1,
+                      const std::function<void()>& between_batches = {}) {
+    using clock = std::chrono::steady_clock;
+    std::vector<double> ns, allocs, bytes;
+    uint64_t total_iterations = 0;
+
+    op();  // warm-up
+    if (between_batches) {
+        between_batches();
+    }
+
+    for (int rep = 0; rep < opts.repetitions; ++rep) {
+        uint64_t batch = 1;
+        while (true) {
+            AllocationSnapshot before = allocation_snapshot();
+            auto start = clock::now();
+            for (uint64_t i = 0; i < batch; ++i) {
+                op();
+            }
+            auto stop = clock::now();
+            AllocationSnapshot after = allocation_snapshot();
+            if (between_batches) {
+                between_batches();
+            }
+
+            double seconds = std::chrono::duration<double>(stop - start).count();
+            if (seconds >= opts.min_time || batch >= (uint64_t{1} << 40)) {
+                double n = static_cast<double>(batch * ops_per_call);
+                ns.push_back(seconds * 1e9 / n);
+                allocs.push_back(static_cast<double>(after.count - before.count) / n);
+                bytes.push_back(static_cast<double>(after.bytes - before.bytes) / n);
+                total_iterations += batch;
+                break;
+            }
+            batch *= 2;
+        }
+    }
+
+    auto median = [](std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    };
+
+    Result r;
+    r.name = name;
+    r.iterations = total_iterations;
+    r.ns_per_op = median(ns);
+    r.allocs_per_op = median(allocs);
+    r.bytes_per_op = median(bytes);
+    return r;
+}
+
+/// Print a human-readable table row
+inline void print_result(std::ostream& os, const Result& r) {
+    os << r.name;
+    for (std::size_t i = r.name.size(); i < 36; ++i) {
+        os << ' ';
+    }
+    os << r.ns_per_op << " ns/op  " << r.allocs_per_op << " allocs/op  "
+       << r.bytes_per_op << " B/op";
+    for (const auto& [key, value] : r.counters) {
+        os << "  " << key << "=" << value;
+    }
+    os << "\n";
+}
+
+/// Write all results as a JSON document
+inline void write_json(std::ostream& os, const std::vector<Result>& results) {
+    os << "{\n  \"context\": {\n"
+       << "    \"compiler\": \"" << __VERSION__ << "\",\n"
+#ifdef NDEBUG
+       << "    \"assertions\": false\n"
+#else
+       << "    \"assertions\": true\n"
+#endif
+       << "  },\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+           << ", \"ns_per_op\": " << r.ns_per_op
+           << ", \"allocs_per_op\": " << r.allocs_per_op
+           << ", \"bytes_per_op\": " << r.bytes_per_op;
+        for (const auto& [key, value] : r.counters) {
+            os << ", \"" << key << "\": " << value;
+        }
+        os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+} // namespace bench
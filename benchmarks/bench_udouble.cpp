@@ -0,0 +1,159 @@
+// Micro-benchmarks for udouble arithmetic, math functions and the registry.
+//
+// Usage: bench_udouble [--json results.json] [--filter name] [--min-time s]
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "bench_common.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::detail::VariableRegistry;
+
+namespace {
+    // Sum of n independent atomics, starting at `first_sigma`; summed
+    // pairwise so that building wide fixtures stays O(n log n)
+    udouble wide_value(std::size_t n, double first_sigma) {
+        std::vector<udouble> terms;
+        terms.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            terms.emplace_back(1.0, first_sigma + 1e-3 * static_cast<double>(i));
+        }
+        while (terms.size() > 1) {
+            std::vector<udouble> next;
+            next.reserve((terms.size() + 1) / 2);
+            for (std::size_t i = 0; i + 1 < terms.size(); i += 2) {
+                next.push_back(terms[i] + terms[i + 1]);
+            }
+            if (terms.size() % 2 == 1) {
+                next.push_back(terms.back());
+            }
+            terms = std::move(next);
+        }
+        return terms.empty() ? udouble() : terms.front();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::Options opts = bench::Options::parse(argc, argv);
+    std::vector<bench::Result> results;
+    auto& registry = VariableRegistry::instance();
+
+    auto run = [&](const std::string& name, const std::function<void()>& op,
+                   uint64_t ops_per_call = 1,
+                   const std::function<void()>& between = {}) {
+        if (!opts.selected(name)) {
+            return;
+        }
+        results.push_back(bench::measure(name, opts, op, ops_per_call, between));
+        bench::print_result(std::cout, results.back());
+    };
+
+    // Atomic construction (id reservation only; registration is deferred to
+    // first use); clear between batches to keep the registry bounded
+    registry.clear();
+    run("construct_atomic", [] {
+        udouble x(1.0, 0.1);
+        bench::do_not_optimize(x);
+    }, 1, [&registry] { registry.clear(); });
+
+    registry.clear();
+    udouble x(2.0, 0.1);
+    udouble y(3.0, 0.2);
+
+    run("add_atomics", [&] {
+        udouble z = x + y;
+        bench::do_not_optimize(z);
+    });
+
+    run("mul_atomics", [&] {
+        udouble z = x * y;
+        bench::do_not_optimize(z);
+    });
+
+    run("div_atomics", [&] {
+        udouble z = x / y;
+        bench::do_not_optimize(z);
+    });
+
+    run("scale_atomic", [&] {
+        udouble z = x * 2.5;
+        bench::do_not_optimize(z);
+    });
+
+    run("math_chain", [&] {
+        udouble z = uncertainties::sqrt(uncertainties::exp(uncertainties::sin(x)) + y);
+        bench::do_not_optimize(z);
+    }, 4);
+
+    run("stddev_atomic", [&] {
+        double s = x.stddev();
+        bench::do_not_optimize(s);
+    });
+
+    run("to_string_atomic", [&] {
+        std::string s = x.to_string();
+        bench::do_not_optimize(s);
+    });
+
+    // Operations on wide derivative maps
+    udouble wide_a = wide_value(1000, 0.01);
+    udouble wide_b = wide_value(1000, 0.02);
+    udouble wide_shared = wide_a + wide_value(1000, 0.03);
+
+    run("add_wide_1000", [&] {
+        udouble z = wide_a + wide_b;
+        bench::do_not_optimize(z);
+    });
+
+    run("mul_wide_shared_1000", [&] {
+        udouble z = wide_a * wide_shared;
+        bench::do_not_optimize(z);
+    });
+
+    run("sin_wide_1000", [&] {
+        udouble z = uncertainties::sin(wide_a);
+        bench::do_not_optimize(z);
+    });
+
+    udouble huge_a = wide_value(100000, 0.01);
+    udouble huge_b = huge_a * 0.5 + wide_value(100000, 0.02);
+
+    run("mul_wide_shared_100000", [&] {
+        udouble z = huge_a * huge_b;
+        bench::do_not_optimize(z);
+    });
+
+    run("accumulate_wide_100000", [&] {
+        udouble acc = huge_a;
+        acc += huge_b;
+        acc *= 0.5;
+        bench::do_not_optimize(acc);
+    });
+
+    run("stddev_wide_1000", [&] {
+        double s = wide_a.stddev();
+        bench::do_not_optimize(s);
+    });
+
+    // Running sum: the derivative map grows at every step
+    std::vector<udouble> atomics;
+    for (int i = 0; i < 256; ++i) {
+        atomics.emplace_back(1.0, 0.01);
+    }
+    run("running_sum_256", [&] {
+        udouble sum;
+        for (const auto& a : atomics) {
+            sum += a;
+        }
+        bench::do_not_optimize(sum);
+    }, atomics.size());
+
+    if (!opts.json_path.empty()) {
+        std::ofstream out(opts.json_path);
+        bench::write_json(out, results);
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+// End-to-end workloads modeled on production use of udouble.
+//
+// Each workload runs once per repetition and reports time per item,
+// allocations per item, throughput, peak RSS, registry size and the
+// distribution of derivative-map sizes of its outputs. Peak RSS is the
+// process high-water mark, so use --filter to measure one workload alone.
+//
+// Usage: bench_workloads [--json results.json] [--filter name]
+//                        [--rows N] [--eigen-n N] [--formula-rows N]
+//                        [--workload-repetitions R]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#ifdef UNCERTAINTIES_BENCH_EIGEN
+#include <Eigen/Dense>
+#include "uncertainties/eigen_support.hpp"
+#endif
+
+#include "bench_common.hpp"
+#include "uncertainties/formula.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::detail::VariableRegistry;
+
+namespace {
+
+struct WorkloadConfig {
+    std::size_t rows = 1000000;      // sensor aggregation rows
+    std::size_t eigen_n = 200;       // Eigen system size
+    std::size_t constants = 300;     // calibration constants
+    std::size_t formula_rows = 100000;
+};
+
+// Peak resident set size of the process in kilobytes (0 if unavailable)
+double peak_rss_kb() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#else
+    return static_cast<double>(usage.ru_maxrss);
+#endif
+#else
+    return 0.0;
+#endif
+}
+
+// Record output derivative sizes and return percentile counters
+std::vector<std::pair<std::string, double>> size_distribution(const std::vector<udouble>& outputs) {
+    std::vector<std::size_t> sizes;
+    sizes.reserve(outputs.size());
+    for (const auto& v : outputs) {
+        sizes.push_back(v.num_variables());
+    }
+    if (sizes.empty()) {
+        return {};
+    }
+    std::sort(sizes.begin(), sizes.end());
+    auto pct = [&sizes](double p) {
+        std::size_t i = static_cast<std::size_t>(p * static_cast<double>(sizes.size() - 1));
+        return static_cast<double>(sizes[i]);
+    };
+    return {{"deriv_min", pct(0.0)}, {"deriv_p50", pct(0.5)},
+            {"deriv_p99", pct(0.99)}, {"deriv_max", pct(1.0)}};
+}
+
+// Run `workload` (which returns its outputs) and build a result
+template <typename Workload>
+bench::Result run_workload(const std::string& name, std::size_t items,
+                           const bench::Options& opts, Workload workload) {
+    using clock = std::chrono::steady_clock;
+    bench::Result best;
+    for (int rep = 0; rep < opts.repetitions; ++rep) {
+        VariableRegistry::instance().clear();
+        bench::AllocationSnapshot before = bench::allocation_snapshot();
+        auto start = clock::now();
+        std::vector<udouble> outputs = workload();
+        auto stop = clock::now();
+        bench::AllocationSnapshot after = bench::allocation_snapshot();
+
+        double seconds = std::chrono::duration<double>(stop - start).count();
+        double n = static_cast<double>(items);
+        if (rep == 0 || seconds * 1e9 / n < best.ns_per_op) {
+            best.name = name;
+            best.iterations = static_cast<uint64_t>(rep + 1);
+            best.ns_per_op = seconds * 1e9 / n;
+            best.allocs_per_op = static_cast<double>(after.count - before.count) / n;
+            best.bytes_per_op = static_cast<double>(after.bytes - before.bytes) / n;
+            best.counters = {{"items_per_second", n / seconds},
+                             {"registry_size", static_cast<double>(VariableRegistry::instance().size())}};
+            for (const auto& c : size_distribution(outputs)) {
+                best.counters.push_back(c);
+            }
+        }
+    }
+    best.counters.emplace_back("peak_rss_kb", peak_rss_kb());
+    return best;
+}
+
+// Metrology calibration chain: hundreds of correlated constants (sharing
+// systematic components) feeding a chain of calibration steps.
+std::vector<udouble> calibration_chain(const WorkloadConfig& cfg) {
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    // Shared systematics make the constants correlated
+    std::vector<udouble> systematics;
+    for (int i = 0; i < 8; ++i) {
+        systematics.emplace_back(1.0, 1e-3 * (i + 1));
+    }
+    std::vector<udouble> constants;
+    constants.reserve(cfg.constants);
+    for (std::size_t i = 0; i < cfg.constants; ++i) {
+        udouble c(1.0 + 0.01 * noise(rng), 1e-4);
+        c = c * systematics[i % systematics.size()] + 0.1 * systematics[(i * 3) % systematics.size()];
+        constants.push_back(c);
+    }
+
+    // Each step transfers the calibration to the next instrument
+    std::vector<udouble> outputs;
+    udouble reference(10.0, 0.01);
+    for (std::size_t step = 0; step < cfg.constants; ++step) {
+        const udouble& gain = constants[step];
+        const udouble& offset = constants[(step * 7 + 3) % constants.size()];
+        udouble temperature(20.0 + 0.1 * noise(rng), 0.05);
+        udouble correction = 1.0 + 1e-4 * (temperature - 20.0);
+        reference = (reference * gain + 0.01 * offset) * correction;
+        outputs.push_back(reference);
+    }
+    return outputs;
+}
+
+// Sensor aggregation: calibrate every row and average 100-row windows
+std::vector<udouble> sensor_aggregation(const WorkloadConfig& cfg) {
+    constexpr std::size_t SENSORS = 16;
+    constexpr std::size_t WINDOW = 100;
+    std::mt19937_64 rng(2);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    std::vector<udouble> gains, offsets;
+    for (std::size_t s = 0; s < SENSORS; ++s) {
+        gains.emplace_back(1.0 + 0.01 * noise(rng), 1e-3);
+        offsets.emplace_back(0.1 * noise(rng), 1e-2);
+    }
+
+    std::vector<udouble> window_sums(SENSORS);
+    std::vector<std::size_t> window_counts(SENSORS, 0);
+    std::vector<udouble> outputs;
+    outputs.reserve(cfg.rows / WINDOW + SENSORS);
+
+    for (std::size_t row = 0; row < cfg.rows; ++row) {
+        std::size_t s = row % SENSORS;
+        udouble reading(100.0 + noise(rng), 0.5);
+        window_sums[s] += gains[s] * reading + offsets[s];
+        if (++window_counts[s] == WINDOW) {
+            outputs.push_back(window_sums[s] / static_cast<double>(WINDOW));
+            window_sums[s] = udouble();
+            window_counts[s] = 0;
+        }
+    }
+    return outputs;
+}
+
+#ifdef UNCERTAINTIES_BENCH_EIGEN
+// Uncertain linear system: matrix with a shared systematic scale, uncertain
+// right-hand side, solved with Eigen's partial-pivoting LU.
+std::vector<udouble> eigen_solve(const WorkloadConfig& cfg) {
+    using MatrixXu = Eigen::Matrix<udouble, Eigen::Dynamic, Eigen::Dynamic>;
+    using VectorXu = Eigen::Matrix<udouble, Eigen::Dynamic, 1>;
+    const Eigen::Index n = static_cast<Eigen::Index>(cfg.eigen_n);
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+    udouble scale(1.0, 1e-3);
+    MatrixXu A(n, n);
+    VectorXu b(n);
+    for (Eigen::Index i = 0; i < n; ++i) {
+        for (Eigen::Index j = 0; j < n; ++j) {
+            double nominal = uniform(rng) + (i == j ? static_cast<double>(n) : 0.0);
+            A(i, j) = scale * nominal;
+        }
+        b(i) = udouble(uniform(rng), 1e-2);
+    }
+
+    VectorXu x = A.partialPivLu().solve(b);
+    return std::vector<udouble>(x.data(), x.data() + x.size());
+}
+#endif
+
+// One formula exercising every umath function; written once for udouble
+// and FormulaVar
+template <typename T>
+T library_formula(const T& x, const T& y, const T& z) {
+    namespace u = uncertainties;
+    T trig = u::sin(x) * u::cos(y) + u::tan(x) - u::atan2(y, x);
+    T inverse = u::asin(x) + u::acos(y) + u::atan(z);
+    T hyperbolic = u::sinh(x) + u::cosh(y) - u::tanh(z);
+    T inverse_hyp = u::asinh(x) + u::acosh(z) + u::atanh(y);
+    T logs = u::exp(x) + u::log(z) + u::log10(z) + u::sqrt(z);
+    T other = u::abs(x - y) + u::hypot(x, y) + pow(z, x);
+    return trig * inverse + hyperbolic / inverse_hyp + logs * other;
+}
+
+// Formula library: the formula evaluated row by row with udouble
+std::vector<udouble> formula_library(const WorkloadConfig& cfg) {
+    std::mt19937_64 rng(4);
+    std::uniform_real_distribution<double> uniform(0.1, 0.9);
+
+    std::vector<udouble> outputs;
+    outputs.reserve(cfg.formula_rows);
+    for (std::size_t row = 0; row < cfg.formula_rows; ++row) {
+        udouble x(uniform(rng), 0.01);
+        udouble y(uniform(rng), 0.02);
+        udouble z(1.0 + uniform(rng), 0.03);
+        outputs.push_back(library_formula(x, y, z));
+    }
+    return outputs;
+}
+
+// The same rows as columns, recorded once and run by the formula VM
+std::vector<udouble> formula_library_vm(const WorkloadConfig& cfg) {
+    using uncertainties::Formula;
+    using uncertainties::FormulaInput;
+    using uncertainties::FormulaVar;
+    std::mt19937_64 rng(4);
+    std::uniform_real_distribution<double> uniform(0.1, 0.9);
+
+    const std::size_t rows = cfg.formula_rows;
+    std::vector<double> x(rows), y(rows), z(rows);
+    std::vector<double> sx(rows, 0.01), sy(rows, 0.02), sz(rows, 0.03);
+    for (std::size_t row = 0; row < rows; ++row) {
+        x[row] = uniform(rng);
+        y[row] = uniform(rng);
+        z[row] = 1.0 + uniform(rng);
+    }
+
+    Formula formula = Formula::record(3, [](const std::vector<FormulaVar>& in) {
+        return library_formula(in[0], in[1], in[2]);
+    });
+    auto result = formula.evaluate({FormulaInput::column(x, sx), FormulaInput::column(y, sy),
+                                    FormulaInput::column(z, sz)}, rows);
+    return result.values();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bench::Options opts = bench::Options::parse(argc, argv);
+    opts.repetitions = 1;
+    WorkloadConfig cfg;
+    for (std::size_t i = 0; i + 1 < opts.extra.size(); ++i) {
+        if (opts.extra[i] == "--rows") {
+            cfg.rows = std::stoul(opts.extra[i + 1]);
+        } else if (opts.extra[i] == "--eigen-n") {
+            cfg.eigen_n = std::stoul(opts.extra[i + 1]);
+        } else if (opts.extra[i] == "--formula-rows") {
+            cfg.formula_rows = std::stoul(opts.extra[i + 1]);
+        } else if (opts.extra[i] == "--workload-repetitions") {
+            opts.repetitions = std::max(1, std::stoi(opts.extra[i + 1]));
+        }
+    }
+
+    std::vector<bench::Result> results;
+    auto run = [&](const std::string& name, std::size_t items, auto workload) {
+        if (!opts.selected(name)) {
+            return;
+        }
+        results.push_back(run_workload(name, items, opts, workload));
+        bench::print_result(std::cout, results.back());
+    };
+
+    run("calibration_chain", cfg.constants, [&] { return calibration_chain(cfg); });
+    run("sensor_aggregation", cfg.rows, [&] { return sensor_aggregation(cfg); });
+#ifdef UNCERTAINTIES_BENCH_EIGEN
+    run("eigen_solve", cfg.eigen_n, [&] { return eigen_solve(cfg); });
+#endif
+    run("formula_library", cfg.formula_rows, [&] { return formula_library(cfg); });
+    run("formula_library_vm", cfg.formula_rows, [&] { return formula_library_vm(cfg); });
+
+    if (!opts.json_path.empty()) {
+        std::ofstream out(opts.json_path);
+        bench::write_json(out, results);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Compare benchmark results against a committed baseline.
+
+Runs a benchmark executable (or reads an existing results file), loads the
+baseline for the current CPU class from benchmarks/baselines/ and reports
+every case whose time per operation or allocations per operation grew beyond
+the configured thresholds. Exits with status 1 if any regression is found.
+
+Usage:
+    compare_baseline.py --bench ./bench_udouble
+    compare_baseline.py --results results.json --threshold 0.15
+    compare_baseline.py --bench ./bench_udouble --update   # rewrite baseline
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+
+BASELINE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "baselines")
+
+
+def cpu_class():
+    """Return a filesystem-friendly name for the CPU model of this machine."""
+    model = ""
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    model = line.split(":", 1)[1]
+                    break
+    except OSError:
+        pass
+    if not model:
+        model = platform.processor() or platform.machine()
+    model = re.sub(r"\((R|TM|tm|r)\)|CPU|Processor|@.*$", " ", model)
+    slug = re.sub(r"[^a-z0-9]+", "-", model.lower()).strip("-")
+    return "{}-{}".format(platform.machine().lower(), slug or "generic")
+
+
+def run_benchmark(executable, filter_arg, min_time):
+    fd, path = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    cmd = [executable, "--json", path, "--min-time", str(min_time)]
+    if filter_arg:
+        cmd += ["--filter", filter_arg]
+    subprocess.run(cmd, check=True, stdout=sys.stderr)
+    with open(path) as f:
+        results = json.load(f)
+    os.remove(path)
+    return results
+
+
+def index(document):
+    return {b["name"]: b for b in document["benchmarks"]}
+
+
+def compare(baseline, current, time_threshold, alloc_threshold):
+    """Return (rows, regressions) comparing two result documents."""
+    rows, regressions = [], []
+    base = index(baseline)
+    for name, cur in sorted(index(current).items()):
+        if name not in base:
+            rows.append((name, "new", "", ""))
+            continue
+        old = base[name]
+        time_ratio = cur["ns_per_op"] / old["ns_per_op"] if old["ns_per_op"] > 0 else 1.0
+        alloc_delta = cur["allocs_per_op"] - old["allocs_per_op"]
+        alloc_limit = max(alloc_threshold * old["allocs_per_op"], 0.5)
+
+        flags = []
+        if time_ratio > 1.0 + time_threshold:
+            flags.append("SLOWER")
+        if alloc_delta > alloc_limit:
+            flags.append("MORE ALLOCS")
+        rows.append((name, "{:+.1f}%".format((time_ratio - 1.0) * 100.0),
+                     "{:+.2f}".format(alloc_delta), " ".join(flags)))
+        if flags:
+            regressions.append(name)
+    for name in sorted(set(base) - set(index(current))):
+        rows.append((name, "missing", "", ""))
+    return rows, regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--bench", help="benchmark executable to run")
+    source.add_argument("--results", help="existing JSON results to compare")
+    parser.add_argument("--cpu-class", default=None,
+                        help="baseline name (default: derived from the CPU model)")
+    parser.add_argument("--threshold", type=float, default=0.20,
+                        help="allowed relative slowdown (default: 0.20)")
+    parser.add_argument("--alloc-threshold", type=float, default=0.0,
+                        help="allowed relative increase in allocations (default: 0)")
+    parser.add_argument("--filter", default="", help="only run matching cases")
+    parser.add_argument("--min-time", type=float, default=0.1,
+                        help="minimum seconds per repetition")
+    parser.add_argument("--update", action="store_true",
+                        help="write the results as the new baseline")
+    args = parser.parse_args()
+
+    if args.bench:
+        current = run_benchmark(args.bench, args.filter, args.min_time)
+        suite = os.path.basename(args.bench)
+    else:
+        with open(args.results) as f:
+            current = json.load(f)
+        suite = os.path.splitext(os.path.basename(args.results))[0]
+
+    name = args.cpu_class or cpu_class()
+    current["context"]["cpu_class"] = name
+    baseline_path = os.path.join(BASELINE_DIR, name, suite + ".json")
+
+    if args.update:
+        os.makedirs(os.path.dirname(baseline_path), exist_ok=True)
+        with open(baseline_path, "w") as f:
+            json.dump(current, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Baseline written to {}".format(baseline_path))
+        return 0
+
+    if not os.path.exists(baseline_path):
+        print("No baseline for CPU class '{}' ({}). Run with --update to create one."
+              .format(name, baseline_path))
+        return 0
+
+    with open(baseline_path) as f:
+        baseline = json.load(f)
+
+    rows, regressions = compare(baseline, current, args.threshold, args.alloc_threshold)
+    print("{:<36} {:>10} {:>12}  {}".format("benchmark", "time", "allocs/op", ""))
+    for row in rows:
+        print("{:<36} {:>10} {:>12}  {}".format(*row))
+
+    if regressions:
+        print("\n{} regression(s) against {}".format(len(regressions), baseline_path))
+        return 1
+    print("\nNo regressions against {}".format(baseline_path))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,162 @@
+#pragma once
+
+/**
+ * @file derivative_budget.hpp
+ * @brief Per-thread limits on the size of derivative maps.
+ *
+ * Long chains of operations over many distinct atomic variables can produce
+ * udouble values with very large derivative maps. A DerivativeBudget caps the
+ * number of entries (and the estimated memory) of any map produced by the
+ * arithmetic operators and math functions on the current thread. When a map
+ * exceeds the budget, the configured action is taken: throw, prune the least
+ * significant entries, or notify a callback.
+ *
+ * Example usage:
+ * @code
+ * uncertainties::DerivativeBudget budget;
+ * budget.max_entries = 100000;
+ * budget.action = uncertainties::BudgetAction::Prune;
+ *
+ * uncertainties::ScopedDerivativeBudget scope(budget);
+ * // ... computations on this thread are now bounded ...
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/**
+ * @brief What to do when a derivative map exceeds the budget.
+ */
+enum class BudgetAction {
+    Throw,    ///< Throw derivative_budget_exceeded
+    Prune,    ///< Keep only the entries contributing most to the variance
+    Callback  ///< Invoke DerivativeBudget::callback and keep the map unchanged
+};
+
+/**
+ * @brief Limits applied to every derivative map produced on a thread.
+ *
+ * A limit of zero disables the corresponding check. The default budget has
+ * no limits, so enforcement costs a single branch per operation.
+ */
+struct DerivativeBudget {
+    std::size_t max_entries = 0;  ///< Maximum number of derivative entries
+    std::size_t max_bytes = 0;    ///< Maximum estimated map memory in bytes
+    BudgetAction action = BudgetAction::Throw;
+
+    /// Called with (entries, estimated bytes) when action is Callback
+    std::function<void(std::size_t, std::size_t)> callback;
+};
+
+/**
+ * @brief Counters describing how often the budget was breached on a thread.
+ */
+struct DerivativeBudgetStats {
+    uint64_t exceeded = 0;   ///< Number of maps that exceeded the budget
+    uint64_t thrown = 0;     ///< Number of exceptions thrown
+    uint64_t pruned = 0;     ///< Number of maps pruned
+    uint64_t callbacks = 0;  ///< Number of callback invocations
+    uint64_t entries_pruned = 0;  ///< Total entries removed by pruning
+};
+
+/**
+ * @class derivative_budget_exceeded
+ * @brief Thrown when a derivative map exceeds the budget and the action is Throw.
+ */
+class derivative_budget_exceeded : public std::runtime_error {
+public:
+    derivative_budget_exceeded(std::size_t entries, std::size_t bytes)
+        : std::runtime_error("Derivative map exceeds the configured budget."),
+          entries_(entries), bytes_(bytes) {}
+
+    /** @brief Number of entries in the offending map. */
+    std::size_t entries() const noexcept { return entries_; }
+
+    /** @brief Estimated memory of the offending map in bytes. */
+    std::size_t bytes() const noexcept { return bytes_; }
+
+private:
+    std::size_t entries_;
+    std::size_t bytes_;
+};
+
+/**
+ * @brief Set the derivative budget for the calling thread.
+ * @param budget The new budget
+ */
+void set_derivative_budget(const DerivativeBudget& budget);
+
+/**
+ * @brief Get the derivative budget of the calling thread.
+ * @return The current budget
+ */
+const DerivativeBudget& derivative_budget();
+
+/**
+ * @brief Get the breach counters of the calling thread.
+ * @return A copy of the current counters
+ */
+DerivativeBudgetStats derivative_budget_stats();
+
+/**
+ * @brief Reset the breach counters of the calling thread to zero.
+ */
+void reset_derivative_budget_stats();
+
+/**
+ * @class ScopedDerivativeBudget
+ * @brief Installs a budget for the lifetime of the object.
+ *
+ * The previous budget of the thread is restored on destruction, so scopes
+ * can be nested to give individual computations their own limits.
+ */
+class ScopedDerivativeBudget {
+public:
+    explicit ScopedDerivativeBudget(const DerivativeBudget& budget)
+        : previous_(derivative_budget())
+    {
+        set_derivative_budget(budget);
+    }
+
+    ~ScopedDerivativeBudget() { set_derivative_budget(previous_); }
+
+    ScopedDerivativeBudget(const ScopedDerivativeBudget&) = delete;
+    ScopedDerivativeBudget& operator=(const ScopedDerivativeBudget&) = delete;
+
+private:
+    DerivativeBudget previous_;
+};
+
+namespace detail {
+
+/**
+ * @brief Estimate the memory used by a derivative map.
+ * @param derivs The derivative map
+ * @return Approximate size in bytes of nodes and bucket array
+ */
+std::size_t estimate_map_bytes(const udouble::DerivativeMap& derivs);
+
+/**
+ * @brief Apply the calling thread's budget to a freshly built map.
+ * @param derivs The derivative map (may be pruned in place)
+ * @throws derivative_budget_exceeded if the budget is exceeded and the
+ *         action is BudgetAction::Throw
+ */
+void enforce_derivative_budget(udouble::DerivativeMap& derivs);
+
+/**
+ * @brief Add counters collected on another thread to the calling thread's.
+ * @param stats Counters to add, e.g. those of a finished worker thread
+ */
+void merge_derivative_budget_stats(const DerivativeBudgetStats& stats);
+
+} // namespace detail
+
+} // namespace uncertainties
@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+ * @file distributed.hpp
+ * @brief Moving udouble values between processes and nodes.
+ *
+ * Atomic IDs are allocated from a per-process counter, so two worker
+ * processes hand out the same IDs for unrelated atomics. If their results
+ * were combined as-is, the correlations would be silently wrong. Each
+ * worker therefore picks its own ID namespace, a prefix in the top bits of
+ * every ID it allocates, before creating atomics. Values computed in
+ * different namespaces never share IDs unless they really depend on the
+ * same atomic, for example a parameter created before the workers forked.
+ *
+ * serialize() writes values together with the stddevs of every atomic they
+ * depend on, as hexadecimal floating point, so a round trip is exact.
+ * deserialize() registers those atomics and rebuilds the values. An ID
+ * that is already registered with a different stddev is reported as a
+ * collision instead of being merged. The stream also names the writer's
+ * namespace and process, so colliding IDs are detected even when the
+ * stddevs agree: atomics another process created in its namespace are
+ * rejected if that namespace is the reader's, or if a different process
+ * already sent atomics from it.
+ *
+ * Example usage:
+ * @code
+ * // Worker k
+ * uncertainties::set_id_namespace(k + 1);
+ * std::vector<udouble> results = ...;
+ * uncertainties::serialize(pipe, results);
+ *
+ * // Coordinator (namespace 0)
+ * std::vector<udouble> merged = uncertainties::deserialize(pipe);
+ * @endcode
+ */
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/**
+ * @brief Allocate atomic IDs of this process in namespace `ns` from now on.
+ * @throws std::invalid_argument if ns exceeds the namespace range (16 bits)
+ */
+void set_id_namespace(uint64_t ns);
+
+/** @brief Namespace atomic IDs are currently allocated in. */
+uint64_t id_namespace();
+
+/**
+ * @brief Write values and the stddevs of the atomics they depend on.
+ */
+void serialize(std::ostream& out, const std::vector<udouble>& values);
+
+/**
+ * @brief Read values written by serialize(), registering their atomics.
+ * @throws std::runtime_error on malformed input, if an atomic ID is
+ *         already registered with a different stddev, or if the writer's
+ *         namespace is this process's or was claimed by another writer
+ */
+std::vector<udouble> deserialize(std::istream& in);
+
+} // namespace uncertainties
@@ -0,0 +1,136 @@
+#pragma once
+
+/**
+ * @file filter.hpp
+ * @brief Linear filters (FIR convolution, moving average, exponential
+ *        smoothing) over udouble time series.
+ *
+ * Smoothing a series with udouble arithmetic builds one temporary derivative
+ * map per multiply-add, and every output ends up holding the merged maps of
+ * its whole window. These filters are linear, so output k is described by
+ * its nominal value and the coefficients ∂y_k/∂x_i, which are non-zero only
+ * in a band of inputs. FilterResult keeps that banded Jacobian implicitly
+ * (the kernel and the band of every output) instead of n derivative maps.
+ *
+ * Nominal values are computed with plain dense loops over contiguous
+ * arrays. Standard deviations take a fast path when the inputs are
+ * mutually uncorrelated (their variances are filtered with the squared
+ * kernel); otherwise the band of each output is merged into a per-thread
+ * scratch map. Either way a fixed-width filter runs in time and memory
+ * linear in the length of the signal.
+ *
+ * Example usage:
+ * @code
+ * std::vector<uncertainties::udouble> signal = ...;
+ * auto smooth = uncertainties::moving_average(signal, 25);
+ * const std::vector<double>& sigma = smooth.stddev();
+ * uncertainties::udouble y = smooth.value(100);  // correlated with signal
+ * @endcode
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Output range of convolve(), as in numpy.convolve
+enum class FilterMode {
+    Full,   ///< Every partial overlap: n + w - 1 outputs
+    Same,   ///< n outputs, centered on the inputs
+    Valid   ///< Only complete overlaps: n - w + 1 outputs
+};
+
+/// Options for the filter functions
+struct FilterOptions {
+    std::size_t threads = 0;  ///< Threads used (0: hardware concurrency)
+};
+
+/**
+ * @class FilterResult
+ * @brief Outputs of a linear filter with a banded Jacobian.
+ *
+ * Output k depends on inputs [band_begin(k), band_end(k)).
+ */
+class FilterResult {
+public:
+    std::size_t size() const noexcept { return nominals_.size(); }
+
+    /** @brief Nominal value of every output. */
+    const std::vector<double>& nominal() const noexcept { return nominals_; }
+
+    /** @brief Standard deviation of every output. */
+    const std::vector<double>& stddev() const noexcept { return stddevs_; }
+
+    /** @brief First input output k depends on. */
+    std::size_t band_begin(std::size_t k) const noexcept;
+
+    /** @brief One past the last input output k depends on. */
+    std::size_t band_end(std::size_t k) const noexcept;
+
+    /** @brief ∂y_k/∂x_i (0 outside the band). */
+    double coefficient(std::size_t k, std::size_t i) const noexcept;
+
+    /** @brief Output k as a udouble, correlated with the inputs. */
+    udouble value(std::size_t k) const;
+
+    /** @brief Every output as a udouble. */
+    std::vector<udouble> values() const;
+
+private:
+    enum class Kind { Fir, Exponential };
+
+    Kind kind_ = Kind::Fir;
+    std::size_t threads_ = 0;
+    std::vector<udouble> inputs_;
+    std::vector<double> kernel_;    ///< FIR taps h_0..h_{w-1}
+    std::size_t offset_ = 0;        ///< FIR: output k is full-convolution index k + offset_
+    double alpha_ = 1.0;            ///< Exponential: smoothing factor
+    std::size_t tail_ = 1;          ///< Exponential: inputs kept in a materialized band
+    std::vector<double> nominals_;
+    std::vector<double> stddevs_;
+
+    void compute_fir_stddevs();
+    void compute_exponential_stddevs();
+
+    friend FilterResult convolve(const std::vector<udouble>& signal,
+                                 const std::vector<double>& kernel, FilterMode mode,
+                                 const FilterOptions& options);
+    friend FilterResult exponential_smoothing(const std::vector<udouble>& signal, double alpha,
+                                              const FilterOptions& options);
+};
+
+/**
+ * @brief Discrete convolution y_m = Σ_j h_j x_{m-j} of a signal with an exact kernel.
+ * @param signal Input series
+ * @param kernel Filter taps (must not be empty)
+ * @param mode Output range
+ * @param options Threading options
+ * @throws std::invalid_argument if the kernel is empty
+ */
+FilterResult convolve(const std::vector<udouble>& signal, const std::vector<double>& kernel,
+                      FilterMode mode = FilterMode::Full, const FilterOptions& options = {});
+
+/**
+ * @brief Trailing moving average over `window` samples (Valid mode).
+ * @throws std::invalid_argument if window is 0
+ */
+FilterResult moving_average(const std::vector<udouble>& signal, std::size_t window,
+                            const FilterOptions& options = {});
+
+/**
+ * @brief Exponential smoothing y_0 = x_0, y_k = α x_k + (1 - α) y_{k-1}.
+ *
+ * The filter is recursive, so every output depends on all earlier inputs.
+ * Nominals and stddevs use the exact recursion; coefficients, value() and
+ * values() drop inputs whose weight has decayed below double precision,
+ * which keeps the band finite.
+ *
+ * @param alpha Smoothing factor in (0, 1]
+ * @throws std::invalid_argument if alpha is outside (0, 1]
+ */
+FilterResult exponential_smoothing(const std::vector<udouble>& signal, double alpha,
+                                   const FilterOptions& options = {});
+
+} // namespace uncertainties
@@ -0,0 +1,514 @@
+#pragma once
+
+/**
+ * @file formula.hpp
+ * @brief Record a formula once and evaluate it over columnar data.
+ *
+ * A formula written with udouble operators and umath functions is recorded
+ * into a compact register-based bytecode program by running it once on
+ * symbolic FormulaVar inputs. The program is then evaluated for every row of
+ * a table by a block interpreter: each instruction processes a block of rows
+ * at a time, computing the nominal values and the dense derivatives with
+ * respect to every formula input in contiguous arrays. Rows are split across
+ * threads and no memory is allocated per row.
+ *
+ * Example usage:
+ * @code
+ * // Works for both udouble and FormulaVar arguments
+ * auto model = [](const auto& x, const auto& y) { return sin(x) * y + 2.0; };
+ *
+ * auto formula = uncertainties::Formula::record(2, [&](const auto& in) {
+ *     return model(in[0], in[1]);
+ * });
+ * auto result = formula.evaluate({FormulaInput::column(x_nominal, x_stddev),
+ *                                 FormulaInput::parameter(gain)}, rows);
+ * const std::vector<double>& sigma = result.stddev();
+ * @endcode
+ *
+ * While recording, operations on constants are evaluated immediately,
+ * identical subexpressions are shared (so `sin(x) * sin(x)` computes sin
+ * once) and exact identities such as `x * 1` are removed.
+ *
+ * Formulas must be straight-line code: branches on nominal values (e.g.
+ * comparisons) are taken once at recording time.
+ *
+ * For formulas with many inputs and few outputs, FormulaAdjoints and
+ * Formula::jacobian() differentiate in reverse mode instead. The reverse
+ * sweep either keeps a tape of every instruction's partial derivatives or,
+ * with a checkpoint budget, keeps a few register snapshots and recomputes
+ * the rest (binomial checkpointing), bounding memory for long programs.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+namespace detail {
+
+/// Operations of the formula bytecode
+enum class FormulaOp : uint8_t {
+    Input,      ///< dst = input[index]
+    Const,      ///< dst = constant
+    Add, Sub, Mul, Div,
+    AddScalar,  ///< dst = a + constant
+    MulScalar,  ///< dst = a * constant
+    DivScalar,  ///< dst = a / constant
+    ScalarSub,  ///< dst = constant - a
+    ScalarDiv,  ///< dst = constant / a
+    Neg,
+    Pow,
+    PowScalar,  ///< dst = a ^ constant
+    ScalarPow,  ///< dst = constant ^ a
+    Sin, Cos, Tan, Asin, Acos, Atan, Atan2,
+    Sinh, Cosh, Tanh, Asinh, Acosh, Atanh,
+    Exp, Log, Log10, Sqrt, Abs, Hypot
+};
+
+/// Number of register operands of an operation
+inline std::size_t arity(FormulaOp op) noexcept {
+    switch (op) {
+        case FormulaOp::Input:
+        case FormulaOp::Const:
+            return 0;
+        case FormulaOp::Add:
+        case FormulaOp::Sub:
+        case FormulaOp::Mul:
+        case FormulaOp::Div:
+        case FormulaOp::Pow:
+        case FormulaOp::Atan2:
+        case FormulaOp::Hypot:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+/// One recorded operation; operands refer to earlier nodes
+struct FormulaNode {
+    FormulaOp op;
+    uint32_t a = 0;         ///< First operand (the input index for Input)
+    uint32_t b = 0;         ///< Second operand of binary operations
+    double constant = 0.0;  ///< Immediate operand
+};
+
+/// One bytecode instruction; operands and result are register numbers
+struct FormulaInstruction {
+    FormulaOp op;
+    uint32_t dst;
+    uint32_t a;             ///< First operand (the input index for Input)
+    uint32_t b;
+    double constant;
+};
+
+/// Nodes are equal if operation, operands and immediate (bitwise) agree
+struct FormulaNodeEqual {
+    bool operator()(const FormulaNode& x, const FormulaNode& y) const noexcept {
+        return x.op == y.op && x.a == y.a && x.b == y.b &&
+               std::memcmp(&x.constant, &y.constant, sizeof(double)) == 0;
+    }
+};
+
+struct FormulaNodeHash {
+    std::size_t operator()(const FormulaNode& n) const noexcept {
+        uint64_t bits;
+        std::memcpy(&bits, &n.constant, sizeof(bits));
+        uint64_t h = static_cast<uint64_t>(n.op);
+        h = h * 0x9E3779B97F4A7C15ULL ^ n.a;
+        h = h * 0x9E3779B97F4A7C15ULL ^ n.b;
+        h = h * 0x9E3779B97F4A7C15ULL ^ bits;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+};
+
+/**
+ * @brief Operations recorded while a formula runs on FormulaVar arguments.
+ *
+ * Nodes are hash-consed: recording an operation that already exists on
+ * the same operands returns the existing node, so repeated
+ * subexpressions are evaluated once.
+ */
+struct FormulaTape {
+    std::vector<FormulaNode> nodes;
+    std::unordered_map<FormulaNode, uint32_t, FormulaNodeHash, FormulaNodeEqual> index;
+};
+
+} // namespace detail
+
+/**
+ * @class FormulaVar
+ * @brief Symbolic stand-in for a udouble while a formula is recorded.
+ *
+ * Supports the same operators and math functions as udouble. Plain doubles
+ * convert implicitly to constants, and operations on constants alone are
+ * evaluated immediately. A FormulaVar is only valid during
+ * Formula::record().
+ */
+class FormulaVar {
+public:
+    /** @brief Constant with the given value. */
+    FormulaVar(double value = 0.0) noexcept : value_(value) {}
+
+    /** @brief True if this is a constant rather than a recorded node. */
+    bool is_constant() const noexcept { return tape_ == nullptr; }
+
+    /** @brief Value of a constant (0 for recorded nodes). */
+    double constant_value() const noexcept { return value_; }
+
+    FormulaVar& operator+=(const FormulaVar& rhs);
+    FormulaVar& operator-=(const FormulaVar& rhs);
+    FormulaVar& operator*=(const FormulaVar& rhs);
+    FormulaVar& operator/=(const FormulaVar& rhs);
+
+private:
+    FormulaVar(detail::FormulaTape* tape, uint32_t node) noexcept
+        : tape_(tape), node_(node) {}
+
+    detail::FormulaTape* tape_ = nullptr;  ///< Tape of a recorded node
+    uint32_t node_ = 0;                    ///< Node index in the tape
+    double value_ = 0.0;                   ///< Constant value
+
+    friend class Formula;
+    friend struct FormulaRecorder;
+};
+
+/// @name FormulaVar operators and functions (mirror udouble and umath.hpp)
+/// @{
+
+FormulaVar operator+(const FormulaVar& lhs, const FormulaVar& rhs);
+FormulaVar operator-(const FormulaVar& lhs, const FormulaVar& rhs);
+FormulaVar operator*(const FormulaVar& lhs, const FormulaVar& rhs);
+FormulaVar operator/(const FormulaVar& lhs, const FormulaVar& rhs);
+FormulaVar operator-(const FormulaVar& x);
+inline FormulaVar operator+(const FormulaVar& x) { return x; }
+
+FormulaVar pow(const FormulaVar& base, const FormulaVar& exponent);
+FormulaVar sin(const FormulaVar& x);
+FormulaVar cos(const FormulaVar& x);
+FormulaVar tan(const FormulaVar& x);
+FormulaVar asin(const FormulaVar& x);
+FormulaVar acos(const FormulaVar& x);
+FormulaVar atan(const FormulaVar& x);
+FormulaVar atan2(const FormulaVar& y, const FormulaVar& x);
+FormulaVar sinh(const FormulaVar& x);
+FormulaVar cosh(const FormulaVar& x);
+FormulaVar tanh(const FormulaVar& x);
+FormulaVar asinh(const FormulaVar& x);
+FormulaVar acosh(const FormulaVar& x);
+FormulaVar atanh(const FormulaVar& x);
+FormulaVar exp(const FormulaVar& x);
+FormulaVar log(const FormulaVar& x);
+FormulaVar log10(const FormulaVar& x);
+FormulaVar sqrt(const FormulaVar& x);
+FormulaVar abs(const FormulaVar& x);
+FormulaVar hypot(const FormulaVar& x, const FormulaVar& y);
+
+/// @}
+
+/**
+ * @class FormulaInput
+ * @brief One input of a formula evaluation: a data column or a shared parameter.
+ *
+ * Columns are viewed, not copied, and must outlive the evaluate() call.
+ * Each row of a column with a stddev is an independent atomic variable.
+ * A parameter is the same udouble in every row, so its correlations with
+ * other parameters carry into every output.
+ */
+class FormulaInput {
+public:
+    /**
+     * @brief Column of per-row values.
+     * @param nominal Nominal values, one per row
+     * @param stddev Standard deviations, one per row (nullptr: exact values)
+     */
+    static FormulaInput column(const double* nominal, const double* stddev = nullptr) {
+        FormulaInput in;
+        in.nominal_ = nominal;
+        in.stddev_ = stddev;
+        return in;
+    }
+
+    /**
+     * @brief Column of per-row values from vectors.
+     * @param nominal Nominal values, one per row
+     * @param stddev Standard deviations (empty: exact values)
+     * @throws std::invalid_argument if stddev is non-empty with another size
+     */
+    static FormulaInput column(const std::vector<double>& nominal,
+                               const std::vector<double>& stddev = {});
+
+    /** @brief Shared parameter with the same value in every row. */
+    static FormulaInput parameter(const udouble& value) {
+        FormulaInput in;
+        in.parameter_ = value;
+        in.is_parameter_ = true;
+        return in;
+    }
+
+    bool is_parameter() const noexcept { return is_parameter_; }
+
+private:
+    const double* nominal_ = nullptr;
+    const double* stddev_ = nullptr;
+    std::size_t size_ = std::numeric_limits<std::size_t>::max();
+    udouble parameter_;
+    bool is_parameter_ = false;
+
+    friend class Formula;
+    friend class FormulaResult;
+};
+
+/// Options for Formula::evaluate()
+struct FormulaOptions {
+    std::size_t threads = 0;           ///< Worker threads (0: hardware concurrency)
+    std::size_t block_size = 256;      ///< Rows processed per instruction dispatch
+    bool keep_derivatives = true;      ///< Store ∂output/∂input columns
+};
+
+/// Options for FormulaAdjoints and Formula::jacobian()
+struct FormulaReverseOptions {
+    std::size_t checkpoints = 0;  ///< Register snapshots for the reverse sweep (0: tape every instruction)
+    std::size_t threads = 0;      ///< jacobian() worker threads (0: hardware concurrency)
+    std::size_t lanes = 16;       ///< Outputs per reverse sweep in jacobian()
+};
+
+/**
+ * @class FormulaResult
+ * @brief Output columns of a formula evaluation.
+ *
+ * Holds the nominal value and standard deviation of every output for every
+ * row and, unless disabled, the derivative of every output with respect to
+ * every input. Rows can be turned back into correlated udouble values.
+ */
+class FormulaResult {
+public:
+    std::size_t rows() const noexcept { return rows_; }
+    std::size_t num_outputs() const noexcept { return nominals_.size(); }
+    std::size_t num_inputs() const noexcept { return inputs_.size(); }
+
+    /** @brief Nominal values of an output, one per row. */
+    const std::vector<double>& nominal(std::size_t output = 0) const { return nominals_.at(output); }
+
+    /** @brief Standard deviations of an output, one per row. */
+    const std::vector<double>& stddev(std::size_t output = 0) const { return stddevs_.at(output); }
+
+    /**
+     * @brief ∂output/∂input for every row.
+     * @throws std::runtime_error if derivatives were not kept
+     */
+    const std::vector<double>& derivative(std::size_t output, std::size_t input) const;
+
+    /**
+     * @brief One output of one row as a udouble.
+     *
+     * Row values of column inputs are registered as atomics on first use;
+     * values materialized from the same result share them, so they are
+     * correlated with each other and with the parameters.
+     * @throws std::runtime_error if derivatives were not kept
+     */
+    udouble value(std::size_t row, std::size_t output = 0) const;
+
+    /** @brief Every row of one output as udouble values. */
+    std::vector<udouble> values(std::size_t output = 0) const;
+
+private:
+    struct InputInfo {
+        bool is_parameter = false;
+        udouble parameter;
+        std::vector<double> stddev;  ///< Per-row stddevs of a column (empty: exact)
+        uint64_t first_id = 0;       ///< Reserved ID of row 0 of a column
+    };
+
+    udouble make_value(std::size_t row, std::size_t output, bool register_row) const;
+
+    std::size_t rows_ = 0;
+    std::vector<InputInfo> inputs_;
+    std::vector<std::vector<double>> nominals_;
+    std::vector<std::vector<double>> stddevs_;
+    std::vector<std::vector<std::vector<double>>> derivatives_;  ///< [output][input][row]
+
+    friend class Formula;
+};
+
+struct SparsityPattern;
+
+/**
+ * @class Formula
+ * @brief A recorded formula compiled to register bytecode.
+ */
+class Formula {
+public:
+    /**
+     * @brief Record a formula by running it once on symbolic inputs.
+     * @param num_inputs Number of formula inputs
+     * @param f Callable taking `const std::vector<FormulaVar>&` and
+     *          returning a FormulaVar or a std::vector<FormulaVar>
+     */
+    template <typename F>
+    static Formula record(std::size_t num_inputs, F&& f) {
+        auto tape = std::make_unique<detail::FormulaTape>();
+        std::vector<FormulaVar> inputs = make_inputs(*tape, num_inputs);
+        using Result = decltype(f(inputs));
+        std::vector<FormulaVar> outputs;
+        if constexpr (std::is_convertible_v<Result, FormulaVar>) {
+            outputs.push_back(f(inputs));
+        } else {
+            outputs = f(inputs);
+        }
+        return Formula(*tape, num_inputs, outputs);
+    }
+
+    std::size_t num_inputs() const noexcept { return num_inputs_; }
+    std::size_t num_outputs() const noexcept { return outputs_.size(); }
+
+    /** @brief Number of bytecode instructions. */
+    std::size_t size() const noexcept { return code_.size(); }
+
+    /** @brief Number of registers used by the program. */
+    std::size_t num_registers() const noexcept { return num_registers_; }
+
+    /**
+     * @brief Evaluate the formula for `rows` rows.
+     * @param inputs One FormulaInput per formula input
+     * @param rows Number of rows
+     * @param options Threading and blocking options
+     * @throws std::invalid_argument on an input count or size mismatch, or
+     *         if a row is outside the domain of a function (as udouble would)
+     * @throws std::runtime_error on division by zero or a non-positive base
+     *         of pow (as udouble would)
+     */
+    FormulaResult evaluate(const std::vector<FormulaInput>& inputs, std::size_t rows,
+                           const FormulaOptions& options = {}) const;
+
+    /**
+     * @brief Evaluate the formula once on udouble arguments.
+     * @return One udouble per output, correlated with the arguments
+     */
+    std::vector<udouble> apply(const std::vector<udouble>& args) const;
+
+    /**
+     * @brief Jacobian at one point by reverse sweeps.
+     * @param x Input values (num_inputs())
+     * @param options Checkpointing, threading and lanes per sweep
+     * @return ∂output/∂input, row-major num_outputs() × num_inputs()
+     * @throws std::invalid_argument if x has the wrong size, or on domain
+     *         errors as evaluate()
+     *
+     * Outputs are split into groups of `options.lanes`, and the groups are
+     * pulled back in parallel. Without checkpoints, the forward pass runs
+     * once and all threads share its tape.
+     */
+    std::vector<double> jacobian(const std::vector<double>& x,
+                                 const FormulaReverseOptions& options = {}) const;
+
+private:
+    Formula(const detail::FormulaTape& tape, std::size_t num_inputs,
+            const std::vector<FormulaVar>& outputs);
+
+    static std::vector<FormulaVar> make_inputs(detail::FormulaTape& tape, std::size_t num_inputs);
+
+    std::size_t num_inputs_ = 0;
+    std::size_t num_registers_ = 0;
+    std::vector<detail::FormulaInstruction> code_;
+    std::vector<uint32_t> outputs_;  ///< Register holding each output
+
+    friend class FormulaTangents;
+    friend class FormulaAdjoints;
+    friend SparsityPattern sparsity_pattern(const Formula& formula);
+};
+
+namespace detail {
+struct FormulaTangentsState;
+struct FormulaAdjointsState;
+} // namespace detail
+
+/**
+ * @class FormulaTangents
+ * @brief Evaluates a formula at single points together with directional
+ *        derivatives along caller-supplied seed directions.
+ *
+ * This is forward-mode differentiation with `lanes` directions side by
+ * side: the tangents of a register are contiguous, so every instruction
+ * updates all directions in one loop. Registers are kept between calls, so
+ * repeated evaluation (e.g. the stages of an ODE step) does not allocate.
+ * The formula must outlive the evaluator.
+ */
+class FormulaTangents {
+public:
+    FormulaTangents(const Formula& formula, std::size_t lanes);
+    ~FormulaTangents();
+    FormulaTangents(FormulaTangents&&) noexcept;
+    FormulaTangents& operator=(FormulaTangents&&) noexcept;
+
+    std::size_t lanes() const noexcept { return lanes_; }
+
+    /**
+     * @brief Evaluate at one point.
+     * @param x Input values (formula.num_inputs())
+     * @param seeds Input tangents, row-major num_inputs() × lanes()
+     * @param y Receives the outputs (formula.num_outputs())
+     * @param tangents Receives the output tangents, row-major num_outputs() × lanes()
+     * @throws std::invalid_argument or std::runtime_error on domain errors, as evaluate()
+     */
+    void evaluate(const double* x, const double* seeds, double* y, double* tangents);
+
+private:
+    const Formula* formula_;
+    std::size_t lanes_;
+    std::unique_ptr<detail::FormulaTangentsState> state_;
+};
+
+/**
+ * @class FormulaAdjoints
+ * @brief Evaluates a formula at single points and pulls weighted outputs
+ *        back to the inputs (reverse mode).
+ *
+ * One sweep handles `lanes` output weightings side by side, giving
+ * `lanes` rows of the Jacobian (or vector-Jacobian products) at the cost of
+ * a few forward evaluations, independent of the number of inputs.
+ *
+ * With `options.checkpoints` = 0 the forward pass stores the partial
+ * derivatives of every instruction (two doubles each). Otherwise only that
+ * many snapshots of the register file are kept and instructions are
+ * recomputed during the sweep, following the binomial (revolve) schedule
+ * that minimizes recomputation for the given number of snapshots. The
+ * formula must outlive the evaluator.
+ */
+class FormulaAdjoints {
+public:
+    FormulaAdjoints(const Formula& formula, std::size_t lanes,
+                    const FormulaReverseOptions& options = {});
+    ~FormulaAdjoints();
+    FormulaAdjoints(FormulaAdjoints&&) noexcept;
+    FormulaAdjoints& operator=(FormulaAdjoints&&) noexcept;
+
+    std::size_t lanes() const noexcept { return lanes_; }
+
+    /**
+     * @brief Evaluate at one point and run the reverse sweep.
+     * @param x Input values (formula.num_inputs())
+     * @param weights Output adjoints, row-major num_outputs() × lanes()
+     * @param y Receives the outputs (formula.num_outputs())
+     * @param gradients Receives Σ_o weights(o, k) ∂y_o/∂x_i, row-major
+     *        num_inputs() × lanes()
+     * @throws std::invalid_argument or std::runtime_error on domain errors, as evaluate()
+     */
+    void evaluate(const double* x, const double* weights, double* y, double* gradients);
+
+private:
+    const Formula* formula_;
+    std::size_t lanes_;
+    std::unique_ptr<detail::FormulaAdjointsState> state_;
+
+    friend class Formula;
+};
+
+} // namespace uncertainties
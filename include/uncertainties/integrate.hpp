@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * @file integrate.hpp
+ * @brief Numerical integration of udouble samples and of integrands with
+ *        udouble parameters.
+ *
+ * Quadrature is linear in the integrand values, so the integral of sampled
+ * data is one weighted sum: the weights are computed once from the
+ * abscissae and the derivative maps of the samples are merged in a single
+ * pass, instead of building a udouble temporary per trapezoid.
+ *
+ * integrate() applies composite Gauss–Legendre quadrature to an integrand
+ * that captures udouble parameters. Panels are evaluated in parallel, each
+ * accumulating its weighted derivatives into its own map, and the limits
+ * may themselves be uncertain.
+ *
+ * Example usage:
+ * @code
+ * using namespace uncertainties;
+ * udouble k(2.0, 0.1), tau(5.0, 0.2);
+ * udouble area = integrate([&](double t) { return k * exp(-t / tau); }, 0.0, 10.0);
+ *
+ * std::vector<double> t = ...;       // sample times
+ * std::vector<udouble> flux = ...;   // measured flux
+ * udouble fluence = integrate_samples(t, flux, SampleRule::Simpson);
+ * @endcode
+ */
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Quadrature rule for sampled data
+enum class SampleRule {
+    Trapezoid,  ///< Composite trapezoid rule
+    Simpson     ///< Composite Simpson rule for non-uniform spacing
+};
+
+/// Options for integrate()
+struct IntegrationOptions {
+    std::size_t panels = 16;   ///< Equal-width panels over [a, b]
+    std::size_t order = 8;     ///< Gauss–Legendre points per panel
+    std::size_t threads = 0;   ///< Threads evaluating panels (0: hardware concurrency)
+};
+
+/**
+ * @brief Quadrature weights w such that ∫ y dx ≈ Σ w_i y_i.
+ * @param x Strictly increasing sample abscissae (at least two)
+ * @param rule Trapezoid or Simpson. Simpson with an odd number of intervals
+ *             integrates the last interval with the quadratic through the
+ *             last three samples; with two samples it falls back to the
+ *             trapezoid rule.
+ * @throws std::invalid_argument if x has fewer than two points or is not
+ *         strictly increasing
+ */
+std::vector<double> integration_weights(const std::vector<double>& x,
+                                        SampleRule rule = SampleRule::Trapezoid);
+
+/**
+ * @brief Σ w_i y_i with all derivative maps merged in one pass.
+ * @throws std::invalid_argument if the sizes differ
+ */
+udouble weighted_sum(const std::vector<double>& weights, const std::vector<udouble>& values);
+
+/**
+ * @brief Integrate sampled data.
+ * @throws std::invalid_argument if the sizes differ or x is invalid
+ */
+udouble integrate_samples(const std::vector<double>& x, const std::vector<udouble>& y,
+                          SampleRule rule = SampleRule::Trapezoid);
+
+/**
+ * @brief Integrate f over [a, b] with composite Gauss–Legendre quadrature.
+ *
+ * f may capture udouble parameters; the result is correlated with them.
+ * f is called concurrently from several threads unless options.threads is 1.
+ *
+ * @throws std::invalid_argument if panels or order is 0
+ */
+udouble integrate(const std::function<udouble(double)>& f, double a, double b,
+                  const IntegrationOptions& options = {});
+
+/**
+ * @brief Integrate f over uncertain limits.
+ *
+ * Besides the integrand's parameters, the result depends on the limits
+ * through ∂I/∂b = f(b) and ∂I/∂a = -f(a).
+ */
+udouble integrate(const std::function<udouble(double)>& f, const udouble& a, const udouble& b,
+                  const IntegrationOptions& options = {});
+
+namespace detail {
+
+/** @brief Gauss–Legendre nodes and weights on [-1, 1]. */
+void gauss_legendre(std::size_t order, std::vector<double>& nodes, std::vector<double>& weights);
+
+} // namespace detail
+
+} // namespace uncertainties
@@ -0,0 +1,121 @@
+#pragma once
+
+/**
+ * @file interpolate.hpp
+ * @brief Linear and cubic-spline interpolation of tables of udouble values.
+ *
+ * The table abscissae are exact and strictly increasing; the ordinates are
+ * udouble values, typically calibration points with their own atomics. The
+ * interpolators prepare their coefficients once, with derivatives relative
+ * to the table's atomics, so a query only locates its segment (O(log n))
+ * and merges the few derivative maps of that segment with the query's own.
+ *
+ * Example usage:
+ * @code
+ * std::vector<double> temperature = {0.0, 10.0, 20.0, 30.0};
+ * std::vector<uncertainties::udouble> resistance = ...;
+ * uncertainties::CubicSpline curve(temperature, resistance);
+ * uncertainties::udouble r = curve(udouble(14.2, 0.3));  // correlated with the table
+ * @endcode
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Behavior for queries outside [x.front(), x.back()]
+enum class Extrapolation {
+    Throw,   ///< Throw std::out_of_range
+    Clamp,   ///< Return the value at the nearest end of the table
+    Extend   ///< Continue the first or last segment
+};
+
+/**
+ * @class LinearInterpolator
+ * @brief Piecewise-linear interpolation of a udouble table.
+ */
+class LinearInterpolator {
+public:
+    /**
+     * @brief Construct from table abscissae and ordinates.
+     * @throws std::invalid_argument if there are fewer than two points, the
+     *         sizes differ, or x is not strictly increasing
+     */
+    LinearInterpolator(std::vector<double> x, std::vector<udouble> y,
+                       Extrapolation extrapolation = Extrapolation::Throw);
+
+    /** @brief Interpolate at an exact point. */
+    udouble operator()(double x) const;
+
+    /** @brief Interpolate at an uncertain point. */
+    udouble operator()(const udouble& x) const;
+
+    /**
+     * @brief Interpolate at many points.
+     *
+     * Points sorted by nominal value are located in one linear sweep;
+     * otherwise each point is located by binary search.
+     */
+    std::vector<udouble> operator()(const std::vector<udouble>& xs) const;
+
+    std::size_t size() const noexcept { return x_.size(); }
+    const std::vector<double>& x() const noexcept { return x_; }
+    const std::vector<udouble>& y() const noexcept { return y_; }
+
+private:
+    udouble evaluate(std::size_t segment, double x, const udouble* query) const;
+
+    std::vector<double> x_;
+    std::vector<udouble> y_;
+    Extrapolation extrapolation_;
+};
+
+/**
+ * @class CubicSpline
+ * @brief Natural cubic spline through a udouble table.
+ *
+ * The second derivatives M_j at the nodes solve a tridiagonal system that is
+ * linear in the ordinates, so each M_j is stored as a udouble correlated
+ * with the table. The influence of an ordinate on M_j decays geometrically
+ * with distance, and contributions below 1e-17 of the largest are dropped,
+ * which keeps every M_j's derivative map small on long tables.
+ */
+class CubicSpline {
+public:
+    /**
+     * @brief Construct from table abscissae and ordinates.
+     * @throws std::invalid_argument if there are fewer than two points, the
+     *         sizes differ, or x is not strictly increasing
+     */
+    CubicSpline(std::vector<double> x, std::vector<udouble> y,
+                Extrapolation extrapolation = Extrapolation::Throw);
+
+    /** @brief Interpolate at an exact point. */
+    udouble operator()(double x) const;
+
+    /** @brief Interpolate at an uncertain point. */
+    udouble operator()(const udouble& x) const;
+
+    /** @brief Interpolate at many points (linear sweep if sorted). */
+    std::vector<udouble> operator()(const std::vector<udouble>& xs) const;
+
+    std::size_t size() const noexcept { return x_.size(); }
+    const std::vector<double>& x() const noexcept { return x_; }
+    const std::vector<udouble>& y() const noexcept { return y_; }
+
+    /** @brief Second derivatives of the spline at the nodes. */
+    const std::vector<udouble>& second_derivatives() const noexcept { return m_; }
+
+private:
+    udouble evaluate(std::size_t segment, double x, const udouble* query) const;
+
+    std::vector<double> x_;
+    std::vector<udouble> y_;
+    std::vector<udouble> m_;
+    Extrapolation extrapolation_;
+};
+
+} // namespace uncertainties
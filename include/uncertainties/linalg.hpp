@@ -0,0 +1,370 @@
+#pragma once
+
+/**
+ * @file linalg.hpp
+ * @brief Matrix decompositions of udouble matrices by first-order perturbation theory.
+ *
+ * Running Eigen's iterative solvers on udouble scalars is slow, and the
+ * derivative maps then follow every Jacobi or QR sweep. The functions here
+ * decompose the nominal matrix once in double precision and attach the
+ * uncertainty with closed-form perturbation formulas:
+ *
+ *     dλ_k = v_kᵀ · dA · v_k      (symmetric eigenvalues)
+ *     dσ_k = u_kᵀ · dA · v_k      (singular values)
+ *
+ * All outputs are formed in one pass over the derivative maps of the
+ * entries of A, so every output is correlated with A and with each other.
+ *
+ * The Cholesky and QR factors are returned as udouble matrices. Their
+ * sensitivities are computed for all atomics of A at once: the ∂A/∂id
+ * blocks are stacked into one tall matrix, so each triangular solve of
+ *
+ *     dL = L · Φ(L⁻¹ · dA · L⁻ᵀ)          (Φ: lower triangle, halved diagonal)
+ *     dR = U · R,  dQ = dA · R⁻¹ − Q · U   (U = upper part of Qᵀ · dA · R⁻¹)
+ *
+ * is a single blocked call.
+ *
+ * For repeated eigenvalues or singular values only the sum over the cluster
+ * is differentiable; the individual values then depend on the basis the
+ * nominal decomposition picked.
+ *
+ * Example usage:
+ * @code
+ * #include <Eigen/Dense>
+ * #include "uncertainties/linalg.hpp"
+ *
+ * Eigen::Matrix<uncertainties::udouble, 2, 2> A;
+ * A << udouble(2.0, 0.1), udouble(1.0, 0.05),
+ *      udouble(1.0, 0.05), udouble(3.0, 0.1);
+ * auto lambda = uncertainties::eigenvalues(A);     // ascending
+ * auto sigma = uncertainties::singular_values(A);  // descending
+ * auto L = uncertainties::cholesky(A);              // A = L Lᵀ
+ * @endcode
+ *
+ * @note Requires Eigen.
+ */
+
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "uncertainties/eigen_support.hpp"
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Column vector of udouble values
+using VectorXu = Eigen::Matrix<udouble, Eigen::Dynamic, 1>;
+
+/// Dynamic matrix of udouble values
+using MatrixXu = Eigen::Matrix<udouble, Eigen::Dynamic, Eigen::Dynamic>;
+
+/// Eigendecomposition of a symmetric udouble matrix
+struct SymmetricEigenResult {
+    VectorXu eigenvalues;          ///< Ascending, correlated with A
+    Eigen::MatrixXd eigenvectors;  ///< Nominal eigenvectors, one per column
+};
+
+/// Singular value decomposition of a udouble matrix
+struct SvdResult {
+    VectorXu singular_values;  ///< Descending, correlated with A
+    Eigen::MatrixXd U;         ///< Nominal left singular vectors (thin)
+    Eigen::MatrixXd V;         ///< Nominal right singular vectors (thin)
+};
+
+/// Thin QR factorization of a udouble matrix
+struct QrResult {
+    MatrixXu Q;  ///< m × n with orthonormal columns
+    MatrixXu R;  ///< n × n upper triangular with positive diagonal
+};
+
+namespace detail {
+
+template <typename Derived>
+Eigen::MatrixXd nominal_matrix(const Eigen::MatrixBase<Derived>& A) {
+    Eigen::MatrixXd N(A.rows(), A.cols());
+    for (Eigen::Index j = 0; j < A.cols(); ++j) {
+        for (Eigen::Index i = 0; i < A.rows(); ++i) {
+            N(i, j) = A.derived().coeff(i, j).nominal_value();
+        }
+    }
+    return N;
+}
+
+/**
+ * @brief out_k = nominals_k + Σ_ij weight(i, j, k) ∂A_ij for every output k.
+ *
+ * Each derivative map of A is visited once and scattered into all outputs.
+ */
+template <typename Derived, typename Weight>
+VectorXu contract_entries(const Eigen::MatrixBase<Derived>& A, const Eigen::VectorXd& nominals,
+                          Weight&& weight) {
+    const Eigen::Index outputs = nominals.size();
+    std::vector<udouble::DerivativeMap> derivatives(static_cast<std::size_t>(outputs));
+    for (Eigen::Index j = 0; j < A.cols(); ++j) {
+        for (Eigen::Index i = 0; i < A.rows(); ++i) {
+            const udouble& a = A.derived().coeff(i, j);
+            if (a.num_variables() == 0) {
+                continue;
+            }
+            const auto& entry = a.derivatives();
+            for (Eigen::Index k = 0; k < outputs; ++k) {
+                double w = weight(i, j, k);
+                if (w == 0.0) {
+                    continue;
+                }
+                auto& out = derivatives[static_cast<std::size_t>(k)];
+                for (const auto& [id, deriv] : entry) {
+                    out[id] += w * deriv;
+                }
+            }
+        }
+    }
+    VectorXu result(outputs);
+    for (Eigen::Index k = 0; k < outputs; ++k) {
+        result(k) = udouble::from_derivatives(nominals(k),
+                                              std::move(derivatives[static_cast<std::size_t>(k)]));
+    }
+    return result;
+}
+
+/// Distinct atomics of a matrix and ∂A/∂id for each of them
+struct StackedDerivatives {
+    std::vector<uint64_t> ids;
+    Eigen::MatrixXd blocks;  ///< Block m = rows [m·r, (m+1)·r) holds ∂A/∂ids[m]
+};
+
+/**
+ * @brief Collect ∂A/∂id for every atomic of A into vertically stacked blocks.
+ * @param lower_symmetric Read only the lower triangle and mirror it
+ */
+template <typename Derived>
+StackedDerivatives stack_derivatives(const Eigen::MatrixBase<Derived>& A, bool lower_symmetric) {
+    const Eigen::Index r = A.rows();
+    const Eigen::Index c = A.cols();
+    auto read = [&](Eigen::Index i, Eigen::Index j) -> bool {
+        return !lower_symmetric || i >= j;
+    };
+    StackedDerivatives stacked;
+    std::unordered_map<uint64_t, Eigen::Index> index;
+    for (Eigen::Index j = 0; j < c; ++j) {
+        for (Eigen::Index i = 0; i < r; ++i) {
+            const udouble& a = A.derived().coeff(i, j);
+            if (!read(i, j) || a.num_variables() == 0) {
+                continue;
+            }
+            for (const auto& entry : a.derivatives()) {
+                if (index.emplace(entry.first, static_cast<Eigen::Index>(stacked.ids.size())).second) {
+                    stacked.ids.push_back(entry.first);
+                }
+            }
+        }
+    }
+    stacked.blocks = Eigen::MatrixXd::Zero(r * static_cast<Eigen::Index>(stacked.ids.size()), c);
+    for (Eigen::Index j = 0; j < c; ++j) {
+        for (Eigen::Index i = 0; i < r; ++i) {
+            const udouble& a = A.derived().coeff(i, j);
+            if (!read(i, j) || a.num_variables() == 0) {
+                continue;
+            }
+            for (const auto& [id, deriv] : a.derivatives()) {
+                Eigen::Index m = index.at(id);
+                stacked.blocks(m * r + i, j) = deriv;
+                if (lower_symmetric) {
+                    stacked.blocks(m * r + j, i) = deriv;
+                }
+            }
+        }
+    }
+    return stacked;
+}
+
+/** @brief udouble matrix from nominal values and stacked derivative blocks. */
+inline MatrixXu from_blocks(const Eigen::MatrixXd& nominal, const std::vector<uint64_t>& ids,
+                            const Eigen::MatrixXd& blocks) {
+    const Eigen::Index r = nominal.rows();
+    MatrixXu result(r, nominal.cols());
+    for (Eigen::Index j = 0; j < nominal.cols(); ++j) {
+        for (Eigen::Index i = 0; i < r; ++i) {
+            udouble::DerivativeMap derivatives;
+            for (std::size_t m = 0; m < ids.size(); ++m) {
+                double d = blocks(static_cast<Eigen::Index>(m) * r + i, j);
+                if (d != 0.0) {
+                    derivatives.emplace(ids[m], d);
+                }
+            }
+            result(i, j) = udouble::from_derivatives(nominal(i, j), std::move(derivatives));
+        }
+    }
+    return result;
+}
+
+} // namespace detail
+
+/**
+ * @brief Eigenvalues and nominal eigenvectors of a symmetric matrix.
+ * @throws std::invalid_argument if A is not square or its nominal part is not symmetric
+ * @throws std::runtime_error if the nominal eigensolver does not converge
+ */
+template <typename Derived>
+SymmetricEigenResult symmetric_eigen(const Eigen::MatrixBase<Derived>& A) {
+    if (A.rows() != A.cols()) {
+        throw std::invalid_argument("symmetric_eigen: the matrix must be square.");
+    }
+    Eigen::MatrixXd N = detail::nominal_matrix(A);
+    double scale = N.size() == 0 ? 0.0 : N.cwiseAbs().maxCoeff();
+    if (N.size() > 0 && (N - N.transpose()).cwiseAbs().maxCoeff() >
+                            64.0 * std::numeric_limits<double>::epsilon() * std::max(1.0, scale)) {
+        throw std::invalid_argument("symmetric_eigen: the matrix must be symmetric.");
+    }
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(N);
+    if (solver.info() != Eigen::Success) {
+        throw std::runtime_error("symmetric_eigen: the eigensolver did not converge.");
+    }
+    const Eigen::MatrixXd& V = solver.eigenvectors();
+    SymmetricEigenResult result;
+    result.eigenvalues = detail::contract_entries(A, solver.eigenvalues(),
+        [&](Eigen::Index i, Eigen::Index j, Eigen::Index k) { return V(i, k) * V(j, k); });
+    result.eigenvectors = V;
+    return result;
+}
+
+/**
+ * @brief Eigenvalues of a symmetric matrix, in ascending order.
+ * @throws std::invalid_argument if A is not square or its nominal part is not symmetric
+ */
+template <typename Derived>
+VectorXu eigenvalues(const Eigen::MatrixBase<Derived>& A) {
+    return symmetric_eigen(A).eigenvalues;
+}
+
+/**
+ * @brief Singular values and nominal singular vectors of any matrix.
+ */
+template <typename Derived>
+SvdResult svd(const Eigen::MatrixBase<Derived>& A) {
+    Eigen::MatrixXd N = detail::nominal_matrix(A);
+    Eigen::JacobiSVD<Eigen::MatrixXd> solver(N, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    SvdResult result;
+    result.U = solver.matrixU();
+    result.V = solver.matrixV();
+    const Eigen::MatrixXd& U = result.U;
+    const Eigen::MatrixXd& V = result.V;
+    result.singular_values = detail::contract_entries(A, solver.singularValues(),
+        [&](Eigen::Index i, Eigen::Index j, Eigen::Index k) { return U(i, k) * V(j, k); });
+    return result;
+}
+
+/**
+ * @brief Singular values of any matrix, in descending order.
+ */
+template <typename Derived>
+VectorXu singular_values(const Eigen::MatrixBase<Derived>& A) {
+    return svd(A).singular_values;
+}
+
+/**
+ * @brief Cholesky factor L of a symmetric positive definite matrix, A = L Lᵀ.
+ *
+ * Only the lower triangle of A is read, as by Eigen::LLT.
+ * @throws std::invalid_argument if A is not square
+ * @throws std::runtime_error if the nominal matrix is not positive definite
+ */
+template <typename Derived>
+MatrixXu cholesky(const Eigen::MatrixBase<Derived>& A) {
+    if (A.rows() != A.cols()) {
+        throw std::invalid_argument("cholesky: the matrix must be square.");
+    }
+    const Eigen::Index n = A.rows();
+    Eigen::LLT<Eigen::MatrixXd> llt(detail::nominal_matrix(A));
+    if (llt.info() != Eigen::Success) {
+        throw std::runtime_error("cholesky: the matrix is not positive definite.");
+    }
+    const Eigen::MatrixXd L = llt.matrixL();
+
+    detail::StackedDerivatives stacked = detail::stack_derivatives(A, true);
+    Eigen::MatrixXd& D = stacked.blocks;
+    const Eigen::Index count = static_cast<Eigen::Index>(stacked.ids.size());
+    // Blocks become dA L⁻ᵀ, then (L⁻¹ dA L⁻ᵀ)ᵀ = L⁻¹ dA L⁻ᵀ by symmetry
+    L.transpose().triangularView<Eigen::Upper>().solveInPlace<Eigen::OnTheRight>(D);
+    for (Eigen::Index m = 0; m < count; ++m) {
+        D.block(m * n, 0, n, n).transposeInPlace();
+    }
+    L.transpose().triangularView<Eigen::Upper>().solveInPlace<Eigen::OnTheRight>(D);
+
+    Eigen::MatrixXd phi(n, n);
+    for (Eigen::Index m = 0; m < count; ++m) {
+        auto block = D.block(m * n, 0, n, n);
+        phi = block.triangularView<Eigen::Lower>();
+        phi.diagonal() *= 0.5;
+        block.noalias() = L * phi.triangularView<Eigen::Lower>();
+    }
+    return detail::from_blocks(L, stacked.ids, D);
+}
+
+/**
+ * @brief Thin QR factorization A = Q R of a matrix with full column rank.
+ *
+ * R has a positive diagonal, which makes the factorization unique and
+ * differentiable.
+ * @throws std::invalid_argument if A has fewer rows than columns
+ * @throws std::runtime_error if the nominal matrix is rank deficient
+ */
+template <typename Derived>
+QrResult qr(const Eigen::MatrixBase<Derived>& A) {
+    const Eigen::Index rows = A.rows();
+    const Eigen::Index n = A.cols();
+    if (rows < n) {
+        throw std::invalid_argument("qr: the matrix must have at least as many rows as columns.");
+    }
+    Eigen::HouseholderQR<Eigen::MatrixXd> householder(detail::nominal_matrix(A));
+    Eigen::MatrixXd Q = householder.householderQ() * Eigen::MatrixXd::Identity(rows, n);
+    Eigen::MatrixXd R = householder.matrixQR().topRows(n).triangularView<Eigen::Upper>();
+    const double tiny = std::numeric_limits<double>::epsilon() *
+                        (R.size() == 0 ? 0.0 : R.cwiseAbs().maxCoeff()) * static_cast<double>(rows);
+    for (Eigen::Index i = 0; i < n; ++i) {
+        if (std::abs(R(i, i)) <= tiny) {
+            throw std::runtime_error("qr: the matrix is rank deficient.");
+        }
+        if (R(i, i) < 0.0) {
+            R.row(i) *= -1.0;
+            Q.col(i) *= -1.0;
+        }
+    }
+
+    detail::StackedDerivatives stacked = detail::stack_derivatives(A, false);
+    Eigen::MatrixXd& D = stacked.blocks;
+    const Eigen::Index count = static_cast<Eigen::Index>(stacked.ids.size());
+    // Blocks become B = dA R⁻¹
+    R.triangularView<Eigen::Upper>().solveInPlace<Eigen::OnTheRight>(D);
+
+    Eigen::MatrixXd dR(n * count, n);
+    Eigen::MatrixXd X(n, n);
+    for (Eigen::Index m = 0; m < count; ++m) {
+        auto B = D.block(m * rows, 0, rows, n);
+        X.noalias() = Q.transpose() * B;
+        // U = X - Ω with Ω the skew-symmetric part built from the strict lower triangle
+        for (Eigen::Index j = 0; j < n; ++j) {
+            for (Eigen::Index i = j + 1; i < n; ++i) {
+                X(j, i) += X(i, j);
+                X(i, j) = 0.0;
+            }
+        }
+        dR.block(m * n, 0, n, n).noalias() = X.triangularView<Eigen::Upper>() * R;
+        B.noalias() -= Q * X.triangularView<Eigen::Upper>();
+    }
+    QrResult result;
+    result.Q = detail::from_blocks(Q, stacked.ids, D);
+    result.R = detail::from_blocks(R, stacked.ids, dR);
+    return result;
+}
+
+} // namespace uncertainties
@@ -0,0 +1,292 @@
+#pragma once
+
+/**
+ * @file matrix_functions.hpp
+ * @brief Matrix exponential, logarithm and square root of udouble matrices.
+ *
+ * Evaluating a matrix function in udouble arithmetic is very slow. Here the
+ * nominal value f(A) is computed once in double. Each atomic that A depends
+ * on then contributes the Fréchet derivative L_f(A, ∂A/∂id). The work that
+ * does not depend on the direction is done once and shared by every atomic:
+ *
+ * - expm: Padé-13 scaling and squaring with the Al-Mohy–Higham derivative
+ *   recurrences. The powers of A, the LU factors of the Padé denominator and
+ *   the squarings are shared.
+ * - sqrtm: the Schur form A = U T Uᴴ and R = √T are shared. Each direction
+ *   solves the triangular Sylvester equation R Y + Y R = Uᴴ E U.
+ * - logm: inverse scaling and squaring in the Schur basis. The chain of
+ *   square roots and the Gauss–Legendre form of the Padé approximant of
+ *   log(I + Y) are shared. Each direction runs the same chain of Sylvester
+ *   solves.
+ *
+ * The atomics are split across threads. Results are udouble matrices
+ * correlated with the entries of A.
+ *
+ * Example usage:
+ * @code
+ * #include <Eigen/Dense>
+ * #include "uncertainties/matrix_functions.hpp"
+ *
+ * uncertainties::MatrixXu Q(2, 2);  // rate matrix
+ * Q << udouble(-0.3, 0.02), udouble(0.3, 0.02),
+ *      udouble(0.1, 0.01), udouble(-0.1, 0.01);
+ * uncertainties::MatrixXu P = uncertainties::expm(Q * udouble(2.0));  // transition probabilities
+ * @endcode
+ *
+ * @note Requires Eigen.
+ */
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "uncertainties/integrate.hpp"
+#include "uncertainties/linalg.hpp"
+#include "uncertainties/parallel.hpp"
+
+namespace uncertainties {
+
+/// Options for the matrix functions
+struct MatrixFunctionOptions {
+    std::size_t threads = 0;  ///< Threads used across atomics (0: hardware concurrency)
+};
+
+namespace detail {
+
+/**
+ * @brief exp(A) and, in place, L_exp(A, E) for every stacked block E.
+ *
+ * Scaling and squaring with the [13/13] Padé approximant (Higham 2005) and
+ * its Fréchet derivative (Al-Mohy and Higham 2009).
+ */
+inline Eigen::MatrixXd expm_frechet(const Eigen::MatrixXd& A0, Eigen::MatrixXd& blocks, std::size_t threads) {
+    static constexpr double b[] = {64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+                                   1187353796428800.0, 129060195264000.0, 10559470521600.0,
+                                   670442572800.0, 33522128640.0, 1323241920.0, 40840800.0,
+                                   960960.0, 16380.0, 182.0, 1.0};
+    constexpr double theta13 = 5.371920351148152;
+    const Eigen::Index n = A0.rows();
+    if (n == 0) {
+        return A0;
+    }
+    const double norm = A0.cwiseAbs().colwise().sum().maxCoeff();
+    const int s = norm > theta13 ? static_cast<int>(std::ceil(std::log2(norm / theta13))) : 0;
+    const double scale = std::ldexp(1.0, -s);
+
+    const Eigen::MatrixXd I = Eigen::MatrixXd::Identity(n, n);
+    const Eigen::MatrixXd A = A0 * scale;
+    const Eigen::MatrixXd A2 = A * A;
+    const Eigen::MatrixXd A4 = A2 * A2;
+    const Eigen::MatrixXd A6 = A4 * A2;
+    const Eigen::MatrixXd W1 = b[13] * A6 + b[11] * A4 + b[9] * A2;
+    const Eigen::MatrixXd W2 = b[7] * A6 + b[5] * A4 + b[3] * A2 + b[1] * I;
+    const Eigen::MatrixXd Z1 = b[12] * A6 + b[10] * A4 + b[8] * A2;
+    const Eigen::MatrixXd Z2 = b[6] * A6 + b[4] * A4 + b[2] * A2 + b[0] * I;
+    const Eigen::MatrixXd W = A6 * W1 + W2;
+    const Eigen::MatrixXd U = A * W;
+    const Eigen::MatrixXd V = A6 * Z1 + Z2;
+    const Eigen::PartialPivLU<Eigen::MatrixXd> denominator(V - U);
+
+    std::vector<Eigen::MatrixXd> squares(static_cast<std::size_t>(s) + 1);
+    squares[0] = denominator.solve(V + U);
+    for (int k = 0; k < s; ++k) {
+        squares[k + 1] = squares[k] * squares[k];
+    }
+
+    const std::size_t count = static_cast<std::size_t>(blocks.rows() / n);
+    threads = resolve_thread_count(threads, count);
+    parallel_for(count, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        Eigen::MatrixXd E, M2, M4, M6, Lw, Lu, Lv, L;
+        for (std::size_t m = begin; m < end; ++m) {
+            auto block = blocks.block(static_cast<Eigen::Index>(m) * n, 0, n, n);
+            E = block * scale;
+            M2.noalias() = A * E;
+            M2.noalias() += E * A;
+            M4.noalias() = A2 * M2;
+            M4.noalias() += M2 * A2;
+            M6.noalias() = A4 * M2;
+            M6.noalias() += M4 * A2;
+            Lw.noalias() = A6 * (b[13] * M6 + b[11] * M4 + b[9] * M2);
+            Lw.noalias() += M6 * W1;
+            Lw += b[7] * M6 + b[5] * M4 + b[3] * M2;
+            Lu.noalias() = A * Lw;
+            Lu.noalias() += E * W;
+            Lv.noalias() = A6 * (b[12] * M6 + b[10] * M4 + b[8] * M2);
+            Lv.noalias() += M6 * Z1;
+            Lv += b[6] * M6 + b[4] * M4 + b[2] * M2;
+            L = denominator.solve(Lu + Lv + (Lu - Lv) * squares[0]);
+            for (int k = 0; k < s; ++k) {
+                L = squares[k] * L + L * squares[k];
+            }
+            block = L;
+        }
+    });
+    return squares[static_cast<std::size_t>(s)];
+}
+
+/** @brief Complex Schur form A = U T Uᴴ, checking for a real principal branch. */
+inline Eigen::ComplexSchur<Eigen::MatrixXd> principal_schur(const Eigen::MatrixXd& A, const char* name) {
+    Eigen::ComplexSchur<Eigen::MatrixXd> schur(A);
+    if (schur.info() != Eigen::Success) {
+        throw std::runtime_error(std::string(name) + ": the Schur decomposition did not converge.");
+    }
+    const Eigen::MatrixXcd& T = schur.matrixT();
+    for (Eigen::Index i = 0; i < T.rows(); ++i) {
+        std::complex<double> lambda = T(i, i);
+        if (std::abs(lambda.imag()) <= 1e-14 * std::abs(lambda) && lambda.real() <= 0.0) {
+            throw std::invalid_argument(std::string(name) +
+                                        ": the matrix has an eigenvalue on the closed negative real "
+                                        "axis and no real principal value.");
+        }
+    }
+    return schur;
+}
+
+/** @brief Principal square root of an upper triangular matrix (Björck–Hammarling). */
+inline Eigen::MatrixXcd triangular_sqrt(const Eigen::MatrixXcd& T) {
+    const Eigen::Index n = T.rows();
+    Eigen::MatrixXcd R = Eigen::MatrixXcd::Zero(n, n);
+    for (Eigen::Index j = 0; j < n; ++j) {
+        R(j, j) = std::sqrt(T(j, j));
+        for (Eigen::Index i = j - 1; i >= 0; --i) {
+            std::complex<double> sum = T(i, j);
+            for (Eigen::Index k = i + 1; k < j; ++k) {
+                sum -= R(i, k) * R(k, j);
+            }
+            R(i, j) = sum / (R(i, i) + R(j, j));
+        }
+    }
+    return R;
+}
+
+/** @brief Solve R Y + Y R = F in place for upper triangular R, column by column. */
+inline void triangular_sylvester(const Eigen::MatrixXcd& R, Eigen::MatrixXcd& F) {
+    const Eigen::Index n = R.rows();
+    Eigen::MatrixXcd shifted = R;
+    for (Eigen::Index j = 0; j < n; ++j) {
+        // (R + R_jj I) y_j = f_j − Σ_{k<j} R_kj y_k
+        for (Eigen::Index k = 0; k < j; ++k) {
+            F.col(j) -= R(k, j) * F.col(k);
+        }
+        shifted.diagonal() = R.diagonal().array() + R(j, j);
+        shifted.triangularView<Eigen::Upper>().solveInPlace(F.col(j));
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Matrix exponential.
+ * @throws std::invalid_argument if A is not square
+ */
+template <typename Derived>
+MatrixXu expm(const Eigen::MatrixBase<Derived>& A, const MatrixFunctionOptions& options = {}) {
+    if (A.rows() != A.cols()) {
+        throw std::invalid_argument("expm: the matrix must be square.");
+    }
+    detail::StackedDerivatives stacked = detail::stack_derivatives(A, false);
+    Eigen::MatrixXd F = detail::expm_frechet(detail::nominal_matrix(A), stacked.blocks, options.threads);
+    return detail::from_blocks(F, stacked.ids, stacked.blocks);
+}
+
+/**
+ * @brief Principal matrix square root.
+ * @throws std::invalid_argument if A is not square or has an eigenvalue on
+ *         the closed negative real axis
+ */
+template <typename Derived>
+MatrixXu sqrtm(const Eigen::MatrixBase<Derived>& A, const MatrixFunctionOptions& options = {}) {
+    if (A.rows() != A.cols()) {
+        throw std::invalid_argument("sqrtm: the matrix must be square.");
+    }
+    const Eigen::Index n = A.rows();
+    auto schur = detail::principal_schur(detail::nominal_matrix(A), "sqrtm");
+    const Eigen::MatrixXcd& U = schur.matrixU();
+    const Eigen::MatrixXcd R = detail::triangular_sqrt(schur.matrixT());
+    Eigen::MatrixXd X = (U * R * U.adjoint()).real();
+
+    detail::StackedDerivatives stacked = detail::stack_derivatives(A, false);
+    const std::size_t count = stacked.ids.size();
+    std::size_t threads = detail::resolve_thread_count(options.threads, count);
+    detail::parallel_for(count, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        Eigen::MatrixXcd F;
+        for (std::size_t m = begin; m < end; ++m) {
+            auto block = stacked.blocks.block(static_cast<Eigen::Index>(m) * n, 0, n, n);
+            F = U.adjoint() * block.template cast<std::complex<double>>() * U;
+            detail::triangular_sylvester(R, F);
+            block = (U * F * U.adjoint()).real();
+        }
+    });
+    return detail::from_blocks(X, stacked.ids, stacked.blocks);
+}
+
+/**
+ * @brief Principal matrix logarithm.
+ * @throws std::invalid_argument if A is not square or has an eigenvalue on
+ *         the closed negative real axis
+ */
+template <typename Derived>
+MatrixXu logm(const Eigen::MatrixBase<Derived>& A, const MatrixFunctionOptions& options = {}) {
+    if (A.rows() != A.cols()) {
+        throw std::invalid_argument("logm: the matrix must be square.");
+    }
+    const Eigen::Index n = A.rows();
+    auto schur = detail::principal_schur(detail::nominal_matrix(A), "logm");
+    const Eigen::MatrixXcd& U = schur.matrixU();
+    const Eigen::MatrixXcd I = Eigen::MatrixXcd::Identity(n, n);
+
+    // Square roots until T^(1/2^k) is close enough to I for the Padé approximant
+    std::vector<Eigen::MatrixXcd> roots;
+    Eigen::MatrixXcd R = schur.matrixT();
+    while (n > 0 && (R - I).cwiseAbs().colwise().sum().maxCoeff() > 0.25) {
+        if (roots.size() >= 64) {
+            throw std::runtime_error("logm: inverse scaling did not converge.");
+        }
+        R = detail::triangular_sqrt(R);
+        roots.push_back(R);
+    }
+    const double factor = std::ldexp(1.0, static_cast<int>(roots.size()));
+
+    // log(I + Y) = ∫₀¹ Y (I + tY)⁻¹ dt with Gauss–Legendre nodes, the [8/8] Padé approximant
+    const Eigen::MatrixXcd Y = R - I;
+    std::vector<double> nodes;
+    std::vector<double> weights;
+    detail::gauss_legendre(8, nodes, weights);
+    std::vector<Eigen::MatrixXcd> inverses;
+    Eigen::MatrixXcd log_T = Eigen::MatrixXcd::Zero(n, n);
+    for (std::size_t j = 0; j < nodes.size(); ++j) {
+        double t = 0.5 * (nodes[j] + 1.0);
+        weights[j] *= 0.5 * factor;
+        Eigen::MatrixXcd shifted = I + t * Y;
+        inverses.push_back(shifted.triangularView<Eigen::Upper>().solve(I));
+        log_T += weights[j] * (Y * inverses.back());
+    }
+    Eigen::MatrixXd X = (U * log_T * U.adjoint()).real();
+
+    detail::StackedDerivatives stacked = detail::stack_derivatives(A, false);
+    const std::size_t count = stacked.ids.size();
+    std::size_t threads = detail::resolve_thread_count(options.threads, count);
+    detail::parallel_for(count, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        Eigen::MatrixXcd F, L;
+        for (std::size_t m = begin; m < end; ++m) {
+            auto block = stacked.blocks.block(static_cast<Eigen::Index>(m) * n, 0, n, n);
+            F = U.adjoint() * block.template cast<std::complex<double>>() * U;
+            for (const auto& root : roots) {
+                detail::triangular_sylvester(root, F);
+            }
+            // d[Y (I + tY)⁻¹] = (I + tY)⁻¹ dY (I + tY)⁻¹
+            L.setZero(n, n);
+            for (std::size_t j = 0; j < inverses.size(); ++j) {
+                L += weights[j] * (inverses[j] * F * inverses[j]);
+            }
+            block = (U * L * U.adjoint()).real();
+        }
+    });
+    return detail::from_blocks(X, stacked.ids, stacked.blocks);
+}
+
+} // namespace uncertainties
@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * @file parallel.hpp
+ * @brief Minimal fork-join helper used by the batch evaluators.
+ *
+ * Work is split into contiguous ranges, one per thread; the calling thread
+ * processes the first range itself. The first exception thrown by any range
+ * is rethrown in the caller after all threads have joined.
+ *
+ * Worker threads run under the caller's DerivativeBudget, and their budget
+ * counters are added to the caller's, so results do not depend on the
+ * thread count. A budget callback may then be called from several threads.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "uncertainties/derivative_budget.hpp"
+
+namespace uncertainties {
+namespace detail {
+
+/**
+ * @brief Number of threads to use for `work` items.
+ * @param requested Requested thread count (0: hardware concurrency)
+ * @param work Number of independent work items
+ * @param min_per_thread Minimum number of items worth a thread
+ */
+inline std::size_t resolve_thread_count(std::size_t requested, std::size_t work,
+                                        std::size_t min_per_thread = 1) {
+    std::size_t threads = requested;
+    if (threads == 0) {
+        threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    std::size_t useful = std::max<std::size_t>(1, work / std::max<std::size_t>(1, min_per_thread));
+    return std::max<std::size_t>(1, std::min(threads, useful));
+}
+
+/**
+ * @brief Run `body(begin, end, thread_index)` over [0, count) on `threads` threads.
+ *
+ * Ranges are contiguous and as equal as possible. With one thread the body
+ * runs inline without spawning anything.
+ */
+template <typename Body>
+void parallel_for(std::size_t count, std::size_t threads, Body&& body) {
+    threads = std::max<std::size_t>(1, std::min(threads, count));
+    if (threads <= 1) {
+        if (count > 0) {
+            body(std::size_t{0}, count, std::size_t{0});
+        }
+        return;
+    }
+
+    // Copied: the caller may change its budget while the workers start
+    const DerivativeBudget budget = derivative_budget();
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<DerivativeBudgetStats> stats(threads);
+    auto run = [&](std::size_t t) {
+        std::size_t begin = count * t / threads;
+        std::size_t end = count * (t + 1) / threads;
+        try {
+            body(begin, end, t);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    auto run_worker = [&](std::size_t t) {
+        ScopedDerivativeBudget scope(budget);
+        run(t);
+        stats[t] = derivative_budget_stats();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(run_worker, t);
+    }
+    run(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (std::size_t t = 1; t < threads; ++t) {
+        merge_derivative_budget_stats(stats[t]);
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+} // namespace detail
+} // namespace uncertainties
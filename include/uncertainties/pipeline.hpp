@@ -0,0 +1,417 @@
+#pragma once
+
+/**
+ * @file pipeline.hpp
+ * @brief Concurrent pipeline stages for streams of uncertain data.
+ *
+ * An ingest job typically parses measurements, turns them into udouble
+ * values, applies umath transforms and formats reports. Run one after the
+ * other, every stage waits for the slowest I/O. A Pipeline runs each stage
+ * as a task on a shared ThreadPool and connects neighbouring stages with a
+ * BoundedQueue: a stage blocks when its output queue is full, so a slow
+ * consumer throttles its producers (backpressure) and memory stays bounded
+ * by the queue capacities, while I/O and compute of different stages
+ * overlap.
+ *
+ * Stages pass batches rather than single values, so queue traffic is
+ * amortized and batch kernels such as register_batch() or
+ * Formula::evaluate() can be used inside a stage. If a stage throws, the
+ * queues around it are closed, the other stages wind down, and wait()
+ * rethrows the first exception.
+ *
+ * This is the C++17 form of what coroutine-based pipelines do with
+ * co_await: a stage that would suspend blocks its pool thread instead, so
+ * every stage claims a pool thread of its own (ThreadPool::reserve_worker())
+ * for as long as it runs, counted across all pipelines sharing the pool.
+ *
+ * Example usage:
+ * @code
+ * using namespace uncertainties;
+ * ThreadPool pool(4);
+ * Pipeline pipeline(pool);
+ * pipeline.source([&]() -> std::optional<Readings> { return read_chunk(file); })
+ *         .then([](Readings r) { return register_batch(r.value, r.sigma); })
+ *         .then([](std::vector<udouble> x) { for (auto& v : x) v = log(v); return x; })
+ *         .sink([&](std::vector<udouble> x) { write_report(out, x); });
+ * pipeline.wait();
+ * @endcode
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/**
+ * @class BoundedQueue
+ * @brief Blocking multi-producer, multi-consumer FIFO with a fixed capacity.
+ *
+ * push() blocks while the queue is full and pop() while it is empty. After
+ * close(), pushes fail and pops drain the remaining items.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief Queue holding at most `capacity` items.
+     * @throws std::invalid_argument if capacity is zero
+     */
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("BoundedQueue capacity must be positive.");
+        }
+    }
+
+    /**
+     * @brief Append an item, waiting for space.
+     * @return false if the queue was closed (the item is dropped)
+     */
+    bool push(T item) {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item, waiting for one.
+     * @return The item, or std::nullopt once the queue is closed and empty
+     */
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return item;
+    }
+
+    /** @brief Refuse further pushes and wake all waiters. */
+    void close() {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    bool closed() const {
+        std::lock_guard lock(mutex_);
+        return closed_;
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return items_.size();
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+private:
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads running submitted tasks in FIFO order.
+ *
+ * The destructor runs the tasks already submitted, then joins the workers.
+ */
+class ThreadPool {
+public:
+    /** @brief Pool with `threads` workers (0: hardware concurrency). */
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    /**
+     * @brief Claim a worker for a task that blocks until other tasks progress.
+     * @return false if every worker is already claimed
+     *
+     * Such tasks, e.g. pipeline stages, only make progress while each has a
+     * worker of its own. Claims are counted for the whole pool, whoever
+     * makes them; give the worker back with release_worker() once the task
+     * has finished.
+     */
+    bool reserve_worker();
+
+    /** @brief Return a worker claimed with reserve_worker(). */
+    void release_worker();
+
+    /**
+     * @brief Run `task` on a worker.
+     * @return Future holding the task's result or exception
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        std::future<R> result = packaged->get_future();
+        enqueue([packaged] { (*packaged)(); });
+        return result;
+    }
+
+private:
+    void enqueue(std::function<void()> task);
+    void work();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    std::size_t reserved_ = 0;  ///< Workers claimed by reserve_worker()
+    bool stopping_ = false;
+};
+
+/// Options for Pipeline
+struct PipelineOptions {
+    std::size_t queue_capacity = 4;  ///< Batches buffered between neighbouring stages
+};
+
+class Pipeline;
+
+/**
+ * @class PipelineStage
+ * @brief Output of a pipeline stage, to be consumed by the next stage.
+ */
+template <typename T>
+class PipelineStage {
+public:
+    /**
+     * @brief Add a stage applying `f` to every item.
+     * @return The new stage, producing `f`'s results
+     */
+    template <typename F>
+    auto then(F&& f) -> PipelineStage<std::invoke_result_t<std::decay_t<F>, T>>;
+
+    /** @brief Add the final stage, calling `f` on every item. */
+    template <typename F>
+    void sink(F&& f);
+
+private:
+    PipelineStage(Pipeline& pipeline, std::shared_ptr<BoundedQueue<T>> output)
+        : pipeline_(&pipeline), output_(std::move(output)) {}
+
+    Pipeline* pipeline_;
+    std::shared_ptr<BoundedQueue<T>> output_;
+
+    friend class Pipeline;
+    template <typename> friend class PipelineStage;
+};
+
+/**
+ * @class Pipeline
+ * @brief Chain of stages running concurrently on a thread pool.
+ *
+ * Each stage starts as soon as it is added. The pool must have a thread
+ * for every stage of the pipelines running on it at the same time; adding
+ * a stage when all threads are claimed throws. A stage whose output has no
+ * consumer when wait() is called has its output discarded.
+ */
+class Pipeline {
+public:
+    explicit Pipeline(ThreadPool& pool, const PipelineOptions& options = {})
+        : pool_(pool), options_(options) {}
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /** @brief Waits for the stages, discarding any exception. */
+    ~Pipeline() {
+        try {
+            wait();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * @brief First stage: calls `produce` until it returns std::nullopt.
+     * @param produce Callable returning std::optional<T>
+     * @throws std::invalid_argument if the pool has no thread left for the stage
+     */
+    template <typename F>
+    auto source(F&& produce) {
+        using T = typename std::invoke_result_t<std::decay_t<F>>::value_type;
+        auto output = make_queue<T>();
+        start([produce = std::forward<F>(produce), output]() mutable {
+            while (auto item = produce()) {
+                if (!output->push(std::move(*item))) {
+                    break;
+                }
+            }
+        }, {}, closer(output));
+        produced(output);
+        return PipelineStage<T>(*this, output);
+    }
+
+    /**
+     * @brief Wait for every stage to finish.
+     * @throws The first exception thrown by a stage
+     *
+     * Outputs that no stage consumes are closed first, so the stages
+     * producing them stop instead of blocking on a full queue.
+     */
+    void wait() {
+        for (auto& output : open_outputs_) {
+            output.second();
+        }
+        open_outputs_.clear();
+        std::exception_ptr first;
+        for (auto& task : tasks_) {
+            try {
+                task.get();
+            } catch (...) {
+                if (!first) {
+                    first = std::current_exception();
+                }
+            }
+        }
+        tasks_.clear();
+        if (first) {
+            std::rethrow_exception(first);
+        }
+    }
+
+private:
+    template <typename T>
+    std::shared_ptr<BoundedQueue<T>> make_queue() {
+        return std::make_shared<BoundedQueue<T>>(options_.queue_capacity);
+    }
+
+    // Run a stage body; afterwards, or on failure, close its queues so that
+    // neighbours stop waiting on it
+    void start(std::function<void()> body, std::function<void()> close_input,
+               std::function<void()> close_output) {
+        if (!pool_.reserve_worker()) {
+            // Let the stages already running finish
+            if (close_input) {
+                close_input();
+            }
+            throw std::invalid_argument("Pipeline needs a pool thread for every stage.");
+        }
+        tasks_.push_back(pool_.submit([&pool = pool_, body = std::move(body), close_input = std::move(close_input),
+                                       close_output = std::move(close_output)] {
+            struct Release {
+                ThreadPool& pool;
+                ~Release() { pool.release_worker(); }
+            } release{pool};
+            auto close = [&] {
+                if (close_input) {
+                    close_input();
+                }
+                if (close_output) {
+                    close_output();
+                }
+            };
+            try {
+                body();
+            } catch (...) {
+                close();
+                throw;
+            }
+            close();
+        }));
+    }
+
+    template <typename Q>
+    static std::function<void()> closer(const std::shared_ptr<Q>& queue) {
+        return [queue] { queue->close(); };
+    }
+
+    // Track stage outputs until a later stage consumes them
+    template <typename Q>
+    void produced(const std::shared_ptr<Q>& queue) {
+        open_outputs_.emplace_back(queue.get(), closer(queue));
+    }
+
+    void consumed(const void* queue) {
+        for (auto it = open_outputs_.begin(); it != open_outputs_.end(); ++it) {
+            if (it->first == queue) {
+                open_outputs_.erase(it);
+                return;
+            }
+        }
+    }
+
+    ThreadPool& pool_;
+    PipelineOptions options_;
+    std::vector<std::future<void>> tasks_;
+    std::vector<std::pair<const void*, std::function<void()>>> open_outputs_;  ///< Outputs without a consumer
+
+    template <typename> friend class PipelineStage;
+};
+
+template <typename T>
+template <typename F>
+auto PipelineStage<T>::then(F&& f) -> PipelineStage<std::invoke_result_t<std::decay_t<F>, T>>
+{
+    using R = std::invoke_result_t<std::decay_t<F>, T>;
+    auto input = output_;
+    auto output = pipeline_->make_queue<R>();
+    pipeline_->start([f = std::forward<F>(f), input, output]() mutable {
+        while (auto item = input->pop()) {
+            if (!output->push(f(std::move(*item)))) {
+                break;
+            }
+        }
+    }, Pipeline::closer(input), Pipeline::closer(output));
+    pipeline_->consumed(input.get());
+    pipeline_->produced(output);
+    return PipelineStage<R>(*pipeline_, output);
+}
+
+template <typename T>
+template <typename F>
+void PipelineStage<T>::sink(F&& f)
+{
+    auto input = output_;
+    pipeline_->start([f = std::forward<F>(f), input]() mutable {
+        while (auto item = input->pop()) {
+            f(std::move(*item));
+        }
+    }, Pipeline::closer(input), {});
+    pipeline_->consumed(input.get());
+}
+
+/**
+ * @brief Create a batch of atomics with one registry reservation and one
+ *        registration.
+ * @param nominal Nominal values
+ * @param stddev Standard deviations (zero: exact value)
+ * @return One atomic per entry; entries with zero stddev are exact
+ * @throws std::invalid_argument if the sizes differ or a stddev is negative
+ *
+ * Creating atomics one by one takes the registry lock once per value when
+ * they are first used; this takes it once per batch.
+ */
+std::vector<udouble> register_batch(const std::vector<double>& nominal, const std::vector<double>& stddev);
+
+} // namespace uncertainties
@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * @file roots.hpp
+ * @brief Roots of f(x; p) = 0 with uncertain parameters p.
+ *
+ * Iterating in udouble arithmetic builds derivative maps on every
+ * iteration, although only the converged value matters. find_root()
+ * iterates on plain doubles (Brent's method on a recorded formula) and
+ * attaches the uncertainty once, at the root, through the implicit
+ * function theorem:
+ *
+ *     dx/dp = -(∂f/∂p) / (∂f/∂x)
+ *
+ * so the cost of the uncertainty does not depend on the iteration count.
+ *
+ * Example usage:
+ * @code
+ * using namespace uncertainties;
+ * udouble a(2.0, 0.01);
+ * // x such that x^3 = a
+ * udouble x = find_root([](const FormulaVar& x, const std::vector<FormulaVar>& p) {
+ *     return x * x * x - p[0];
+ * }, 0.0, 2.0, {a});
+ * @endcode
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "uncertainties/formula.hpp"
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Options for find_root()
+struct RootOptions {
+    double xtol = 0.0;                 ///< Absolute tolerance on x (added to 2 ε |x|)
+    std::size_t max_iterations = 200;  ///< Iterations before giving up
+};
+
+/**
+ * @brief Attach the uncertainty of the parameters to a known root.
+ * @param f Formula with inputs (x, p...) and one output
+ * @param root A root of f for the nominal parameter values, found by any method
+ * @param params Parameters
+ * @throws std::invalid_argument if f does not take 1 + params.size() inputs
+ *         or has more than one output
+ * @throws std::runtime_error if ∂f/∂x vanishes at the root
+ */
+udouble implicit_root(const Formula& f, double root, const std::vector<udouble>& params);
+
+/**
+ * @brief Find a root of f(x; p) in [lower, upper] by Brent's method.
+ * @param f Formula with inputs (x, p...) and one output
+ * @param lower, upper Bracket; f must not have the same sign at both ends
+ * @param params Parameters
+ * @param options Tolerance and iteration limit
+ * @return The root, correlated with the parameters
+ * @throws std::invalid_argument if the bracket does not contain a sign change
+ * @throws std::runtime_error if the iteration does not converge or ∂f/∂x
+ *         vanishes at the root
+ */
+udouble find_root(const Formula& f, double lower, double upper,
+                  const std::vector<udouble>& params, const RootOptions& options = {});
+
+/**
+ * @brief Record f and find its root.
+ * @param f Callable taking (const FormulaVar& x, const std::vector<FormulaVar>& p)
+ *          and returning a FormulaVar
+ */
+template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Formula>>>
+udouble find_root(F&& f, double lower, double upper, const std::vector<udouble>& params,
+                  const RootOptions& options = {}) {
+    Formula formula = Formula::record(1 + params.size(), [&](const std::vector<FormulaVar>& in) {
+        std::vector<FormulaVar> p(in.begin() + 1, in.end());
+        return FormulaVar(f(in[0], p));
+    });
+    return find_root(formula, lower, upper, params, options);
+}
+
+} // namespace uncertainties
@@ -0,0 +1,112 @@
+#pragma once
+
+/**
+ * @file running_derivatives.hpp
+ * @brief Incrementally updated derivative map used by the sequence algorithms.
+ *
+ * Recurrences such as running sums, running products and IIR filters update
+ * the derivatives of output k from those of output k-1. Keeping them as
+ * `scale * entries` makes multiplying the whole map by a constant O(1), and
+ * caching σ² per entry together with Σ entry² σ² makes the standard
+ * deviation available after every step without another pass.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/variable_registry.hpp"
+
+namespace uncertainties {
+namespace detail {
+
+struct RunningDerivatives {
+    struct Entry {
+        double derivative;
+        double variance;
+    };
+
+    std::unordered_map<uint64_t, Entry> entries;
+    double scale = 1.0;
+    double variance_sum = 0.0;
+
+    /** @brief Add `delta` to the stored (unscaled) derivative for `id`. */
+    void add(uint64_t id, double delta) {
+        auto [it, inserted] = entries.try_emplace(id, Entry{0.0, 0.0});
+        Entry& entry = it->second;
+        if (inserted) {
+            double sigma = VariableRegistry::instance().get_stddev(id);
+            entry.variance = sigma * sigma;
+        }
+        variance_sum += entry.variance * delta * (2.0 * entry.derivative + delta);
+        entry.derivative += delta;
+    }
+
+    /** @brief Add `factor * ∂x` for every derivative of `x`, relative to the current scale. */
+    void add_scaled(const udouble& x, double factor) {
+        double delta = factor / scale;
+        for (const auto& [id, deriv] : x.derivatives()) {
+            add(id, delta * deriv);
+        }
+    }
+
+    void reset() {
+        entries.clear();
+        scale = 1.0;
+        variance_sum = 0.0;
+    }
+
+    /**
+     * @brief Fold the scale back into the entries before it over- or underflows.
+     * @param drop_below Entries contributing at most this fraction of the
+     *        variance are dropped (0: keep every entry)
+     *
+     * The variance sum is recomputed exactly. Decaying recurrences such as
+     * filters drop negligible entries to keep a bounded map; scans keep them
+     * so that their outputs match ScanResult::value().
+     */
+    void normalize(double drop_below = 0.0) {
+        double magnitude = std::abs(scale);
+        if (magnitude > 1e-100 && magnitude < 1e100) {
+            return;
+        }
+        double total = 0.0;
+        for (auto& [id, entry] : entries) {
+            entry.derivative *= scale;
+            total += entry.derivative * entry.derivative * entry.variance;
+        }
+        variance_sum = total;
+        scale = 1.0;
+        if (drop_below <= 0.0) {
+            return;
+        }
+        const double negligible = drop_below * total;
+        for (auto it = entries.begin(); it != entries.end();) {
+            const Entry& entry = it->second;
+            if (entry.derivative * entry.derivative * entry.variance <= negligible) {
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    double stddev() const {
+        return std::abs(scale) * std::sqrt(std::max(variance_sum, 0.0));
+    }
+
+    /** @brief The scaled derivatives as a map. */
+    udouble::DerivativeMap derivatives() const {
+        udouble::DerivativeMap out;
+        out.reserve(entries.size());
+        for (const auto& [id, entry] : entries) {
+            out.emplace(id, scale * entry.derivative);
+        }
+        return out;
+    }
+};
+
+} // namespace detail
+} // namespace uncertainties
@@ -0,0 +1,150 @@
+#pragma once
+
+/**
+ * @file scan.hpp
+ * @brief Cumulative sums and products of udouble sequences.
+ *
+ * A running total built with operator+= copies an ever-growing derivative
+ * map at every step, which is O(n²) over the sequence. Because a prefix sum
+ * (or product) is linear in each input, output k is fully described by its
+ * nominal value and the coefficients ∂out_k/∂x_i. All outputs share the
+ * same lower-triangular sparsity pattern (row k uses inputs 0..k), and the
+ * coefficients of a row can be generated in O(1) each, so the Jacobian is
+ * kept in this compressed form instead of as n derivative maps.
+ *
+ * Nominal values are scanned in parallel blocks; standard deviations come
+ * from a single incremental pass, so the whole scan is linear in the total
+ * size of the inputs' derivative maps. Outputs are materialized as udouble
+ * values only on request.
+ *
+ * Example usage:
+ * @code
+ * std::vector<uncertainties::udouble> dose = ...;
+ * auto total = uncertainties::inclusive_scan(dose);
+ * double last_sigma = total.stddev().back();
+ * uncertainties::udouble day_10 = total.value(10);  // correlated with dose
+ * @endcode
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Operation of a scan
+enum class ScanOp {
+    Sum,      ///< Running sum
+    Product   ///< Running product
+};
+
+/// Options for inclusive_scan() and exclusive_scan()
+struct ScanOptions {
+    std::size_t threads = 0;        ///< Threads for the nominal scan (0: hardware concurrency)
+    std::size_t block_size = 4096;  ///< Elements per block of the parallel scan
+};
+
+/**
+ * @class ScanResult
+ * @brief Outputs of a scan in compressed lower-triangular form.
+ *
+ * Row k of the Jacobian with respect to the inputs covers inputs [0, k]
+ * for an inclusive scan and [0, k) for an exclusive one.
+ */
+class ScanResult {
+public:
+    std::size_t size() const noexcept { return nominals_.size(); }
+    ScanOp op() const noexcept { return op_; }
+    bool exclusive() const noexcept { return exclusive_; }
+
+    /** @brief Nominal value of every output. */
+    const std::vector<double>& nominal() const noexcept { return nominals_; }
+
+    /** @brief Standard deviation of every output. */
+    const std::vector<double>& stddev() const noexcept { return stddevs_; }
+
+    /** @brief Number of inputs output k depends on. */
+    std::size_t row_length(std::size_t k) const noexcept { return exclusive_ ? k : k + 1; }
+
+    /**
+     * @brief ∂out_k/∂x_i (0 outside the lower-triangular pattern).
+     *
+     * For products with zero inputs the coefficients follow the exact
+     * product rule: only the zero input has a non-zero coefficient if the
+     * row contains exactly one zero, and none if it contains more.
+     */
+    double coefficient(std::size_t k, std::size_t i) const;
+
+    /**
+     * @brief Output k as a udouble, correlated with the inputs.
+     *
+     * Costs O(total derivative entries of inputs in row k).
+     */
+    udouble value(std::size_t k) const;
+
+    /**
+     * @brief Every output as a udouble.
+     *
+     * Built in one incremental pass; the cost is dominated by the size of
+     * the outputs' derivative maps themselves.
+     */
+    std::vector<udouble> values() const;
+
+private:
+    // Visit the derivative map of every inclusive output in order
+    template <typename Visit>
+    void sweep(Visit&& visit) const;
+
+    ScanOp op_ = ScanOp::Sum;
+    bool exclusive_ = false;
+    std::vector<udouble> inputs_;
+    std::vector<double> inclusive_;        ///< Inclusive nominal of every input position
+    std::vector<double> nonzero_product_;  ///< Product scans: prefix product of non-zero inputs
+    std::vector<std::size_t> zeros_;       ///< Product scans: prefix count of zero inputs
+    std::vector<double> nominals_;
+    std::vector<double> stddevs_;
+
+    friend ScanResult scan(const std::vector<udouble>& xs, ScanOp op, bool exclusive,
+                           const ScanOptions& options);
+};
+
+/**
+ * @brief Scan `xs` (output k combines x_0..x_k).
+ * @param xs Input sequence
+ * @param op Sum or Product
+ * @param exclusive If true, output k combines x_0..x_{k-1} and output 0 is
+ *                  the identity (0 or 1)
+ * @param options Threading options
+ */
+ScanResult scan(const std::vector<udouble>& xs, ScanOp op, bool exclusive,
+                const ScanOptions& options = {});
+
+/** @brief Inclusive scan: output k combines x_0..x_k. */
+inline ScanResult inclusive_scan(const std::vector<udouble>& xs, ScanOp op = ScanOp::Sum,
+                                 const ScanOptions& options = {}) {
+    return scan(xs, op, false, options);
+}
+
+/** @brief Exclusive scan: output k combines x_0..x_{k-1}. */
+inline ScanResult exclusive_scan(const std::vector<udouble>& xs, ScanOp op = ScanOp::Sum,
+                                 const ScanOptions& options = {}) {
+    return scan(xs, op, true, options);
+}
+
+/** @brief Inclusive scan of a range of udouble values. */
+template <typename InputIt>
+ScanResult inclusive_scan(InputIt first, InputIt last, ScanOp op = ScanOp::Sum,
+                          const ScanOptions& options = {}) {
+    return scan(std::vector<udouble>(first, last), op, false, options);
+}
+
+/** @brief Exclusive scan of a range of udouble values. */
+template <typename InputIt>
+ScanResult exclusive_scan(InputIt first, InputIt last, ScanOp op = ScanOp::Sum,
+                          const ScanOptions& options = {}) {
+    return scan(std::vector<udouble>(first, last), op, true, options);
+}
+
+} // namespace uncertainties
@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * @file shared_registry.hpp
+ * @brief Variable registry shared by processes on one host.
+ *
+ * Pre-forked worker processes each have their own VariableRegistry, so they
+ * allocate overlapping atomic IDs and see none of each other's stddevs.
+ * Attaching to a shared registry moves ID allocation and the stddev table
+ * into a POSIX shared memory segment: IDs are allocated with one atomic
+ * fetch-add on a shared counter and stddevs live in a lock-free hash table,
+ * so every attached process draws from one ID space and looks up every
+ * atomic's stddev without serialization.
+ *
+ * Attach in the parent before forking, or in each worker under the same
+ * name. Atomics created before attaching remain valid in the process that
+ * created them but are not visible to the others; IDs drawn from the shared
+ * counter never collide with them. ID namespaces (set_id_namespace()) stay
+ * per process and prefix shared IDs as well. Derivative maps are
+ * still process-local; move values between processes with serialize()
+ * (see distributed.hpp), which then never reports a collision.
+ *
+ * Example usage:
+ * @code
+ * uncertainties::attach_shared_registry("/my-run");
+ * for (int k = 0; k < workers; ++k) {
+ *     if (fork() == 0) { run_worker(k); _exit(0); }
+ * }
+ * ...
+ * uncertainties::detach_shared_registry();
+ * uncertainties::remove_shared_registry("/my-run");
+ * @endcode
+ */
+
+#include <cstddef>
+#include <string>
+
+namespace uncertainties {
+
+/**
+ * @brief Options for attach_shared_registry().
+ */
+struct SharedRegistryOptions {
+    /// Atomics the segment can hold; only used by the process creating it
+    std::size_t capacity = std::size_t{1} << 20;
+};
+
+/**
+ * @brief Attach this process to the shared registry `name`, creating it if needed.
+ * @param name Shared memory object name, e.g. "/my-run"
+ * @param options Segment size for a newly created registry
+ * @throws std::invalid_argument if capacity is zero
+ * @throws std::runtime_error if a registry is already attached, the segment
+ *         cannot be created or mapped, or it is not a registry segment
+ */
+void attach_shared_registry(const std::string& name, const SharedRegistryOptions& options = {});
+
+/**
+ * @brief Return to the process-local registry and unmap the segment.
+ *
+ * Does nothing if no registry is attached. Waits for other threads that
+ * are reading the segment. Values that depend on atomics registered in the
+ * shared registry can no longer compute their uncertainty afterwards.
+ */
+void detach_shared_registry();
+
+/**
+ * @brief Remove the shared memory object `name`.
+ *
+ * Processes still attached keep their mapping. Does nothing if the object
+ * does not exist.
+ * @throws std::runtime_error if the object exists but cannot be removed
+ */
+void remove_shared_registry(const std::string& name);
+
+/** @brief Whether this process is attached to a shared registry. */
+bool shared_registry_attached();
+
+} // namespace uncertainties
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * @file sparse.hpp
+ * @brief Sparse matrices with uncertain entries, sparse matrix-vector
+ *        products and sparse triangular solves.
+ *
+ * Eigen::SparseMatrix<udouble> is not usable in practice: its storage
+ * assumes cheap, trivially relocatable scalars, and every product goes
+ * through per-entry map arithmetic. SparseUMatrix stores the matrix in
+ * compressed sparse row (CSR) form, with the nominal values in their own
+ * contiguous array. The kernels compute nominal results with plain double
+ * loops and merge derivative maps row by row:
+ *
+ * - spmv() handles each row independently and splits the rows across threads.
+ * - triangular_solve() solves the nominal system by substitution. It then
+ *   propagates dx = A⁻¹ (db − dA·x) level by level. The rows of one level
+ *   depend only on earlier levels, so each level runs in parallel.
+ *
+ * transpose() returns the CSR form of Aᵀ, which is the CSC form of A, for
+ * products with the transpose.
+ *
+ * Example usage:
+ * @code
+ * using namespace uncertainties;
+ * SparseUMatrix A(3, 3, {{0, 0, udouble(2.0, 0.1)},
+ *                        {1, 0, udouble(1.0, 0.05)},
+ *                        {1, 1, udouble(3.0, 0.1)},
+ *                        {2, 2, udouble(4.0, 0.2)}});
+ * std::vector<udouble> x{udouble(1.0, 0.01), 2.0, 3.0};
+ * std::vector<udouble> y = spmv(A, x);
+ * std::vector<udouble> z = triangular_solve(A, y, Triangle::Lower);  // z == x
+ * @endcode
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// One (row, column, value) entry of a sparse matrix
+struct SparseEntry {
+    std::size_t row;
+    std::size_t col;
+    udouble value;
+};
+
+/// Triangle of a matrix used by triangular_solve()
+enum class Triangle {
+    Lower,
+    Upper
+};
+
+/// Options for the sparse kernels
+struct SparseOptions {
+    std::size_t threads = 0;  ///< Threads used (0: hardware concurrency)
+};
+
+/**
+ * @class SparseUMatrix
+ * @brief Sparse matrix of udouble entries in compressed sparse row form.
+ */
+class SparseUMatrix {
+public:
+    SparseUMatrix() = default;
+
+    /**
+     * @brief Build from entries in any order.
+     *
+     * Duplicate entries are summed.
+     * @throws std::invalid_argument if an entry lies outside rows × cols
+     */
+    SparseUMatrix(std::size_t rows, std::size_t cols, const std::vector<SparseEntry>& entries);
+
+    std::size_t rows() const noexcept { return rows_; }
+    std::size_t cols() const noexcept { return cols_; }
+    std::size_t nonzeros() const noexcept { return values_.size(); }
+
+    /** @brief Start of every row in column_indices() and values(), plus the end. */
+    const std::vector<std::size_t>& row_offsets() const noexcept { return row_offsets_; }
+
+    /** @brief Column of every stored entry, ascending within a row. */
+    const std::vector<std::size_t>& column_indices() const noexcept { return columns_; }
+
+    /** @brief Stored entries. */
+    const std::vector<udouble>& values() const noexcept { return values_; }
+
+    /** @brief Nominal values of the stored entries. */
+    const std::vector<double>& nominal_values() const noexcept { return nominals_; }
+
+    /**
+     * @brief Entry (row, col); zero if it is not stored.
+     * @throws std::out_of_range if (row, col) lies outside the matrix
+     */
+    udouble coeff(std::size_t row, std::size_t col) const;
+
+    /** @brief Aᵀ, i.e. A in compressed sparse column form. */
+    SparseUMatrix transpose() const;
+
+private:
+    std::size_t rows_ = 0;
+    std::size_t cols_ = 0;
+    std::vector<std::size_t> row_offsets_{0};
+    std::vector<std::size_t> columns_;
+    std::vector<udouble> values_;
+    std::vector<double> nominals_;
+};
+
+/**
+ * @brief y = A x.
+ * @throws std::invalid_argument if x.size() != A.cols()
+ */
+std::vector<udouble> spmv(const SparseUMatrix& A, const std::vector<udouble>& x,
+                          const SparseOptions& options = {});
+
+/**
+ * @brief y = A x with an exact vector x.
+ * @throws std::invalid_argument if x.size() != A.cols()
+ */
+std::vector<udouble> spmv(const SparseUMatrix& A, const std::vector<double>& x,
+                          const SparseOptions& options = {});
+
+/**
+ * @brief Solve A x = b with A triangular.
+ *
+ * Entries outside the chosen triangle are ignored.
+ * @throws std::invalid_argument if A is not square or b.size() != A.rows()
+ * @throws std::runtime_error if a diagonal entry is missing or zero
+ */
+std::vector<udouble> triangular_solve(const SparseUMatrix& A, const std::vector<udouble>& b,
+                                      Triangle triangle, const SparseOptions& options = {});
+
+} // namespace uncertainties
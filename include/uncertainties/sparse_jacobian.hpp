@@ -0,0 +1,102 @@
+#pragma once
+
+/**
+ * @file sparse_jacobian.hpp
+ * @brief Sparse Jacobians of recorded formulas by column coloring.
+ *
+ * Building the Jacobian of many outputs with respect to many atomics from
+ * each udouble's derivatives() holds one hash map per output. For a
+ * recorded Formula, the Jacobian is computed in compressed form instead:
+ *
+ * 1. sparsity_pattern() propagates input dependency sets through the
+ *    bytecode to find which outputs can depend on which inputs.
+ * 2. color_columns() assigns colors so that no two columns of one color
+ *    share a row (greedy, largest column first).
+ * 3. sparse_jacobian() seeds one tangent lane per color, so a single
+ *    FormulaTangents pass yields every color's column sum, and reads each
+ *    structural nonzero back from its color's lane.
+ *
+ * The number of lanes is the number of colors, typically the largest
+ * number of columns one row depends on, rather than the number of
+ * columns. The result is a CSR matrix. For udouble arguments its columns
+ * are the atomics the arguments depend on, together with their stddevs
+ * from the variable registry, so the covariance of the outputs is
+ * J·diag(σ²)·Jᵀ.
+ *
+ * Example usage:
+ * @code
+ * auto f = Formula::record(n, [](const auto& in) { ... });
+ * SparseJacobian J = sparse_jacobian(f, args);  // args: std::vector<udouble>
+ * for (std::size_t r = 0; r < J.rows; ++r) {
+ *     for (std::size_t k = J.row_offsets[r]; k < J.row_offsets[r + 1]; ++k) {
+ *         // ∂output r / ∂atomic J.ids[J.column_indices[k]] = J.values[k]
+ *     }
+ * }
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "uncertainties/formula.hpp"
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/**
+ * @brief Structural nonzeros of a matrix in compressed sparse row form.
+ *
+ * Column indices are sorted within each row.
+ */
+struct SparsityPattern {
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::vector<std::size_t> row_offsets;     ///< rows + 1 entries
+    std::vector<std::size_t> column_indices;  ///< One per nonzero
+
+    std::size_t nonzeros() const noexcept { return column_indices.size(); }
+};
+
+/**
+ * @brief A Jacobian in compressed sparse row form.
+ *
+ * Zero-valued entries of the pattern are kept, so the structure depends
+ * only on the formula.
+ */
+struct SparseJacobian : SparsityPattern {
+    std::vector<double> values;  ///< One per nonzero
+    std::vector<uint64_t> ids;   ///< Atomic ID of each column (udouble arguments only)
+    std::vector<double> sigma;   ///< Stddev of each column (udouble arguments only)
+};
+
+/**
+ * @brief Which outputs of a formula can depend on which inputs.
+ * @return num_outputs() × num_inputs() pattern
+ */
+SparsityPattern sparsity_pattern(const Formula& formula);
+
+/**
+ * @brief Color columns so that columns sharing a row differ in color.
+ * @param pattern Matrix pattern
+ * @param colors Receives the number of colors used
+ * @return Color of each column, in [0, colors)
+ */
+std::vector<std::size_t> color_columns(const SparsityPattern& pattern, std::size_t& colors);
+
+/**
+ * @brief Jacobian of a formula at a point with respect to its inputs.
+ * @throws std::invalid_argument if x has the wrong size, or on domain errors
+ */
+SparseJacobian sparse_jacobian(const Formula& formula, const std::vector<double>& x);
+
+/**
+ * @brief Jacobian of a formula applied to udouble arguments, with respect
+ *        to the atomics the arguments depend on.
+ *
+ * Columns are sorted by atomic ID; `ids` and `sigma` describe them.
+ * @throws std::invalid_argument if args has the wrong size, or on domain errors
+ */
+SparseJacobian sparse_jacobian(const Formula& formula, const std::vector<udouble>& args);
+
+} // namespace uncertainties
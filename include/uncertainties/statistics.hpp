@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+ * @file statistics.hpp
+ * @brief Streaming sample statistics that produce udouble results.
+ *
+ * SampleAccumulator keeps the count, mean and sum of squared deviations of
+ * a stream of repeated measurements (Welford's update), so samples never
+ * have to be stored. Batches are ingested with a two-pass kernel over
+ * contiguous data, and accumulators built on different threads or machines
+ * combine exactly with Chan's pairwise formula, so accumulate() splits
+ * large sample arrays across threads. result() turns the accumulator into
+ * an atomic udouble: the sample mean with its standard error as stddev.
+ *
+ * Quantities measured together, e.g. two channels read from the same shot,
+ * have correlated means. JointSampleAccumulator tracks the co-moment matrix
+ * of such sample rows as well, and means() returns correlated udouble
+ * values built by correlated_values() from the covariance of the means.
+ *
+ * Example usage:
+ * @code
+ * uncertainties::SampleAccumulator acc;
+ * for (double sample : stream) {
+ *     acc.add(sample);
+ * }
+ * uncertainties::udouble g = acc.result();  // mean ± standard error
+ *
+ * uncertainties::JointSampleAccumulator pair(2);
+ * pair.add({voltage, current});
+ * std::vector<uncertainties::udouble> vi = pair.means();  // correlated
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "uncertainties/udouble.hpp"
+
+namespace uncertainties {
+
+/// Options for accumulate()
+struct StatisticsOptions {
+    std::size_t threads = 0;  ///< Threads used (0: hardware concurrency)
+};
+
+/**
+ * @class SampleAccumulator
+ * @brief Count, mean and variance of a sample stream.
+ */
+class SampleAccumulator {
+public:
+    /** @brief Add one sample. */
+    void add(double sample) noexcept {
+        ++count_;
+        const double delta = sample - mean_;
+        mean_ += delta / static_cast<double>(count_);
+        m2_ += delta * (sample - mean_);
+    }
+
+    /** @brief Add `n` contiguous samples. */
+    void add(const double* samples, std::size_t n) noexcept;
+
+    /** @brief Add every sample of a vector. */
+    void add(const std::vector<double>& samples) noexcept { add(samples.data(), samples.size()); }
+
+    /** @brief Combine with the samples of another accumulator. */
+    void merge(const SampleAccumulator& other) noexcept;
+
+    uint64_t count() const noexcept { return count_; }
+    double mean() const noexcept { return mean_; }
+
+    /**
+     * @brief Unbiased sample variance.
+     * @throws std::runtime_error with fewer than two samples
+     */
+    double variance() const;
+
+    /** @brief Standard error of the mean, √(variance / count). */
+    double standard_error() const;
+
+    /**
+     * @brief The mean as an atomic udouble with the standard error as stddev.
+     * @throws std::runtime_error with fewer than two samples
+     */
+    udouble result() const;
+
+private:
+    uint64_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;  ///< Sum of squared deviations from the mean
+};
+
+/**
+ * @brief Accumulate a sample array on several threads.
+ *
+ * Each thread accumulates a contiguous part; the parts are merged in order.
+ */
+SampleAccumulator accumulate(const std::vector<double>& samples, const StatisticsOptions& options = {});
+
+/**
+ * @class JointSampleAccumulator
+ * @brief Means and covariances of samples of several quantities taken together.
+ */
+class JointSampleAccumulator {
+public:
+    /** @brief Accumulator for rows of `dimension` simultaneous samples. */
+    explicit JointSampleAccumulator(std::size_t dimension);
+
+    std::size_t dimension() const noexcept { return mean_.size(); }
+    uint64_t count() const noexcept { return count_; }
+
+    /** @brief Add one row of `dimension()` samples. */
+    void add(const double* row);
+
+    /**
+     * @brief Add one row.
+     * @throws std::invalid_argument if the row has the wrong size
+     */
+    void add(std::initializer_list<double> row);
+
+    /**
+     * @brief Add `n` rows stored row-major (n × dimension()).
+     */
+    void add(const double* rows, std::size_t n);
+
+    /**
+     * @brief Combine with the samples of another accumulator.
+     * @throws std::invalid_argument if the dimensions differ
+     */
+    void merge(const JointSampleAccumulator& other);
+
+    /** @brief Sample means. */
+    const std::vector<double>& mean() const noexcept { return mean_; }
+
+    /**
+     * @brief Unbiased sample covariance matrix, row-major.
+     * @throws std::runtime_error with fewer than two samples
+     */
+    std::vector<double> covariance() const;
+
+    /**
+     * @brief The means as correlated udouble values.
+     *
+     * Their covariance is covariance() / count(), the covariance of the
+     * sample means.
+     * @throws std::runtime_error with fewer than two samples
+     */
+    std::vector<udouble> means() const;
+
+private:
+    uint64_t count_ = 0;
+    std::vector<double> mean_;
+    std::vector<double> comoment_;  ///< Σ (x - mean)(x - mean)ᵀ, row-major
+};
+
+/**
+ * @brief udouble values with given nominal values and covariance matrix.
+ * @param nominal Nominal values
+ * @param covariance Row-major covariance matrix (nominal.size()²)
+ * @return Values that are linear combinations of new atomics, factored
+ *         by a Cholesky decomposition of the covariance
+ * @throws std::invalid_argument if the sizes disagree or the matrix is not
+ *         symmetric positive semidefinite
+ */
+std::vector<udouble> correlated_values(const std::vector<double>& nominal,
+                                       const std::vector<double>& covariance);
+
+} // namespace uncertainties
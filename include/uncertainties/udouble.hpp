@@ -9,6 +9,7 @@
  * correct uncertainty propagation for expressions like x - x = 0 ± 0.
  */
 
+#include <atomic>
 #include <cmath>
 #include <stdexcept>
 #include <ostream>
@@ -50,8 +51,21 @@ public:
     using DerivativeMap = std::unordered_map<uint64_t, double>;
 
 private:
+    // The two words after the map grow the object from 64 to 80 bytes with
+    // libstdc++ on LP64. The map has no spare bits to fold them into, and
+    // both are needed: an unregistered atomic keeps its stddev inline, and
+    // a cached stddev is only valid together with its registry generation.
     double nominal_;           ///< The nominal (central) value
     DerivativeMap derivatives_; ///< Partial derivatives w.r.t. atomic variables
+    /// Cached stddev; for an unregistered atomic, its own stddev
+    mutable std::atomic<double> sigma_{0.0};
+    /// STATE_* flags plus (registry generation + 1) of the cached stddev
+    /// in the bits above CACHE_SHIFT (0: nothing cached)
+    mutable std::atomic<uint64_t> state_{0};
+
+    static constexpr uint64_t STATE_UNREGISTERED = 1;  ///< Atomic not yet in the registry
+    static constexpr uint64_t STATE_BUSY = 2;          ///< A thread is writing the cache
+    static constexpr int CACHE_SHIFT = 2;
 
     /**
      * @brief Private constructor for derived values.
@@ -61,6 +75,70 @@ private:
     udouble(double nominal, DerivativeMap derivatives)
         : nominal_(nominal), derivatives_(std::move(derivatives)) {}
 
+    /**
+     * @brief Register an atomic's stddev with the registry if not done yet.
+     *
+     * Atomics reserve their ID on construction but defer registration until
+     * the ID is needed by a derived value, so values that are only printed,
+     * compared or discarded never touch the registry map.
+     */
+    void ensure_registered() const {
+        if (state_.load(std::memory_order_acquire) & STATE_UNREGISTERED) {
+            detail::VariableRegistry::instance().register_id(
+                derivatives_.begin()->first, sigma_.load(std::memory_order_relaxed));
+            state_.fetch_and(~STATE_UNREGISTERED, std::memory_order_acq_rel);
+        }
+    }
+
+    /**
+     * @brief Recompute the stddev and publish it to the cache.
+     * @param state The state observed by the caller
+     * @param generation The registry generation observed by the caller
+     */
+    double refresh_stddev(uint64_t state, uint64_t generation) const;
+
+    /**
+     * @brief State of a copy: flags and cache, unless a write was in progress.
+     */
+    static uint64_t copied_state(uint64_t state) noexcept {
+        return (state & STATE_BUSY) ? (state & STATE_UNREGISTERED) : state;
+    }
+
+    /**
+     * @brief Derivative map for use in a derived value (registers atomics).
+     */
+    const DerivativeMap& linked_derivatives() const {
+        ensure_registered();
+        return derivatives_;
+    }
+
+    /**
+     * @brief Prepare to modify the derivative map in place.
+     *
+     * The value stops being atomic; its own ID is registered first because
+     * the modified map still refers to it. Any cached stddev is dropped.
+     */
+    void make_derived() {
+        ensure_registered();
+        state_.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Turn this value into a new, not yet registered atomic.
+     */
+    void make_atomic(double stddev) {
+        derivatives_.clear();
+        sigma_.store(0.0, std::memory_order_relaxed);
+        state_.store(0, std::memory_order_relaxed);
+        if (stddev > 0.0) {
+            auto& registry = detail::VariableRegistry::instance();
+            derivatives_[registry.reserve_id()] = 1.0;
+            sigma_.store(stddev, std::memory_order_relaxed);
+            state_.store(STATE_UNREGISTERED | ((registry.generation() + 1) << CACHE_SHIFT),
+                         std::memory_order_relaxed);
+        }
+    }
+
     // Allow operators to use private constructor
     friend udouble operator+(const udouble& lhs, const udouble& rhs);
     friend udouble operator-(const udouble& lhs, const udouble& rhs);
@@ -116,8 +194,10 @@ public:
      * @param stddev The standard deviation (must be non-negative)
      * @throws std::invalid_argument if stddev is negative
      *
-     * Creates an "atomic" variable that is registered with the global registry.
-     * This variable will be tracked through all subsequent operations.
+     * Creates an "atomic" variable with a unique ID. Its stddev is kept inline
+     * and added to the global registry when the variable first contributes
+     * to a derived value. This variable will be tracked through all
+     * subsequent operations.
      */
     udouble(double nominal, double stddev)
         : nominal_(nominal)
@@ -125,13 +205,66 @@ public:
         if (stddev < 0.0) {
             throw std::invalid_argument("Standard deviation cannot be negative.");
         }
-        if (stddev > 0.0) {
-            uint64_t id = detail::VariableRegistry::instance().register_variable(stddev);
-            derivatives_[id] = 1.0;
-        }
         // If stddev == 0, derivatives_ remains empty (constant)
+        make_atomic(stddev);
+    }
+
+    /** @brief Copy constructor (copies share the atomic ID). */
+    udouble(const udouble& other)
+        : nominal_(other.nominal_),
+          derivatives_(other.derivatives_),
+          sigma_(other.sigma_.load(std::memory_order_relaxed)),
+          state_(copied_state(other.state_.load(std::memory_order_acquire))) {}
+
+    /** @brief Move constructor. */
+    udouble(udouble&& other) noexcept
+        : nominal_(other.nominal_),
+          derivatives_(std::move(other.derivatives_)),
+          sigma_(other.sigma_.load(std::memory_order_relaxed)),
+          state_(copied_state(other.state_.load(std::memory_order_acquire)))
+    {
+        other.derivatives_.clear();
+        other.state_.store(0, std::memory_order_relaxed);
     }
 
+    /** @brief Copy assignment. */
+    udouble& operator=(const udouble& other) {
+        if (this != &other) {
+            nominal_ = other.nominal_;
+            derivatives_ = other.derivatives_;
+            sigma_.store(other.sigma_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            state_.store(copied_state(other.state_.load(std::memory_order_acquire)),
+                         std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    /** @brief Move assignment. */
+    udouble& operator=(udouble&& other) noexcept {
+        if (this != &other) {
+            nominal_ = other.nominal_;
+            derivatives_ = std::move(other.derivatives_);
+            sigma_.store(other.sigma_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            state_.store(copied_state(other.state_.load(std::memory_order_acquire)),
+                         std::memory_order_relaxed);
+            other.derivatives_.clear();
+            other.state_.store(0, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Build a derived value from a nominal value and derivative map.
+     * @param nominal The nominal value
+     * @param derivatives Partial derivatives w.r.t. registered atomic IDs
+     * @return The derived value
+     *
+     * Every ID must be registered (e.g. taken from another value's
+     * derivatives()). Near-zero entries are pruned and the thread's
+     * derivative budget is applied, as for any derived value.
+     */
+    static udouble from_derivatives(double nominal, DerivativeMap derivatives);
+
     /// @}
 
     /// @name Accessors
@@ -150,28 +283,46 @@ public:
      * The uncertainty is computed as:
      * σ = sqrt(Σ (∂f/∂xi)² * σi²)
      * where xi are the original atomic variables.
+     *
+     * The result is cached in the object and reused until the value is
+     * modified or a registered stddev changes (see
+     * VariableRegistry::generation()), so repeated queries are O(1).
+     * Concurrent calls on the same const object are safe.
      */
     double stddev() const {
         if (derivatives_.empty()) {
             return 0.0;
         }
-
-        double variance = 0.0;
-        const auto& registry = detail::VariableRegistry::instance();
-
-        for (const auto& [id, deriv] : derivatives_) {
-            double original_stddev = registry.get_stddev(id);
-            variance += deriv * deriv * original_stddev * original_stddev;
+        const uint64_t generation = detail::VariableRegistry::instance().generation();
+        const uint64_t state = state_.load(std::memory_order_acquire);
+        if ((state >> CACHE_SHIFT) == generation + 1) {
+            double cached = sigma_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (state_.load(std::memory_order_relaxed) == state) {
+                return cached;
+            }
         }
-
-        return std::sqrt(variance);
+        return refresh_stddev(state, generation);
     }
 
     /**
      * @brief Get the derivative map.
      * @return Reference to the map of variable IDs to partial derivatives
+     *
+     * The IDs of atomics are registered before the map is returned, so
+     * every ID can be looked up in the registry. Registration may allocate,
+     * so unlike stored_derivatives() this accessor is not noexcept.
+     */
+    const DerivativeMap& derivatives() const { return linked_derivatives(); }
+
+    /**
+     * @brief Get the derivative map without registering atomics.
+     * @return Reference to the map of variable IDs to partial derivatives
+     *
+     * Has no side effects; the ID of an atomic that has not fed a derived
+     * value yet is not in the registry.
      */
-    const DerivativeMap& derivatives() const noexcept { return derivatives_; }
+    const DerivativeMap& stored_derivatives() const noexcept { return derivatives_; }
 
     /**
      * @brief Get the number of contributing atomic variables.
@@ -217,11 +368,7 @@ public:
         if (value < 0.0) {
             throw std::invalid_argument("Standard deviation cannot be negative.");
         }
-        derivatives_.clear();
-        if (value > 0.0) {
-            uint64_t id = detail::VariableRegistry::instance().register_variable(value);
-            derivatives_[id] = 1.0;
-        }
+        make_atomic(value);
     }
 
     /// @}
@@ -235,7 +382,7 @@ public:
     /** @brief Unary negation (negates nominal value and derivatives) */
     udouble operator-() const {
         DerivativeMap neg_derivs;
-        for (const auto& [id, deriv] : derivatives_) {
+        for (const auto& [id, deriv] : linked_derivatives()) {
             neg_derivs[id] = -deriv;
         }
         return udouble(-nominal_, std::move(neg_derivs));
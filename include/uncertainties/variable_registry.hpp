@@ -8,24 +8,217 @@
  * variables, indexed by unique IDs. This enables correlation tracking by
  * allowing derived values to store partial derivatives with respect to
  * original variables rather than accumulated uncertainties.
+ *
+ * The top ID_NAMESPACE_BITS bits of an ID are a namespace prefix, which is
+ * 0 unless set_id_namespace() picked another one. Processes or nodes that
+ * use distinct namespaces allocate disjoint IDs, so their values can be
+ * merged (see distributed.hpp).
+ *
+ * Optionally, IDs and stddevs live in a SharedRegistryTable placed in
+ * shared memory (see shared_registry.hpp). All processes attached to it then
+ * share one ID counter and one stddev table. Shared IDs are drawn from the
+ * upper half of the local ID range, so they never collide with IDs a
+ * process allocated on its own, and still carry that process's namespace.
  */
 
 #include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <mutex>
+#include <new>
 #include <shared_mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
 
 namespace uncertainties {
 namespace detail {
 
+/**
+ * @brief Lock-free ID → stddev hash table laid out for a shared memory segment.
+ *
+ * Open addressing with linear probing over a power-of-two number of slots
+ * that directly follow this header. A slot is claimed by a CAS that stores
+ * its stddev (EMPTY marks a free slot) and its ID is published afterwards,
+ * so a slot whose ID is visible is complete and lookups never wait. Only an
+ * insert that meets a slot whose ID is not published yet waits for it, for
+ * at most CLAIM_TIMEOUT, in case a process died in between. Entries are
+ * never removed, so lookups need no locks. `next_id` counts shared IDs
+ * handed out so far; VariableRegistry maps it into its ID space.
+ */
+struct SharedRegistryTable {
+    static constexpr uint64_t MAGIC = 0x31677274636e7575;  ///< Set once initialized
+    static constexpr uint64_t EMPTY = ~uint64_t{0};        ///< Stddev bits of a free slot (a NaN)
+    /// Longest wait for the ID of a claimed slot
+    static constexpr std::chrono::milliseconds CLAIM_TIMEOUT{1000};
+
+    struct Slot {
+        std::atomic<uint64_t> id;
+        std::atomic<uint64_t> sigma_bits;
+    };
+
+    std::atomic<uint64_t> magic;
+    uint64_t slot_count;
+    std::atomic<uint64_t> next_id;
+    std::atomic<uint64_t> generation;
+    std::atomic<uint64_t> size;
+
+    /** @brief Bytes needed for a table with `slots` slots. */
+    static constexpr std::size_t bytes(uint64_t slots) noexcept {
+        return sizeof(SharedRegistryTable) + static_cast<std::size_t>(slots) * sizeof(Slot);
+    }
+
+    /** @brief Construct an empty table with `slots` slots (a power of two) at `memory`. */
+    static SharedRegistryTable* create(void* memory, uint64_t slots) noexcept {
+        auto* table = new (memory) SharedRegistryTable;
+        table->slot_count = slots;
+        table->next_id.store(0, std::memory_order_relaxed);
+        table->generation.store(0, std::memory_order_relaxed);
+        table->size.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < slots; ++i) {
+            new (&table->slots()[i]) Slot;
+        }
+        table->reset_slots();
+        table->magic.store(MAGIC, std::memory_order_release);
+        return table;
+    }
+
+    Slot* slots() noexcept { return reinterpret_cast<Slot*>(this + 1); }
+    const Slot* slots() const noexcept { return reinterpret_cast<const Slot*>(this + 1); }
+
+    /**
+     * @brief Insert `id` unless it is present with the same stddev.
+     * @throws std::invalid_argument if `sigma` is NaN
+     * @throws std::runtime_error if the table is full, if `id` is present
+     *         with a different stddev, or if a slot on the way stays
+     *         claimed without an ID for CLAIM_TIMEOUT
+     */
+    void insert(uint64_t id, double sigma) {
+        const uint64_t bits = sigma_bits_of(sigma);
+        const uint64_t mask = slot_count - 1;
+        for (uint64_t probe = 0, i = hash(id) & mask; probe < slot_count; ++probe, i = (i + 1) & mask) {
+            Slot& slot = slots()[i];
+            uint64_t current = slot.id.load(std::memory_order_acquire);
+            if (current == 0) {
+                uint64_t expected = EMPTY;
+                if (slot.sigma_bits.compare_exchange_strong(expected, bits, std::memory_order_acq_rel)) {
+                    slot.id.store(id, std::memory_order_release);
+                    size.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                // Claimed by another insert, possibly of the same ID
+                current = wait_for_id(slot);
+            }
+            if (current == id) {
+                if (slot.sigma_bits.load(std::memory_order_acquire) != bits) {
+                    throw std::runtime_error("Atomic ID " + std::to_string(id) +
+                                             " is already in the shared registry with a different stddev.");
+                }
+                return;
+            }
+        }
+        throw std::runtime_error("Shared variable registry is full.");
+    }
+
+    /** @brief Slot holding `id`, or nullptr. */
+    Slot* find(uint64_t id) noexcept {
+        const uint64_t mask = slot_count - 1;
+        for (uint64_t probe = 0, i = hash(id) & mask; probe < slot_count; ++probe, i = (i + 1) & mask) {
+            const Slot& slot = slots()[i];
+            uint64_t current = slot.id.load(std::memory_order_acquire);
+            if (current == id) {
+                return &slots()[i];
+            }
+            // A claimed slot without an ID may precede later entries
+            if (current == 0 && slot.sigma_bits.load(std::memory_order_acquire) == EMPTY) {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    /** @brief Stddev of `id` if present. */
+    bool lookup(uint64_t id, double& sigma) noexcept {
+        Slot* slot = find(id);
+        if (slot == nullptr) {
+            return false;
+        }
+        sigma = from_bits(slot->sigma_bits.load(std::memory_order_acquire));
+        return true;
+    }
+
+    /** @brief Empty every slot (not safe against concurrent use). */
+    void reset_slots() noexcept {
+        for (uint64_t i = 0; i < slot_count; ++i) {
+            slots()[i].id.store(0, std::memory_order_relaxed);
+            slots()[i].sigma_bits.store(EMPTY, std::memory_order_release);
+        }
+        size.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Bits stored for `sigma`.
+     * @throws std::invalid_argument if `sigma` is NaN, which could match EMPTY
+     */
+    static uint64_t sigma_bits_of(double sigma) {
+        if (std::isnan(sigma)) {
+            throw std::invalid_argument("Standard deviation cannot be NaN.");
+        }
+        return to_bits(sigma);
+    }
+
+    /**
+     * @brief ID of a claimed slot, once its claimer publishes it.
+     * @throws std::runtime_error after CLAIM_TIMEOUT, e.g. if the claimer died
+     */
+    static uint64_t wait_for_id(const Slot& slot) {
+        const auto deadline = std::chrono::steady_clock::now() + CLAIM_TIMEOUT;
+        for (unsigned spins = 0;; ++spins) {
+            uint64_t id = slot.id.load(std::memory_order_acquire);
+            if (id != 0) {
+                return id;
+            }
+            if (spins >= 64) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    throw std::runtime_error("Shared registry slot was never completed; "
+                                             "the process writing it may have died.");
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    static uint64_t hash(uint64_t id) noexcept {
+        id ^= id >> 30;
+        id *= 0xbf58476d1ce4e5b9ULL;
+        id ^= id >> 27;
+        id *= 0x94d049bb133111ebULL;
+        return id ^ (id >> 31);
+    }
+
+    static uint64_t to_bits(double value) noexcept {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static double from_bits(uint64_t bits) noexcept {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
 /**
  * @class VariableRegistry
  * @brief Thread-safe singleton registry for atomic variable uncertainties.
  *
  * Each atomic udouble (one created with an explicit stddev) is assigned a
- * unique ID and its original stddev is stored in this registry. Derived
+ * unique ID, and its original stddev is stored in this registry once the
+ * atomic first contributes to a derived value. Derived
  * values store partial derivatives with respect to these atomic variables,
  * and compute their final uncertainty by combining derivatives with the
  * original stddevs from this registry.
@@ -41,18 +234,182 @@ public:
         return registry;
     }
 
+    /// Bits of an ID holding its namespace
+    static constexpr unsigned ID_NAMESPACE_BITS = 16;
+    /// Bits of an ID local to its namespace
+    static constexpr unsigned LOCAL_ID_BITS = 64 - ID_NAMESPACE_BITS;
+    /// Largest namespace
+    static constexpr uint64_t MAX_ID_NAMESPACE = (uint64_t{1} << ID_NAMESPACE_BITS) - 1;
+
+    /** @brief Namespace prefix of an ID. */
+    static constexpr uint64_t namespace_of(uint64_t id) noexcept { return id >> LOCAL_ID_BITS; }
+
+    /** @brief Part of an ID below its namespace prefix. */
+    static constexpr uint64_t local_part(uint64_t id) noexcept {
+        return id & ((uint64_t{1} << LOCAL_ID_BITS) - 1);
+    }
+
+    /// First local part of IDs allocated from a shared table
+    static constexpr uint64_t SHARED_ID_BASE = uint64_t{1} << (LOCAL_ID_BITS - 1);
+
+    /** @brief Whether `id` was allocated from a shared table. */
+    static constexpr bool is_shared_id(uint64_t id) noexcept { return local_part(id) >= SHARED_ID_BASE; }
+
+    /**
+     * @brief Allocate future IDs in namespace `ns`.
+     * @param ns Namespace, e.g. a node or worker index
+     * @throws std::invalid_argument if ns > MAX_ID_NAMESPACE
+     *
+     * IDs allocated so far stay valid. The local counter carries over, so
+     * switching back to an earlier namespace never reissues an ID. The
+     * namespace belongs to this process even while a shared table is
+     * attached.
+     */
+    void set_id_namespace(uint64_t ns) {
+        if (ns > MAX_ID_NAMESPACE) {
+            throw std::invalid_argument("ID namespace out of range.");
+        }
+        uint64_t current = next_id_.load(std::memory_order_relaxed);
+        while (!next_id_.compare_exchange_weak(current, (ns << LOCAL_ID_BITS) | local_part(current),
+                                               std::memory_order_relaxed)) {
+        }
+    }
+
+    /** @brief Namespace new IDs are allocated in. */
+    uint64_t id_namespace() const noexcept {
+        return namespace_of(next_id_.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Make sure `id` is never allocated again.
+     *
+     * Used for IDs imported from elsewhere: if `id` lies in the current
+     * namespace at or beyond the next local ID, allocation skips past it.
+     * Shared IDs advance the counter of the attached shared table instead.
+     */
+    void reserve_through(uint64_t id) noexcept {
+        if (is_shared_id(id)) {
+            if (SharedTableRef table{*this}) {
+                uint64_t next = local_part(id) - SHARED_ID_BASE + 1;
+                uint64_t current = table->next_id.load(std::memory_order_relaxed);
+                while (current < next &&
+                       !table->next_id.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+                }
+            }
+            return;
+        }
+        uint64_t current = next_id_.load(std::memory_order_relaxed);
+        while (namespace_of(id) == namespace_of(current) && id >= current &&
+               !next_id_.compare_exchange_weak(current, id + 1, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Record that IDs in namespace `ns` come from the writer `origin`.
+     * @return false if a different writer claimed `ns` before
+     *
+     * Used when importing values: two writers allocating in one namespace
+     * hand out the same IDs for unrelated atomics.
+     */
+    bool claim_namespace(uint64_t ns, uint64_t origin) {
+        std::unique_lock lock(mutex_);
+        return namespace_owners_.try_emplace(ns, origin).first->second == origin;
+    }
+
     /**
      * @brief Register a new atomic variable.
      * @param stddev The standard deviation of the variable
      * @return Unique ID for this variable
      */
     uint64_t register_variable(double stddev) {
-        uint64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t id = reserve_id();
+        if (SharedTableRef table{*this, id}) {
+            table->insert(id, stddev);
+            return id;
+        }
         std::unique_lock lock(mutex_);
         stddevs_[id] = stddev;
         return id;
     }
 
+    /**
+     * @brief Reserve a unique ID without registering a stddev for it.
+     * @return Unique ID, to be passed to register_id() before use
+     *
+     * This is lock-free. Atomic udoubles reserve their ID on construction
+     * and register it only when the ID first appears in a derived value.
+     */
+    uint64_t reserve_id() noexcept {
+        return reserve_ids(1);
+    }
+
+    /**
+     * @brief Reserve `count` consecutive IDs without registering them.
+     * @param count Number of IDs to reserve
+     * @return The first ID; the block is [first, first + count)
+     */
+    uint64_t reserve_ids(uint64_t count) noexcept {
+        if (SharedTableRef table{*this}) {
+            uint64_t ns = namespace_of(next_id_.load(std::memory_order_relaxed));
+            uint64_t first = table->next_id.fetch_add(count, std::memory_order_relaxed);
+            return (ns << LOCAL_ID_BITS) | (SHARED_ID_BASE + first);
+        }
+        return next_id_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Register the stddevs of a block of reserved IDs under one lock.
+     * @param first_id First ID of a block obtained from reserve_ids()
+     * @param stddevs Standard deviations of IDs first_id, first_id + 1, ...
+     * @param count Number of IDs in the block
+     *
+     * Entries with zero stddev are skipped; IDs that are already registered
+     * keep their current stddev.
+     * @throws std::runtime_error if a shared ID is already registered with a
+     *         different stddev
+     */
+    void register_ids(uint64_t first_id, const double* stddevs, uint64_t count) {
+        if (SharedTableRef table{*this, first_id}) {
+            for (uint64_t i = 0; i < count; ++i) {
+                if (stddevs[i] > 0.0) {
+                    table->insert(first_id + i, stddevs[i]);
+                }
+            }
+            return;
+        }
+        std::unique_lock lock(mutex_);
+        for (uint64_t i = 0; i < count; ++i) {
+            if (stddevs[i] > 0.0) {
+                stddevs_.try_emplace(first_id + i, stddevs[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Register the stddev of a previously reserved ID.
+     * @param id ID obtained from reserve_id()
+     * @param stddev The standard deviation of the variable
+     *
+     * Registering an ID that is already present has no effect, so copies
+     * of the same atomic can each register it.
+     * @throws std::runtime_error if a shared ID is already registered with a
+     *         different stddev
+     */
+    void register_id(uint64_t id, double stddev) {
+        if (SharedTableRef table{*this, id}) {
+            table->insert(id, stddev);
+            return;
+        }
+        {
+            std::shared_lock lock(mutex_);
+            if (stddevs_.count(id) != 0) {
+                return;
+            }
+        }
+        std::unique_lock lock(mutex_);
+        stddevs_.try_emplace(id, stddev);
+    }
+
     /**
      * @brief Get the original stddev for a variable ID.
      * @param id The variable ID
@@ -60,21 +417,93 @@ public:
      * @throws std::runtime_error if ID is not found
      */
     double get_stddev(uint64_t id) const {
+        double stddev;
+        if (!try_get_stddev(id, stddev)) {
+            throw std::runtime_error("Unknown variable ID in registry");
+        }
+        return stddev;
+    }
+
+    /**
+     * @brief Look up the stddev for a variable ID if it is registered.
+     * @param id The variable ID
+     * @param stddev Receives the standard deviation if found
+     * @return true if the ID is registered
+     */
+    bool try_get_stddev(uint64_t id, double& stddev) const {
+        if (SharedTableRef table{*this, id}) {
+            return table->lookup(id, stddev);
+        }
         std::shared_lock lock(mutex_);
         auto it = stddevs_.find(id);
+        if (it == stddevs_.end()) {
+            return false;
+        }
+        stddev = it->second;
+        return true;
+    }
+
+    /**
+     * @brief Change the stddev of a registered variable.
+     * @param id The variable ID
+     * @param stddev The new standard deviation (must be non-negative)
+     * @throws std::invalid_argument if stddev is negative, or NaN for a
+     *         shared ID
+     * @throws std::runtime_error if ID is not found
+     *
+     * Every value depending on the variable sees the new stddev; cached
+     * uncertainties are invalidated through generation().
+     */
+    void set_stddev(uint64_t id, double stddev) {
+        if (stddev < 0.0) {
+            throw std::invalid_argument("Standard deviation cannot be negative.");
+        }
+        if (SharedTableRef table{*this, id}) {
+            if (auto* slot = table->find(id)) {
+                slot->sigma_bits.store(SharedRegistryTable::sigma_bits_of(stddev), std::memory_order_release);
+                table->generation.fetch_add(1, std::memory_order_release);
+                return;
+            }
+        }
+        std::unique_lock lock(mutex_);
+        auto it = stddevs_.find(id);
         if (it == stddevs_.end()) {
             throw std::runtime_error("Unknown variable ID in registry");
         }
-        return it->second;
+        it->second = stddev;
+        generation_.fetch_add(1, std::memory_order_release);
     }
 
     /**
-     * @brief Clear all registrations (for testing purposes).
+     * @brief Counter bumped whenever a registered stddev changes or is removed.
+     *
+     * Registering new IDs does not change it. udouble caches its stddev
+     * together with the generation it was computed in. With a shared table
+     * attached, changes made by other processes count as well.
+     */
+    uint64_t generation() const noexcept {
+        uint64_t local = generation_.load(std::memory_order_acquire);
+        SharedTableRef table{*this};
+        return table ? local + table->generation.load(std::memory_order_acquire) : local;
+    }
+
+    /**
+     * @brief Clear all registrations and return to namespace 0 (for testing purposes).
+     *
+     * An attached shared table is detached and released first. Its entries
+     * stay as they are, since other processes may still be using them.
      */
     void clear() {
+        if (SharedRegistryTable* table = detach_shared()) {
+            if (release_shared_ != nullptr) {
+                release_shared_(table);
+            }
+        }
         std::unique_lock lock(mutex_);
         stddevs_.clear();
+        namespace_owners_.clear();
         next_id_.store(1, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
     }
 
     /**
@@ -82,8 +511,61 @@ public:
      * @return Number of variables in the registry
      */
     size_t size() const {
+        SharedTableRef table{*this};
         std::shared_lock lock(mutex_);
-        return stddevs_.size();
+        return stddevs_.size() + (table ? table->size.load(std::memory_order_relaxed) : 0);
+    }
+
+    /// Unmaps a shared table once it is detached
+    using SharedTableRelease = void (*)(SharedRegistryTable*);
+
+    /**
+     * @brief Allocate IDs from and register stddevs in `table` from now on.
+     * @param table The table to attach
+     * @param release Called by clear() with the table after detaching it
+     *
+     * Low-level hook behind attach_shared_registry(). IDs reserved so far
+     * lie below SHARED_ID_BASE and keep using the local map, so they never
+     * meet an ID another process allocated from the table.
+     */
+    void attach_shared(SharedRegistryTable* table, SharedTableRelease release = nullptr) noexcept {
+        generation_.fetch_add(1, std::memory_order_release);
+        release_shared_ = release;
+        shared_.store(table, std::memory_order_release);
+    }
+
+    /**
+     * @brief Return to the process-local table.
+     * @return The table that was attached, or nullptr
+     *
+     * Values depending on atomics registered in the shared table can no
+     * longer compute their uncertainty afterwards. Waits until no other
+     * thread uses the table, so the caller may unmap it on return.
+     */
+    SharedRegistryTable* detach_shared() noexcept {
+        SharedRegistryTable* table = shared_.exchange(nullptr, std::memory_order_seq_cst);
+        if (table != nullptr) {
+            for (const SharedReader* reader = readers_.load(std::memory_order_acquire); reader != nullptr;
+                 reader = reader->next) {
+                while (reader->table.load(std::memory_order_seq_cst) == table) {
+                    std::this_thread::yield();
+                }
+            }
+            // Keep generation() monotonic
+            generation_.fetch_add(table->generation.load(std::memory_order_acquire) + 1,
+                                  std::memory_order_release);
+        }
+        return table;
+    }
+
+    /**
+     * @brief Attached shared table, or nullptr.
+     *
+     * Only for checking whether a table is attached: another thread may
+     * detach and unmap it at any time.
+     */
+    SharedRegistryTable* shared() const noexcept {
+        return shared_.load(std::memory_order_acquire);
     }
 
     // Prevent copying
@@ -93,9 +575,106 @@ public:
 private:
     VariableRegistry() = default;
 
+    /**
+     * @brief The shared table one thread is using, if any.
+     *
+     * Each thread publishes its pin in a record of its own, so pinning never
+     * contends with other threads; detach_shared() scans all records.
+     * Records are never freed; those of exited threads are reused.
+     */
+    struct alignas(64) SharedReader {
+        std::atomic<SharedRegistryTable*> table{nullptr};  ///< Pinned table
+        std::atomic<bool> in_use{true};                    ///< Owned by a live thread
+        SharedReader* next = nullptr;
+        unsigned depth = 0;  ///< Nested pins; only touched by the owning thread
+    };
+
+    /** @brief Record of the calling thread. */
+    SharedReader& this_thread_reader() const {
+        struct Owner {
+            SharedReader* reader;
+            ~Owner() { reader->in_use.store(false, std::memory_order_release); }
+        };
+        thread_local Owner owner{acquire_reader()};
+        return *owner.reader;
+    }
+
+    /** @brief Reuse the record of an exited thread, or add one. */
+    SharedReader* acquire_reader() const {
+        for (SharedReader* reader = readers_.load(std::memory_order_acquire); reader != nullptr;
+             reader = reader->next) {
+            bool free = false;
+            if (reader->in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                return reader;
+            }
+        }
+        auto* reader = new SharedReader;
+        reader->next = readers_.load(std::memory_order_relaxed);
+        while (!readers_.compare_exchange_weak(reader->next, reader, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+        }
+        return reader;
+    }
+
+    /**
+     * @brief Pins the attached shared table, if any, so detach_shared() waits for it.
+     *
+     * Given an ID, it only pins the table for shared IDs; other IDs always
+     * live in the local map.
+     */
+    class SharedTableRef {
+    public:
+        explicit SharedTableRef(const VariableRegistry& registry) noexcept
+            : SharedTableRef(registry, true) {}
+
+        SharedTableRef(const VariableRegistry& registry, uint64_t id) noexcept
+            : SharedTableRef(registry, is_shared_id(id)) {}
+
+        ~SharedTableRef() {
+            if (reader_ != nullptr && --reader_->depth == 0) {
+                reader_->table.store(nullptr, std::memory_order_release);
+            }
+        }
+
+        SharedTableRef(const SharedTableRef&) = delete;
+        SharedTableRef& operator=(const SharedTableRef&) = delete;
+
+        explicit operator bool() const noexcept { return table_ != nullptr; }
+        SharedRegistryTable* operator->() const noexcept { return table_; }
+
+    private:
+        SharedTableRef(const VariableRegistry& registry, bool pin) noexcept {
+            SharedRegistryTable* table = pin ? registry.shared_.load(std::memory_order_acquire) : nullptr;
+            if (table == nullptr) {
+                return;
+            }
+            reader_ = &registry.this_thread_reader();
+            if (reader_->depth++ == 0) {
+                // Pairs with the exchange in detach_shared(): either detach
+                // sees this pin, or this thread sees the table detached
+                reader_->table.store(table, std::memory_order_seq_cst);
+            }
+            // A nested pin may only use the table the outer one holds
+            if (registry.shared_.load(std::memory_order_seq_cst) == table &&
+                reader_->table.load(std::memory_order_relaxed) == table) {
+                table_ = table;
+            } else if (reader_->depth == 1) {
+                reader_->table.store(nullptr, std::memory_order_release);
+            }
+        }
+
+        SharedReader* reader_ = nullptr;
+        SharedRegistryTable* table_ = nullptr;
+    };
+
+    std::atomic<SharedRegistryTable*> shared_{nullptr};  ///< Attached shared table, if any
+    SharedTableRelease release_shared_ = nullptr;         ///< Unmaps shared_ in clear()
+    mutable std::atomic<SharedReader*> readers_{nullptr};  ///< Pins of all threads
     std::atomic<uint64_t> next_id_{1};  ///< Next available ID (0 reserved)
-    mutable std::shared_mutex mutex_;    ///< Protects stddevs_ map
+    std::atomic<uint64_t> generation_{0};  ///< Bumped on stddev changes and clear()
+    mutable std::shared_mutex mutex_;    ///< Protects stddevs_ and namespace_owners_
     std::unordered_map<uint64_t, double> stddevs_;  ///< ID -> original stddev
+    std::unordered_map<uint64_t, uint64_t> namespace_owners_;  ///< Namespace -> writer of imported IDs
 };
 
 } // namespace detail
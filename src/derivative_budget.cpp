@@ -0,0 +1,183 @@
+#include "uncertainties/derivative_budget.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace uncertainties {
+
+namespace {
+    struct ThreadBudgetState {
+        DerivativeBudget budget;
+        DerivativeBudgetStats stats;
+        bool active = false;  // true if any limit is set
+    };
+
+    ThreadBudgetState& thread_state() {
+        thread_local ThreadBudgetState state;
+        return state;
+    }
+
+    // Approximate cost of a node of a node-based hash map: the next pointer
+    // plus the key/value pair
+    constexpr std::size_t NODE_BYTES =
+        sizeof(void*) + sizeof(udouble::DerivativeMap::value_type);
+
+    std::size_t map_bytes(std::size_t entries, std::size_t buckets) {
+        return entries * NODE_BYTES + buckets * sizeof(void*);
+    }
+
+    // Bucket count an empty map gets from reserve(entries), the way
+    // prune_to() builds its result, computed without allocating
+    std::size_t reserved_bucket_count(std::size_t entries) {
+#if defined(__GLIBCXX__)
+        // The map's own next-prime policy at the default load factor 1
+        return std::__detail::_Prime_rehash_policy()._M_next_bkt(std::max<std::size_t>(entries, 1));
+#else
+        // Upper bound: the next prime (or power of two) is below 2n
+        return 2 * std::max<std::size_t>(entries, 1);
+#endif
+    }
+
+    // Number of entries the budget allows, taking both limits into account
+    std::size_t allowed_entries(const DerivativeBudget& budget) {
+        std::size_t allowed = budget.max_entries;
+        if (budget.max_bytes != 0) {
+            // There are at least as many buckets as entries, which bounds the
+            // count; while the map for that count does not fit, shrink the
+            // count to what fits next to its bucket array. Bucket counts only
+            // shrink with the count, so this ends after a few steps.
+            const std::size_t max_bytes = budget.max_bytes;
+            std::size_t by_bytes = max_bytes / (NODE_BYTES + sizeof(void*));
+            for (;;) {
+                std::size_t buckets = reserved_bucket_count(by_bytes);
+                if (by_bytes == 0 || map_bytes(by_bytes, buckets) <= max_bytes) {
+                    break;
+                }
+                std::size_t bucket_bytes = buckets * sizeof(void*);
+                by_bytes = bucket_bytes >= max_bytes
+                    ? 0 : std::min(by_bytes - 1, (max_bytes - bucket_bytes) / NODE_BYTES);
+            }
+            // Shrinking may have overshot into a smaller bucket count: grow
+            // again while counts up to the next bucket count still fit
+            for (;;) {
+                std::size_t buckets = reserved_bucket_count(by_bytes + 1);
+                std::size_t bucket_bytes = buckets * sizeof(void*);
+                if (bucket_bytes >= max_bytes) {
+                    break;
+                }
+                std::size_t fits = std::min(buckets, (max_bytes - bucket_bytes) / NODE_BYTES);
+                if (fits <= by_bytes || map_bytes(fits, reserved_bucket_count(fits)) > max_bytes) {
+                    break;
+                }
+                by_bytes = fits;
+            }
+            allowed = (allowed == 0) ? by_bytes : std::min(allowed, by_bytes);
+        }
+        return allowed;
+    }
+
+    // Keep the `keep` entries with the largest variance contribution
+    std::size_t prune_to(udouble::DerivativeMap& derivs, std::size_t keep) {
+        const auto& registry = detail::VariableRegistry::instance();
+
+        std::vector<std::pair<double, uint64_t>> contributions;
+        contributions.reserve(derivs.size());
+        for (const auto& [id, deriv] : derivs) {
+            double contribution = deriv * registry.get_stddev(id);
+            contributions.emplace_back(contribution * contribution, id);
+        }
+
+        auto nth = contributions.begin() + static_cast<std::ptrdiff_t>(keep);
+        std::nth_element(contributions.begin(), nth, contributions.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        udouble::DerivativeMap kept;
+        kept.reserve(keep);
+        for (auto it = contributions.begin(); it != nth; ++it) {
+            kept.emplace(it->second, derivs.at(it->second));
+        }
+
+        std::size_t removed = derivs.size() - kept.size();
+        derivs = std::move(kept);
+        return removed;
+    }
+}
+
+void set_derivative_budget(const DerivativeBudget& budget)
+{
+    auto& state = thread_state();
+    state.budget = budget;
+    state.active = budget.max_entries != 0 || budget.max_bytes != 0;
+}
+
+const DerivativeBudget& derivative_budget()
+{
+    return thread_state().budget;
+}
+
+DerivativeBudgetStats derivative_budget_stats()
+{
+    return thread_state().stats;
+}
+
+void reset_derivative_budget_stats()
+{
+    thread_state().stats = DerivativeBudgetStats{};
+}
+
+namespace detail {
+
+std::size_t estimate_map_bytes(const udouble::DerivativeMap& derivs)
+{
+    return map_bytes(derivs.size(), derivs.bucket_count());
+}
+
+void enforce_derivative_budget(udouble::DerivativeMap& derivs)
+{
+    auto& state = thread_state();
+    if (!state.active) {
+        return;
+    }
+
+    const DerivativeBudget& budget = state.budget;
+    std::size_t entries = derivs.size();
+    std::size_t bytes = estimate_map_bytes(derivs);
+
+    bool over_entries = budget.max_entries != 0 && entries > budget.max_entries;
+    bool over_bytes = budget.max_bytes != 0 && bytes > budget.max_bytes;
+    if (!over_entries && !over_bytes) {
+        return;
+    }
+
+    ++state.stats.exceeded;
+    switch (budget.action) {
+        case BudgetAction::Throw:
+            ++state.stats.thrown;
+            throw derivative_budget_exceeded(entries, bytes);
+        case BudgetAction::Prune:
+            ++state.stats.pruned;
+            state.stats.entries_pruned +=
+                prune_to(derivs, std::min(entries, allowed_entries(budget)));
+            break;
+        case BudgetAction::Callback:
+            ++state.stats.callbacks;
+            if (budget.callback) {
+                budget.callback(entries, bytes);
+            }
+            break;
+    }
+}
+
+void merge_derivative_budget_stats(const DerivativeBudgetStats& stats)
+{
+    auto& total = thread_state().stats;
+    total.exceeded += stats.exceeded;
+    total.thrown += stats.thrown;
+    total.pruned += stats.pruned;
+    total.callbacks += stats.callbacks;
+    total.entries_pruned += stats.entries_pruned;
+}
+
+} // namespace detail
+
+} // namespace uncertainties
@@ -0,0 +1,191 @@
+#include "uncertainties/distributed.hpp"
+#include "uncertainties/variable_registry.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define UNCERTAINTIES_HAVE_GETPID 1
+#endif
+
+namespace uncertainties {
+
+namespace {
+
+constexpr const char* FORMAT_TAG = "uncertainties-udouble-v1";
+
+std::string hex(double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    return buffer;
+}
+
+std::string read_token(std::istream& in) {
+    std::string token;
+    if (!(in >> token)) {
+        throw std::runtime_error("deserialize: unexpected end of input.");
+    }
+    return token;
+}
+
+void expect_token(std::istream& in, const char* expected) {
+    if (read_token(in) != expected) {
+        throw std::runtime_error(std::string("deserialize: expected '") + expected + "'.");
+    }
+}
+
+double read_double(std::istream& in) {
+    std::string token = read_token(in);
+    char* end = nullptr;
+    double value = std::strtod(token.c_str(), &end);
+    if (end != token.c_str() + token.size()) {
+        throw std::runtime_error("deserialize: malformed number '" + token + "'.");
+    }
+    return value;
+}
+
+// Identifies the writing process in stream headers, so that a process
+// reading its own output is not taken for a colliding writer. Forked
+// children inherit the random part but have a different pid.
+uint64_t process_origin() {
+    static const uint64_t seed = [] {
+        std::random_device device;
+        return (static_cast<uint64_t>(device()) << 32) ^ device();
+    }();
+#ifdef UNCERTAINTIES_HAVE_GETPID
+    return seed ^ (static_cast<uint64_t>(getpid()) * 0x9e3779b97f4a7c15ULL);
+#else
+    return seed;
+#endif
+}
+
+uint64_t read_unsigned(std::istream& in) {
+    std::string token = read_token(in);
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(token.c_str(), &end, 10);
+    if (token.empty() || token[0] == '-' || end != token.c_str() + token.size()) {
+        throw std::runtime_error("deserialize: malformed integer '" + token + "'.");
+    }
+    return static_cast<uint64_t>(value);
+}
+
+} // namespace
+
+void set_id_namespace(uint64_t ns) {
+    detail::VariableRegistry::instance().set_id_namespace(ns);
+}
+
+uint64_t id_namespace() {
+    return detail::VariableRegistry::instance().id_namespace();
+}
+
+void serialize(std::ostream& out, const std::vector<udouble>& values)
+{
+    const auto& registry = detail::VariableRegistry::instance();
+    // Ordered, so the output does not depend on hash order
+    std::map<uint64_t, double> atomics;
+    for (const auto& value : values) {
+        for (const auto& [id, deriv] : value.derivatives()) {
+            atomics.try_emplace(id, registry.get_stddev(id));
+        }
+    }
+
+    out << FORMAT_TAG << '\n'
+        << "writer " << registry.id_namespace() << ' ' << process_origin() << '\n'
+        << "atomics " << atomics.size() << '\n';
+    for (const auto& [id, sigma] : atomics) {
+        out << id << ' ' << hex(sigma) << '\n';
+    }
+    out << "values " << values.size() << '\n';
+    for (const auto& value : values) {
+        const auto& derivatives = value.derivatives();
+        out << hex(value.nominal_value()) << ' ' << derivatives.size();
+        for (const auto& [id, deriv] : derivatives) {
+            out << ' ' << id << ' ' << hex(deriv);
+        }
+        out << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("serialize: write failed.");
+    }
+}
+
+std::vector<udouble> deserialize(std::istream& in)
+{
+    auto& registry = detail::VariableRegistry::instance();
+    expect_token(in, FORMAT_TAG);
+
+    // Optional writer line: the writer's namespace and process
+    std::string token = read_token(in);
+    bool foreign = false;
+    uint64_t writer_namespace = 0;
+    uint64_t writer_origin = 0;
+    if (token == "writer") {
+        writer_namespace = read_unsigned(in);
+        writer_origin = read_unsigned(in);
+        foreign = writer_origin != process_origin();
+        token = read_token(in);
+    }
+    if (token != "atomics") {
+        throw std::runtime_error("deserialize: expected 'atomics'.");
+    }
+
+    uint64_t atomics = read_unsigned(in);
+    bool claimed = false;
+    for (uint64_t k = 0; k < atomics; ++k) {
+        uint64_t id = read_unsigned(in);
+        double sigma = read_double(in);
+        // Atomics another process created in its own namespace may share IDs
+        // with atomics of this process or of another writer, whatever their
+        // stddevs, unless the namespace is theirs alone. Shared-registry IDs
+        // come from one counter and never collide.
+        if (foreign && detail::VariableRegistry::namespace_of(id) == writer_namespace &&
+            !detail::VariableRegistry::is_shared_id(id)) {
+            if (writer_namespace == registry.id_namespace() ||
+                (!claimed && !registry.claim_namespace(writer_namespace, writer_origin))) {
+                throw std::runtime_error("deserialize: atomic ID " + std::to_string(id) +
+                                         " may collide with an atomic of another process in namespace " +
+                                         std::to_string(writer_namespace) +
+                                         "; give every process its own ID namespace.");
+            }
+            claimed = true;
+        }
+        double existing = 0.0;
+        if (registry.try_get_stddev(id, existing) && existing != sigma) {
+            throw std::runtime_error("deserialize: atomic ID " + std::to_string(id) +
+                                     " collides with a local atomic of different stddev; "
+                                     "give every process its own ID namespace.");
+        }
+        registry.register_id(id, sigma);
+        registry.reserve_through(id);
+    }
+
+    expect_token(in, "values");
+    uint64_t count = read_unsigned(in);
+    std::vector<udouble> values;
+    values.reserve(count);
+    for (uint64_t k = 0; k < count; ++k) {
+        double nominal = read_double(in);
+        uint64_t terms = read_unsigned(in);
+        udouble::DerivativeMap derivatives;
+        derivatives.reserve(terms);
+        for (uint64_t t = 0; t < terms; ++t) {
+            uint64_t id = read_unsigned(in);
+            double deriv = read_double(in);
+            double sigma = 0.0;
+            if (!registry.try_get_stddev(id, sigma)) {
+                throw std::runtime_error("deserialize: value depends on undeclared atomic ID " +
+                                         std::to_string(id) + ".");
+            }
+            derivatives[id] = deriv;
+        }
+        values.push_back(udouble::from_derivatives(nominal, std::move(derivatives)));
+    }
+    return values;
+}
+
+} // namespace uncertainties
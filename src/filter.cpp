@@ -0,0 +1,281 @@
+#include "uncertainties/filter.hpp"
+#include "uncertainties/parallel.hpp"
+#include "uncertainties/running_derivatives.hpp"
+#include "uncertainties/variable_registry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace uncertainties {
+
+namespace {
+
+// Outputs per thread below which threading does not pay off
+constexpr std::size_t MIN_OUTPUTS_PER_THREAD = 1024;
+
+// Exponential smoothing drops entries contributing at most this fraction of
+// an output's variance, so the running map stays bounded
+constexpr double NEGLIGIBLE_VARIANCE = 1e-32;
+
+// σ² of every atomic the inputs depend on. `uncorrelated` is set if no
+// atomic appears in two inputs, in which case var(Σ c_i x_i) = Σ c_i² var(x_i).
+struct InputVariances {
+    std::unordered_map<uint64_t, double> of_id;
+    bool uncorrelated = true;
+
+    explicit InputVariances(const std::vector<udouble>& xs) {
+        const auto& registry = detail::VariableRegistry::instance();
+        for (const auto& x : xs) {
+            for (const auto& [id, deriv] : x.derivatives()) {
+                auto [it, inserted] = of_id.try_emplace(id, 0.0);
+                if (inserted) {
+                    double sigma = registry.get_stddev(id);
+                    it->second = sigma * sigma;
+                } else {
+                    uncorrelated = false;
+                }
+            }
+        }
+    }
+};
+
+// out[k] = Σ_{i in band(k)} taps[i - (k + offset) + w - 1] * x[i], i.e. the
+// convolution with the reversed taps, so both arrays are read forwards.
+void convolve_dense(const std::vector<double>& x, const std::vector<double>& reversed_taps,
+                    std::size_t offset, std::vector<double>& out, std::size_t threads)
+{
+    const std::size_t n = x.size();
+    const std::size_t w = reversed_taps.size();
+    detail::parallel_for(out.size(), threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t k = begin; k < end; ++k) {
+            std::size_t m = k + offset;
+            std::size_t lo = m + 1 >= w ? m + 1 - w : 0;
+            std::size_t hi = std::min(n, m + 1);
+            const double* taps = reversed_taps.data() + (lo + w - 1 - m);
+            const double* xs = x.data() + lo;
+            double sum = 0.0;
+            for (std::size_t j = 0; j < hi - lo; ++j) {
+                sum += taps[j] * xs[j];
+            }
+            out[k] = sum;
+        }
+    });
+}
+
+} // namespace
+
+std::size_t FilterResult::band_begin(std::size_t k) const noexcept {
+    if (kind_ == Kind::Exponential) {
+        return k + 1 >= tail_ ? k + 1 - tail_ : 0;
+    }
+    std::size_t m = k + offset_;
+    return m + 1 >= kernel_.size() ? m + 1 - kernel_.size() : 0;
+}
+
+std::size_t FilterResult::band_end(std::size_t k) const noexcept {
+    if (kind_ == Kind::Exponential) {
+        return k + 1;
+    }
+    return std::min(inputs_.size(), k + offset_ + 1);
+}
+
+double FilterResult::coefficient(std::size_t k, std::size_t i) const noexcept {
+    if (k >= size() || i < band_begin(k) || i >= band_end(k)) {
+        return 0.0;
+    }
+    if (kind_ == Kind::Exponential) {
+        double decay = std::pow(1.0 - alpha_, static_cast<double>(k - i));
+        return i == 0 ? decay : alpha_ * decay;
+    }
+    return kernel_[k + offset_ - i];
+}
+
+udouble FilterResult::value(std::size_t k) const {
+    if (k >= size()) {
+        throw std::out_of_range("Filter output index out of range");
+    }
+    udouble::DerivativeMap derivatives;
+    for (std::size_t i = band_begin(k); i < band_end(k); ++i) {
+        double c = coefficient(k, i);
+        for (const auto& [id, deriv] : inputs_[i].derivatives()) {
+            derivatives[id] += c * deriv;
+        }
+    }
+    return udouble::from_derivatives(nominals_[k], std::move(derivatives));
+}
+
+std::vector<udouble> FilterResult::values() const {
+    std::vector<udouble> out(size());
+    std::size_t threads = detail::resolve_thread_count(threads_, size(), MIN_OUTPUTS_PER_THREAD);
+    detail::parallel_for(size(), threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t k = begin; k < end; ++k) {
+            out[k] = value(k);
+        }
+    });
+    return out;
+}
+
+void FilterResult::compute_fir_stddevs() {
+    stddevs_.assign(size(), 0.0);
+    InputVariances variances(inputs_);
+    std::size_t threads = detail::resolve_thread_count(threads_, size(), MIN_OUTPUTS_PER_THREAD);
+
+    if (variances.uncorrelated) {
+        // Filter the input variances with the squared taps
+        std::vector<double> input_variance(inputs_.size());
+        for (std::size_t i = 0; i < inputs_.size(); ++i) {
+            double sigma = inputs_[i].stddev();
+            input_variance[i] = sigma * sigma;
+        }
+        std::vector<double> squared_taps(kernel_.rbegin(), kernel_.rend());
+        for (double& tap : squared_taps) {
+            tap *= tap;
+        }
+        convolve_dense(input_variance, squared_taps, offset_, stddevs_, threads);
+        for (double& s : stddevs_) {
+            s = std::sqrt(std::max(s, 0.0));
+        }
+        return;
+    }
+
+    // Correlated inputs: merge the band of every output into a scratch map
+    detail::parallel_for(size(), threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        std::unordered_map<uint64_t, double> scratch;
+        for (std::size_t k = begin; k < end; ++k) {
+            scratch.clear();
+            for (std::size_t i = band_begin(k); i < band_end(k); ++i) {
+                double c = kernel_[k + offset_ - i];
+                for (const auto& [id, deriv] : inputs_[i].derivatives()) {
+                    scratch[id] += c * deriv;
+                }
+            }
+            double variance = 0.0;
+            for (const auto& [id, deriv] : scratch) {
+                variance += deriv * deriv * variances.of_id.at(id);
+            }
+            stddevs_[k] = std::sqrt(variance);
+        }
+    });
+}
+
+void FilterResult::compute_exponential_stddevs() {
+    const std::size_t n = inputs_.size();
+    const double decay = 1.0 - alpha_;
+    stddevs_.assign(n, 0.0);
+    InputVariances variances(inputs_);
+
+    if (variances.uncorrelated) {
+        double variance = 0.0;
+        for (std::size_t k = 0; k < n; ++k) {
+            double sigma = inputs_[k].stddev();
+            double weight = k == 0 ? 1.0 : alpha_;
+            variance = decay * decay * variance + weight * weight * sigma * sigma;
+            stddevs_[k] = std::sqrt(variance);
+        }
+        return;
+    }
+
+    // d_k = (1 - α) d_{k-1} + α ∂x_k
+    detail::RunningDerivatives running;
+    for (std::size_t k = 0; k < n; ++k) {
+        if (k == 0 || decay == 0.0) {
+            running.reset();
+            running.add_scaled(inputs_[k], k == 0 ? 1.0 : alpha_);
+        } else {
+            running.scale *= decay;
+            running.add_scaled(inputs_[k], alpha_);
+            running.normalize(NEGLIGIBLE_VARIANCE);
+        }
+        stddevs_[k] = running.stddev();
+    }
+}
+
+FilterResult convolve(const std::vector<udouble>& signal, const std::vector<double>& kernel,
+                      FilterMode mode, const FilterOptions& options)
+{
+    if (kernel.empty()) {
+        throw std::invalid_argument("Convolution kernel must not be empty.");
+    }
+    const std::size_t n = signal.size();
+    const std::size_t w = kernel.size();
+
+    FilterResult result;
+    result.kind_ = FilterResult::Kind::Fir;
+    result.threads_ = options.threads;
+    result.inputs_ = signal;
+    result.kernel_ = kernel;
+
+    std::size_t count = 0;
+    switch (mode) {
+    case FilterMode::Full:
+        count = n > 0 ? n + w - 1 : 0;
+        result.offset_ = 0;
+        break;
+    case FilterMode::Same:
+        count = n;
+        result.offset_ = (w - 1) / 2;
+        break;
+    case FilterMode::Valid:
+        count = n >= w ? n - w + 1 : 0;
+        result.offset_ = w - 1;
+        break;
+    }
+
+    std::vector<double> nominal(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        nominal[i] = signal[i].nominal_value();
+    }
+    std::vector<double> reversed(kernel.rbegin(), kernel.rend());
+    result.nominals_.resize(count);
+    std::size_t threads = detail::resolve_thread_count(options.threads, count, MIN_OUTPUTS_PER_THREAD);
+    convolve_dense(nominal, reversed, result.offset_, result.nominals_, threads);
+
+    result.compute_fir_stddevs();
+    return result;
+}
+
+FilterResult moving_average(const std::vector<udouble>& signal, std::size_t window,
+                            const FilterOptions& options)
+{
+    if (window == 0) {
+        throw std::invalid_argument("Moving average window must be positive.");
+    }
+    std::vector<double> kernel(window, 1.0 / static_cast<double>(window));
+    return convolve(signal, kernel, FilterMode::Valid, options);
+}
+
+FilterResult exponential_smoothing(const std::vector<udouble>& signal, double alpha,
+                                   const FilterOptions& options)
+{
+    if (!(alpha > 0.0 && alpha <= 1.0)) {
+        throw std::invalid_argument("Smoothing factor must be in (0, 1].");
+    }
+    const std::size_t n = signal.size();
+    const double decay = 1.0 - alpha;
+
+    FilterResult result;
+    result.kind_ = FilterResult::Kind::Exponential;
+    result.threads_ = options.threads;
+    result.inputs_ = signal;
+    result.alpha_ = alpha;
+    // Inputs older than the tail weigh less than 1e-17 of the newest one
+    result.tail_ = 1;
+    if (decay > 0.0) {
+        double tail = std::ceil(std::log(1e-17) / std::log(decay)) + 1.0;
+        result.tail_ = static_cast<std::size_t>(std::min(tail, static_cast<double>(std::max<std::size_t>(n, 1))));
+    }
+
+    result.nominals_.resize(n);
+    double y = 0.0;
+    for (std::size_t k = 0; k < n; ++k) {
+        double x = signal[k].nominal_value();
+        y = k == 0 ? x : alpha * x + decay * y;
+        result.nominals_[k] = y;
+    }
+
+    result.compute_exponential_stddevs();
+    return result;
+}
+
+} // namespace uncertainties
@@ -0,0 +1,1258 @@
+#include "uncertainties/formula.hpp"
+#include "uncertainties/parallel.hpp"
+#include "uncertainties/umath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace uncertainties {
+
+using detail::FormulaInstruction;
+using detail::FormulaOp;
+using detail::FormulaTape;
+
+// Records operations on FormulaVar into its tape. Operations on constants
+// only are evaluated with udouble arithmetic so that they behave (and throw)
+// exactly like the udouble code the formula was written for.
+struct FormulaRecorder {
+    static FormulaTape* tape_of(const FormulaVar& lhs, const FormulaVar& rhs) {
+        if (lhs.tape_ && rhs.tape_ && lhs.tape_ != rhs.tape_) {
+            throw std::invalid_argument("FormulaVar operands belong to different formulas.");
+        }
+        return lhs.tape_ ? lhs.tape_ : rhs.tape_;
+    }
+
+    // Record a node, or return the existing identical node. Operands of
+    // commutative operations are ordered so that x*y and y*x coincide.
+    static FormulaVar emit(FormulaTape* tape, FormulaOp op, uint32_t a, uint32_t b = 0,
+                           double constant = 0.0) {
+        if ((op == FormulaOp::Add || op == FormulaOp::Mul || op == FormulaOp::Hypot) && b < a) {
+            std::swap(a, b);
+        }
+        detail::FormulaNode node{op, a, b, constant};
+        auto [it, inserted] = tape->index.try_emplace(node, static_cast<uint32_t>(tape->nodes.size()));
+        if (inserted) {
+            tape->nodes.push_back(node);
+        }
+        return FormulaVar(tape, it->second);
+    }
+
+    static const detail::FormulaNode& node(const FormulaVar& v) {
+        return v.tape_->nodes[v.node_];
+    }
+
+    // Node of a value, recording constants as Const nodes
+    static uint32_t node_of(FormulaTape* tape, const FormulaVar& v) {
+        return v.is_constant() ? emit(tape, FormulaOp::Const, 0, 0, v.value_).node_ : v.node_;
+    }
+
+    template <typename Fold>
+    static FormulaVar unary(FormulaOp op, const FormulaVar& x, Fold fold) {
+        if (x.is_constant()) {
+            return FormulaVar(fold(udouble(x.value_)).nominal_value());
+        }
+        return emit(x.tape_, op, x.node_);
+    }
+
+    template <typename Fold>
+    static FormulaVar binary(FormulaOp op, const FormulaVar& lhs, const FormulaVar& rhs, Fold fold) {
+        FormulaTape* tape = tape_of(lhs, rhs);
+        if (!tape) {
+            return FormulaVar(fold(udouble(lhs.value_), udouble(rhs.value_)).nominal_value());
+        }
+        uint32_t a = node_of(tape, lhs);
+        uint32_t b = node_of(tape, rhs);
+        return emit(tape, op, a, b);
+    }
+
+    static FormulaVar add(const FormulaVar& lhs, const FormulaVar& rhs) {
+        FormulaTape* tape = tape_of(lhs, rhs);
+        if (!tape) {
+            return FormulaVar(lhs.value_ + rhs.value_);
+        }
+        if (lhs.is_constant()) {
+            return add_scalar(rhs, lhs.value_);
+        }
+        if (rhs.is_constant()) {
+            return add_scalar(lhs, rhs.value_);
+        }
+        return emit(tape, FormulaOp::Add, lhs.node_, rhs.node_);
+    }
+
+    static FormulaVar sub(const FormulaVar& lhs, const FormulaVar& rhs) {
+        FormulaTape* tape = tape_of(lhs, rhs);
+        if (!tape) {
+            return FormulaVar(lhs.value_ - rhs.value_);
+        }
+        if (lhs.is_constant()) {
+            return emit(tape, FormulaOp::ScalarSub, rhs.node_, 0, lhs.value_);
+        }
+        if (rhs.is_constant()) {
+            return add_scalar(lhs, -rhs.value_);
+        }
+        return emit(tape, FormulaOp::Sub, lhs.node_, rhs.node_);
+    }
+
+    static FormulaVar mul(const FormulaVar& lhs, const FormulaVar& rhs) {
+        FormulaTape* tape = tape_of(lhs, rhs);
+        if (!tape) {
+            return FormulaVar(lhs.value_ * rhs.value_);
+        }
+        if (lhs.is_constant()) {
+            return mul_scalar(rhs, lhs.value_);
+        }
+        if (rhs.is_constant()) {
+            return mul_scalar(lhs, rhs.value_);
+        }
+        return emit(tape, FormulaOp::Mul, lhs.node_, rhs.node_);
+    }
+
+    static FormulaVar div(const FormulaVar& lhs, const FormulaVar& rhs) {
+        FormulaTape* tape = tape_of(lhs, rhs);
+        if (!tape) {
+            return FormulaVar((udouble(lhs.value_) / udouble(rhs.value_)).nominal_value());
+        }
+        if (rhs.is_constant()) {
+            if (rhs.value_ == 0.0) {
+                throw std::runtime_error("Division by zero in udouble.");
+            }
+            return div_scalar(lhs, rhs.value_);
+        }
+        if (lhs.is_constant()) {
+            return emit(tape, FormulaOp::ScalarDiv, rhs.node_, 0, lhs.value_);
+        }
+        return emit(tape, FormulaOp::Div, lhs.node_, rhs.node_);
+    }
+
+    static FormulaVar power(const FormulaVar& base, const FormulaVar& exponent) {
+        FormulaTape* tape = tape_of(base, exponent);
+        if (!tape) {
+            // udouble's pow is found by ADL
+            return FormulaVar(pow(udouble(base.value_), udouble(exponent.value_)).nominal_value());
+        }
+        if (exponent.is_constant()) {
+            return emit(tape, FormulaOp::PowScalar, base.node_, 0, exponent.value_);
+        }
+        if (base.is_constant()) {
+            if (base.value_ <= 0.0) {
+                throw std::runtime_error("Base of exponentiation (base) must be positive.");
+            }
+            return emit(tape, FormulaOp::ScalarPow, exponent.node_, 0, base.value_);
+        }
+        return emit(tape, FormulaOp::Pow, base.node_, exponent.node_);
+    }
+
+    static FormulaVar neg(const FormulaVar& x) {
+        if (x.is_constant()) {
+            return FormulaVar(-x.value_);
+        }
+        // -(-x) = x
+        if (node(x).op == FormulaOp::Neg) {
+            return FormulaVar(x.tape_, node(x).a);
+        }
+        return emit(x.tape_, FormulaOp::Neg, x.node_);
+    }
+
+    // x + c, dropping c = 0 (exact up to the sign of a zero result)
+    static FormulaVar add_scalar(const FormulaVar& x, double c) {
+        if (c == 0.0) {
+            return x;
+        }
+        return emit(x.tape_, FormulaOp::AddScalar, x.node_, 0, c);
+    }
+
+    // x * c, with x * 1 = x and x * -1 = -x (both exact)
+    static FormulaVar mul_scalar(const FormulaVar& x, double c) {
+        if (c == 1.0) {
+            return x;
+        }
+        if (c == -1.0) {
+            return neg(x);
+        }
+        return emit(x.tape_, FormulaOp::MulScalar, x.node_, 0, c);
+    }
+
+    // x / c, rounded like udouble's division rather than x * (1 / c)
+    static FormulaVar div_scalar(const FormulaVar& x, double c) {
+        if (c == 1.0) {
+            return x;
+        }
+        if (c == -1.0) {
+            return neg(x);
+        }
+        return emit(x.tape_, FormulaOp::DivScalar, x.node_, 0, c);
+    }
+};
+
+FormulaVar operator+(const FormulaVar& lhs, const FormulaVar& rhs) { return FormulaRecorder::add(lhs, rhs); }
+FormulaVar operator-(const FormulaVar& lhs, const FormulaVar& rhs) { return FormulaRecorder::sub(lhs, rhs); }
+FormulaVar operator*(const FormulaVar& lhs, const FormulaVar& rhs) { return FormulaRecorder::mul(lhs, rhs); }
+FormulaVar operator/(const FormulaVar& lhs, const FormulaVar& rhs) { return FormulaRecorder::div(lhs, rhs); }
+FormulaVar operator-(const FormulaVar& x) { return FormulaRecorder::neg(x); }
+
+FormulaVar& FormulaVar::operator+=(const FormulaVar& rhs) { return *this = *this + rhs; }
+FormulaVar& FormulaVar::operator-=(const FormulaVar& rhs) { return *this = *this - rhs; }
+FormulaVar& FormulaVar::operator*=(const FormulaVar& rhs) { return *this = *this * rhs; }
+FormulaVar& FormulaVar::operator/=(const FormulaVar& rhs) { return *this = *this / rhs; }
+
+FormulaVar pow(const FormulaVar& base, const FormulaVar& exponent)
+{
+    return FormulaRecorder::power(base, exponent);
+}
+
+#define UNCERTAINTIES_FORMULA_UNARY(name, op)                                      \
+    FormulaVar name(const FormulaVar& x)                                           \
+    {                                                                              \
+        return FormulaRecorder::unary(FormulaOp::op, x,                            \
+                                      [](const udouble& v) { return name(v); });   \
+    }
+
+UNCERTAINTIES_FORMULA_UNARY(sin, Sin)
+UNCERTAINTIES_FORMULA_UNARY(cos, Cos)
+UNCERTAINTIES_FORMULA_UNARY(tan, Tan)
+UNCERTAINTIES_FORMULA_UNARY(asin, Asin)
+UNCERTAINTIES_FORMULA_UNARY(acos, Acos)
+UNCERTAINTIES_FORMULA_UNARY(atan, Atan)
+UNCERTAINTIES_FORMULA_UNARY(sinh, Sinh)
+UNCERTAINTIES_FORMULA_UNARY(cosh, Cosh)
+UNCERTAINTIES_FORMULA_UNARY(tanh, Tanh)
+UNCERTAINTIES_FORMULA_UNARY(asinh, Asinh)
+UNCERTAINTIES_FORMULA_UNARY(acosh, Acosh)
+UNCERTAINTIES_FORMULA_UNARY(atanh, Atanh)
+UNCERTAINTIES_FORMULA_UNARY(exp, Exp)
+UNCERTAINTIES_FORMULA_UNARY(log, Log)
+UNCERTAINTIES_FORMULA_UNARY(log10, Log10)
+UNCERTAINTIES_FORMULA_UNARY(sqrt, Sqrt)
+UNCERTAINTIES_FORMULA_UNARY(abs, Abs)
+
+#undef UNCERTAINTIES_FORMULA_UNARY
+
+FormulaVar atan2(const FormulaVar& y, const FormulaVar& x)
+{
+    return FormulaRecorder::binary(FormulaOp::Atan2, y, x,
+                                   [](const udouble& a, const udouble& b) { return atan2(a, b); });
+}
+
+FormulaVar hypot(const FormulaVar& x, const FormulaVar& y)
+{
+    return FormulaRecorder::binary(FormulaOp::Hypot, x, y,
+                                   [](const udouble& a, const udouble& b) { return hypot(a, b); });
+}
+
+namespace {
+    [[noreturn]] void throw_domain(const char* message, std::size_t row) {
+        throw std::invalid_argument(std::string(message) + " (row " + std::to_string(row) + ")");
+    }
+
+    [[noreturn]] void throw_runtime(const char* message, std::size_t row) {
+        throw std::runtime_error(std::string(message) + " (row " + std::to_string(row) + ")");
+    }
+
+} // namespace
+
+namespace detail {
+    // Values of one formula input for the rows being evaluated
+    struct InputView {
+        const double* nominal = nullptr;  ///< Column data (nullptr: parameter)
+        const double* stddev = nullptr;   ///< Column stddevs (nullptr: exact)
+        double value = 0.0;               ///< Parameter nominal value
+        const double* seed = nullptr;     ///< Tangent per lane (nullptr: unit tangent on the input's lane)
+    };
+
+    // Registers of one thread. Register r holds `block` nominal values
+    // followed by `lanes` tangent arrays of `block` values each, so every
+    // loop below runs over contiguous memory.
+    class BlockMachine {
+    public:
+        BlockMachine(std::size_t registers, std::size_t lanes, std::size_t block)
+            : lanes_(lanes), block_(block), stride_((1 + lanes) * block),
+              regs_(registers * stride_), pa_(block), pb_(block) {}
+
+        double* reg(uint32_t r) { return regs_.data() + r * stride_; }
+
+        /** All registers, e.g. for checkpointing. */
+        std::vector<double>& registers() { return regs_; }
+
+        void run(const std::vector<FormulaInstruction>& code,
+                 const std::vector<InputView>& inputs, std::size_t row0, std::size_t m) {
+            for (const FormulaInstruction& ins : code) {
+                step(ins, inputs, row0, m);
+            }
+        }
+
+        // Execute one instruction
+        void step(const FormulaInstruction& ins, const std::vector<InputView>& inputs,
+                  std::size_t row0, std::size_t m);
+
+        // ∂dst/∂a and ∂dst/∂b of row 0 of the instruction just stepped
+        void partials(const FormulaInstruction& ins, double& da, double& db) const {
+            switch (ins.op) {
+                case FormulaOp::Input:
+                case FormulaOp::Const:
+                    da = db = 0.0;
+                    break;
+                case FormulaOp::Add: da = 1.0; db = 1.0; break;
+                case FormulaOp::Sub: da = 1.0; db = -1.0; break;
+                case FormulaOp::AddScalar: da = 1.0; db = 0.0; break;
+                case FormulaOp::MulScalar: da = ins.constant; db = 0.0; break;
+                case FormulaOp::DivScalar: da = 1.0 / ins.constant; db = 0.0; break;
+                case FormulaOp::ScalarSub:
+                case FormulaOp::Neg:
+                    da = -1.0;
+                    db = 0.0;
+                    break;
+                default:
+                    da = pa_[0];
+                    db = arity(ins.op) == 2 ? pb_[0] : 0.0;
+                    break;
+            }
+        }
+
+    private:
+        double* tangent(double* r, std::size_t k) const { return r + (1 + k) * block_; }
+
+        // d' = pa * a'
+        void chain(double* d, double* a, std::size_t m) {
+            const double* pa = pa_.data();
+            for (std::size_t k = 0; k < lanes_; ++k) {
+                double* dt = tangent(d, k);
+                const double* at = tangent(a, k);
+                for (std::size_t i = 0; i < m; ++i) {
+                    dt[i] = pa[i] * at[i];
+                }
+            }
+        }
+
+        // d' = pa * a' + pb * b'
+        void chain(double* d, double* a, double* b, std::size_t m) {
+            const double* pa = pa_.data();
+            const double* pb = pb_.data();
+            for (std::size_t k = 0; k < lanes_; ++k) {
+                double* dt = tangent(d, k);
+                const double* at = tangent(a, k);
+                const double* bt = tangent(b, k);
+                for (std::size_t i = 0; i < m; ++i) {
+                    dt[i] = pa[i] * at[i] + pb[i] * bt[i];
+                }
+            }
+        }
+
+        // d' = c * a'
+        void chain_scaled(double* d, double* a, double c, std::size_t m) {
+            for (std::size_t k = 0; k < lanes_; ++k) {
+                double* dt = tangent(d, k);
+                const double* at = tangent(a, k);
+                for (std::size_t i = 0; i < m; ++i) {
+                    dt[i] = c * at[i];
+                }
+            }
+        }
+
+        // d' = a' + sign * b'
+        void chain_sum(double* d, double* a, double* b, double sign, std::size_t m) {
+            for (std::size_t k = 0; k < lanes_; ++k) {
+                double* dt = tangent(d, k);
+                const double* at = tangent(a, k);
+                const double* bt = tangent(b, k);
+                for (std::size_t i = 0; i < m; ++i) {
+                    dt[i] = at[i] + sign * bt[i];
+                }
+            }
+        }
+
+        std::size_t lanes_;
+        std::size_t block_;
+        std::size_t stride_;
+        std::vector<double> regs_;
+        std::vector<double> pa_;   ///< ∂dst/∂a per row
+        std::vector<double> pb_;   ///< ∂dst/∂b per row
+    };
+
+    void BlockMachine::step(const FormulaInstruction& ins, const std::vector<InputView>& inputs,
+                            std::size_t row0, std::size_t m)
+    {
+        double* pa = pa_.data();
+        double* pb = pb_.data();
+        double* d = reg(ins.dst);
+        double* a = ins.op == FormulaOp::Input ? nullptr : reg(ins.a);
+        double* b = reg(ins.b);
+        const double c = ins.constant;
+
+        switch (ins.op) {
+            case FormulaOp::Input: {
+                const InputView& in = inputs[ins.a];
+                if (in.nominal) {
+                    std::copy(in.nominal + row0, in.nominal + row0 + m, d);
+                } else {
+                    std::fill(d, d + m, in.value);
+                }
+                for (std::size_t k = 0; k < lanes_; ++k) {
+                    double seed = in.seed ? in.seed[k] : (k == ins.a ? 1.0 : 0.0);
+                    std::fill(tangent(d, k), tangent(d, k) + m, seed);
+                }
+                break;
+            }
+            case FormulaOp::Const:
+                std::fill(d, d + m, c);
+                for (std::size_t k = 0; k < lanes_; ++k) {
+                    std::fill(tangent(d, k), tangent(d, k) + m, 0.0);
+                }
+                break;
+
+            case FormulaOp::Add:
+                for (std::size_t i = 0; i < m; ++i) d[i] = a[i] + b[i];
+                chain_sum(d, a, b, 1.0, m);
+                break;
+            case FormulaOp::Sub:
+                for (std::size_t i = 0; i < m; ++i) d[i] = a[i] - b[i];
+                chain_sum(d, a, b, -1.0, m);
+                break;
+            case FormulaOp::Mul:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = a[i] * b[i];
+                    pa[i] = b[i];
+                    pb[i] = a[i];
+                }
+                chain(d, a, b, m);
+                break;
+            case FormulaOp::Div:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (b[i] == 0.0) throw_runtime("Division by zero in udouble.", row0 + i);
+                }
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = a[i] / b[i];
+                    pa[i] = 1.0 / b[i];
+                    pb[i] = -a[i] / (b[i] * b[i]);
+                }
+                chain(d, a, b, m);
+                break;
+            case FormulaOp::AddScalar:
+                for (std::size_t i = 0; i < m; ++i) d[i] = a[i] + c;
+                chain_scaled(d, a, 1.0, m);
+                break;
+            case FormulaOp::MulScalar:
+                for (std::size_t i = 0; i < m; ++i) d[i] = a[i] * c;
+                chain_scaled(d, a, c, m);
+                break;
+            case FormulaOp::DivScalar:
+                for (std::size_t i = 0; i < m; ++i) d[i] = a[i] / c;
+                chain_scaled(d, a, 1.0 / c, m);
+                break;
+            case FormulaOp::ScalarSub:
+                for (std::size_t i = 0; i < m; ++i) d[i] = c - a[i];
+                chain_scaled(d, a, -1.0, m);
+                break;
+            case FormulaOp::ScalarDiv:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] == 0.0) throw_runtime("Division by zero in udouble.", row0 + i);
+                }
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = c / a[i];
+                    pa[i] = -c / (a[i] * a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Neg:
+                for (std::size_t i = 0; i < m; ++i) d[i] = -a[i];
+                chain_scaled(d, a, -1.0, m);
+                break;
+
+            case FormulaOp::Pow:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] <= 0.0) {
+                        throw_runtime("Base of exponentiation (base) must be positive.", row0 + i);
+                    }
+                    d[i] = std::pow(a[i], b[i]);
+                    pa[i] = d[i] * b[i] / a[i];
+                    pb[i] = d[i] * std::log(a[i]);
+                }
+                chain(d, a, b, m);
+                break;
+            case FormulaOp::PowScalar:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] <= 0.0) {
+                        throw_runtime("Base of exponentiation (base) must be positive.", row0 + i);
+                    }
+                    d[i] = std::pow(a[i], c);
+                    pa[i] = d[i] * c / a[i];
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::ScalarPow: {
+                const double log_c = std::log(c);
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::pow(c, a[i]);
+                    pa[i] = d[i] * log_c;
+                }
+                chain(d, a, m);
+                break;
+            }
+
+            case FormulaOp::Sin:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::sin(a[i]);
+                    pa[i] = std::cos(a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Cos:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::cos(a[i]);
+                    pa[i] = -std::sin(a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Tan:
+                for (std::size_t i = 0; i < m; ++i) {
+                    double cos_x = std::cos(a[i]);
+                    if (cos_x == 0.0) {
+                        throw_domain("Tangent undefined at this value (cos(x) = 0).", row0 + i);
+                    }
+                    d[i] = std::tan(a[i]);
+                    pa[i] = 1.0 / (cos_x * cos_x);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Asin:
+            case FormulaOp::Acos: {
+                const bool is_asin = ins.op == FormulaOp::Asin;
+                for (std::size_t i = 0; i < m; ++i) {
+                    double x = a[i];
+                    if (x < -1.0 || x > 1.0) {
+                        throw_domain(is_asin ? "asin input must be in range [-1, 1]."
+                                             : "acos input must be in range [-1, 1].", row0 + i);
+                    }
+                    double denom = std::sqrt(1.0 - x * x);
+                    if (denom == 0.0) {
+                        throw_domain(is_asin ? "asin derivative undefined at x = ±1."
+                                             : "acos derivative undefined at x = ±1.", row0 + i);
+                    }
+                    d[i] = is_asin ? std::asin(x) : std::acos(x);
+                    pa[i] = (is_asin ? 1.0 : -1.0) / denom;
+                }
+                chain(d, a, m);
+                break;
+            }
+            case FormulaOp::Atan:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::atan(a[i]);
+                    pa[i] = 1.0 / (1.0 + a[i] * a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Atan2:
+                // a = y, b = x
+                for (std::size_t i = 0; i < m; ++i) {
+                    double denom = b[i] * b[i] + a[i] * a[i];
+                    if (denom == 0.0) {
+                        throw_domain("atan2 undefined at origin (0, 0).", row0 + i);
+                    }
+                    d[i] = std::atan2(a[i], b[i]);
+                    pa[i] = b[i] / denom;
+                    pb[i] = -a[i] / denom;
+                }
+                chain(d, a, b, m);
+                break;
+
+            case FormulaOp::Sinh:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::sinh(a[i]);
+                    pa[i] = std::cosh(a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Cosh:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::cosh(a[i]);
+                    pa[i] = std::sinh(a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Tanh:
+                for (std::size_t i = 0; i < m; ++i) {
+                    double cosh_x = std::cosh(a[i]);
+                    d[i] = std::tanh(a[i]);
+                    pa[i] = 1.0 / (cosh_x * cosh_x);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Asinh:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::asinh(a[i]);
+                    pa[i] = 1.0 / std::sqrt(1.0 + a[i] * a[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Acosh:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] < 1.0) {
+                        throw_domain("acosh input must be >= 1.", row0 + i);
+                    }
+                    double denom = std::sqrt(a[i] * a[i] - 1.0);
+                    if (denom == 0.0) {
+                        throw_domain("acosh derivative undefined at x = 1.", row0 + i);
+                    }
+                    d[i] = std::acosh(a[i]);
+                    pa[i] = 1.0 / denom;
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Atanh:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] <= -1.0 || a[i] >= 1.0) {
+                        throw_domain("atanh input must be in range (-1, 1).", row0 + i);
+                    }
+                    d[i] = std::atanh(a[i]);
+                    pa[i] = 1.0 / (1.0 - a[i] * a[i]);
+                }
+                chain(d, a, m);
+                break;
+
+            case FormulaOp::Exp:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::exp(a[i]);
+                    pa[i] = d[i];
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Log:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] <= 0.0) {
+                        throw_domain("Logarithm input must be greater than zero.", row0 + i);
+                    }
+                    d[i] = std::log(a[i]);
+                    pa[i] = 1.0 / a[i];
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Log10: {
+                const double ln10 = std::log(10.0);
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] <= 0.0) {
+                        throw_domain("log10 input must be greater than zero.", row0 + i);
+                    }
+                    d[i] = std::log10(a[i]);
+                    pa[i] = 1.0 / (a[i] * ln10);
+                }
+                chain(d, a, m);
+                break;
+            }
+            case FormulaOp::Sqrt:
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (a[i] <= 0.0) {
+                        throw_domain("sqrt input must be greater than zero.", row0 + i);
+                    }
+                    d[i] = std::sqrt(a[i]);
+                    pa[i] = 1.0 / (2.0 * d[i]);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Abs:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::abs(a[i]);
+                    pa[i] = (a[i] > 0.0) ? 1.0 : ((a[i] < 0.0) ? -1.0 : 0.0);
+                }
+                chain(d, a, m);
+                break;
+            case FormulaOp::Hypot:
+                for (std::size_t i = 0; i < m; ++i) {
+                    d[i] = std::hypot(a[i], b[i]);
+                    // At the origin udouble adds the inputs' derivatives
+                    pa[i] = d[i] == 0.0 ? 1.0 : a[i] / d[i];
+                    pb[i] = d[i] == 0.0 ? 1.0 : b[i] / d[i];
+                }
+                chain(d, a, b, m);
+                break;
+        }
+    }
+} // namespace detail
+
+using detail::BlockMachine;
+using detail::InputView;
+
+FormulaInput FormulaInput::column(const std::vector<double>& nominal,
+                                  const std::vector<double>& stddev)
+{
+    if (!stddev.empty() && stddev.size() != nominal.size()) {
+        throw std::invalid_argument("FormulaInput column: stddev size does not match nominal size.");
+    }
+    FormulaInput in = column(nominal.data(), stddev.empty() ? nullptr : stddev.data());
+    in.size_ = nominal.size();
+    return in;
+}
+
+std::vector<FormulaVar> Formula::make_inputs(FormulaTape& tape, std::size_t num_inputs)
+{
+    std::vector<FormulaVar> inputs;
+    inputs.reserve(num_inputs);
+    for (std::size_t k = 0; k < num_inputs; ++k) {
+        inputs.push_back(FormulaRecorder::emit(&tape, FormulaOp::Input, static_cast<uint32_t>(k)));
+    }
+    return inputs;
+}
+
+// Compile the tape: drop nodes that no output depends on, then assign
+// registers in a single forward pass, reusing a register as soon as the
+// last reader of its value has run. Outputs keep their registers.
+Formula::Formula(const FormulaTape& tape, std::size_t num_inputs,
+                 const std::vector<FormulaVar>& outputs)
+    : num_inputs_(num_inputs)
+{
+    std::vector<detail::FormulaNode> nodes = tape.nodes;
+    std::vector<uint32_t> output_nodes;
+    output_nodes.reserve(outputs.size());
+    for (const FormulaVar& out : outputs) {
+        if (out.is_constant()) {
+            nodes.push_back({FormulaOp::Const, 0, 0, out.value_});
+            output_nodes.push_back(static_cast<uint32_t>(nodes.size() - 1));
+        } else {
+            if (out.tape_ != &tape) {
+                throw std::invalid_argument("Formula output was recorded by another formula.");
+            }
+            output_nodes.push_back(out.node_);
+        }
+    }
+
+    const std::size_t n = nodes.size();
+    constexpr uint32_t NEVER = ~uint32_t{0};
+    std::vector<bool> live(n, false);
+    std::vector<uint32_t> last_use(n, 0);
+    for (uint32_t node : output_nodes) {
+        live[node] = true;
+        last_use[node] = NEVER;
+    }
+    for (std::size_t i = n; i-- > 0; ) {
+        if (!live[i]) {
+            continue;
+        }
+        const detail::FormulaNode& node = nodes[i];
+        std::size_t operands = arity(node.op);
+        if (operands >= 1) {
+            live[node.a] = true;
+            last_use[node.a] = std::max(last_use[node.a], static_cast<uint32_t>(i));
+        }
+        if (operands == 2) {
+            live[node.b] = true;
+            last_use[node.b] = std::max(last_use[node.b], static_cast<uint32_t>(i));
+        }
+    }
+
+    std::vector<uint32_t> reg_of(n, 0);
+    std::vector<uint32_t> free_regs;
+    uint32_t next_reg = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!live[i]) {
+            continue;
+        }
+        const detail::FormulaNode& node = nodes[i];
+        uint32_t dst;
+        if (free_regs.empty()) {
+            dst = next_reg++;
+        } else {
+            dst = free_regs.back();
+            free_regs.pop_back();
+        }
+
+        std::size_t operands = arity(node.op);
+        FormulaInstruction ins{node.op, dst, 0, 0, node.constant};
+        if (node.op == FormulaOp::Input) {
+            ins.a = node.a;
+        }
+        if (operands >= 1) {
+            ins.a = reg_of[node.a];
+        }
+        if (operands == 2) {
+            ins.b = reg_of[node.b];
+        }
+        code_.push_back(ins);
+        reg_of[i] = dst;
+
+        // Free operand registers after allocating dst, so that an
+        // instruction never writes a register it reads
+        if (operands >= 1 && last_use[node.a] == i) {
+            free_regs.push_back(reg_of[node.a]);
+        }
+        if (operands == 2 && node.b != node.a && last_use[node.b] == i) {
+            free_regs.push_back(reg_of[node.b]);
+        }
+    }
+    num_registers_ = next_reg;
+
+    outputs_.reserve(output_nodes.size());
+    for (uint32_t node : output_nodes) {
+        outputs_.push_back(reg_of[node]);
+    }
+}
+
+FormulaResult Formula::evaluate(const std::vector<FormulaInput>& inputs, std::size_t rows,
+                                const FormulaOptions& options) const
+{
+    if (inputs.size() != num_inputs_) {
+        throw std::invalid_argument("Formula::evaluate: expected " + std::to_string(num_inputs_) +
+                                    " inputs, got " + std::to_string(inputs.size()) + ".");
+    }
+    const std::size_t lanes = num_inputs_;
+    const std::size_t block = std::max<std::size_t>(1, options.block_size);
+    auto& registry = detail::VariableRegistry::instance();
+
+    FormulaResult result;
+    result.rows_ = rows;
+    result.inputs_.resize(lanes);
+    std::vector<InputView> views(lanes);
+    std::vector<std::size_t> columns;     // inputs with per-row stddevs
+    std::vector<std::size_t> parameters;  // uncertain parameters
+    for (std::size_t k = 0; k < lanes; ++k) {
+        const FormulaInput& in = inputs[k];
+        FormulaResult::InputInfo& info = result.inputs_[k];
+        if (in.is_parameter_) {
+            info.is_parameter = true;
+            info.parameter = in.parameter_;
+            views[k].value = in.parameter_.nominal_value();
+            if (in.parameter_.num_variables() > 0) {
+                parameters.push_back(k);
+            }
+            continue;
+        }
+        if (!in.nominal_ && rows > 0) {
+            throw std::invalid_argument("Formula::evaluate: column input has no data.");
+        }
+        if (in.size_ < rows) {
+            throw std::invalid_argument("Formula::evaluate: column input is shorter than the row count.");
+        }
+        views[k].nominal = in.nominal_;
+        views[k].stddev = in.stddev_;
+        if (in.stddev_) {
+            info.stddev.assign(in.stddev_, in.stddev_ + rows);
+            info.first_id = registry.reserve_ids(rows);
+            columns.push_back(k);
+        }
+    }
+
+    // Covariances between uncertain parameters
+    std::vector<double> cov(parameters.size() * parameters.size(), 0.0);
+    for (std::size_t p = 0; p < parameters.size(); ++p) {
+        const auto& dp = result.inputs_[parameters[p]].parameter.derivatives();
+        for (std::size_t q = p; q < parameters.size(); ++q) {
+            const auto& dq = result.inputs_[parameters[q]].parameter.derivatives();
+            double c = 0.0;
+            for (const auto& [id, deriv] : dp) {
+                auto it = dq.find(id);
+                if (it != dq.end()) {
+                    double sigma = registry.get_stddev(id);
+                    c += deriv * it->second * sigma * sigma;
+                }
+            }
+            cov[p * parameters.size() + q] = c;
+            cov[q * parameters.size() + p] = c;
+        }
+    }
+
+    const std::size_t outputs = outputs_.size();
+    result.nominals_.assign(outputs, std::vector<double>(rows));
+    result.stddevs_.assign(outputs, std::vector<double>(rows));
+    if (options.keep_derivatives) {
+        result.derivatives_.assign(outputs, std::vector<std::vector<double>>(lanes, std::vector<double>(rows)));
+    }
+
+    const std::size_t blocks = (rows + block - 1) / block;
+    const std::size_t threads = detail::resolve_thread_count(options.threads, blocks, 4);
+    detail::parallel_for(blocks, threads, [&](std::size_t first, std::size_t last, std::size_t) {
+        BlockMachine machine(num_registers_, lanes, block);
+        std::vector<double> variance(block);
+        for (std::size_t blk = first; blk < last; ++blk) {
+            const std::size_t row0 = blk * block;
+            const std::size_t m = std::min(block, rows - row0);
+            machine.run(code_, views, row0, m);
+
+            for (std::size_t o = 0; o < outputs; ++o) {
+                double* r = machine.reg(outputs_[o]);
+                std::copy(r, r + m, result.nominals_[o].data() + row0);
+                if (options.keep_derivatives) {
+                    for (std::size_t k = 0; k < lanes; ++k) {
+                        const double* t = r + (1 + k) * block;
+                        std::copy(t, t + m, result.derivatives_[o][k].data() + row0);
+                    }
+                }
+
+                std::fill(variance.begin(), variance.begin() + m, 0.0);
+                for (std::size_t k : columns) {
+                    const double* t = r + (1 + k) * block;
+                    const double* s = views[k].stddev + row0;
+                    for (std::size_t i = 0; i < m; ++i) {
+                        double contribution = t[i] * s[i];
+                        variance[i] += contribution * contribution;
+                    }
+                }
+                for (std::size_t p = 0; p < parameters.size(); ++p) {
+                    const double* tp = r + (1 + parameters[p]) * block;
+                    for (std::size_t q = 0; q < parameters.size(); ++q) {
+                        const double c = cov[p * parameters.size() + q];
+                        if (c == 0.0) {
+                            continue;
+                        }
+                        const double* tq = r + (1 + parameters[q]) * block;
+                        for (std::size_t i = 0; i < m; ++i) {
+                            variance[i] += tp[i] * c * tq[i];
+                        }
+                    }
+                }
+                double* sd = result.stddevs_[o].data() + row0;
+                for (std::size_t i = 0; i < m; ++i) {
+                    sd[i] = std::sqrt(std::max(variance[i], 0.0));
+                }
+            }
+        }
+    });
+    return result;
+}
+
+namespace detail {
+    struct FormulaTangentsState {
+        FormulaTangentsState(std::size_t registers, std::size_t lanes, std::size_t inputs)
+            : machine(registers, lanes, 1), views(inputs) {}
+
+        BlockMachine machine;
+        std::vector<InputView> views;
+    };
+} // namespace detail
+
+FormulaTangents::FormulaTangents(const Formula& formula, std::size_t lanes)
+    : formula_(&formula), lanes_(lanes),
+      state_(std::make_unique<detail::FormulaTangentsState>(formula.num_registers_, lanes,
+                                                            formula.num_inputs_)) {}
+
+FormulaTangents::~FormulaTangents() = default;
+FormulaTangents::FormulaTangents(FormulaTangents&&) noexcept = default;
+FormulaTangents& FormulaTangents::operator=(FormulaTangents&&) noexcept = default;
+
+void FormulaTangents::evaluate(const double* x, const double* seeds, double* y, double* tangents)
+{
+    auto& views = state_->views;
+    for (std::size_t k = 0; k < views.size(); ++k) {
+        views[k].value = x[k];
+        views[k].seed = seeds + k * lanes_;
+    }
+    BlockMachine& machine = state_->machine;
+    machine.run(formula_->code_, views, 0, 1);
+    for (std::size_t o = 0; o < formula_->outputs_.size(); ++o) {
+        const double* r = machine.reg(formula_->outputs_[o]);
+        y[o] = r[0];
+        std::copy(r + 1, r + 1 + lanes_, tangents + o * lanes_);
+    }
+}
+
+namespace detail {
+    // Largest number of instructions reversible with `snapshots` register
+    // snapshots if each is recomputed at most `repetitions` times:
+    // C(snapshots + repetitions, snapshots), saturated
+    std::size_t revolve_capacity(std::size_t snapshots, std::size_t repetitions) {
+        double capacity = 1.0;
+        for (std::size_t k = 1; k <= snapshots; ++k) {
+            capacity = capacity * static_cast<double>(repetitions + k) / static_cast<double>(k);
+            if (capacity > 1e18) {
+                return std::numeric_limits<std::size_t>::max();
+            }
+        }
+        return static_cast<std::size_t>(capacity + 0.5);
+    }
+
+    // Pull the adjoints of an instruction's result back to its operands.
+    // The result register is cleared: earlier instructions that wrote it
+    // computed a different value.
+    void reverse_step(const FormulaInstruction& ins, double da, double db, std::size_t lanes,
+                      double* adjoints, double* gradients) {
+        double* d = adjoints + ins.dst * lanes;
+        const std::size_t operands = arity(ins.op);
+        if (ins.op == FormulaOp::Input) {
+            double* g = gradients + ins.a * lanes;
+            for (std::size_t k = 0; k < lanes; ++k) {
+                g[k] += d[k];
+            }
+        } else if (operands == 1) {
+            double* a = adjoints + ins.a * lanes;
+            for (std::size_t k = 0; k < lanes; ++k) {
+                a[k] += da * d[k];
+            }
+        } else if (operands == 2) {
+            double* a = adjoints + ins.a * lanes;
+            double* b = adjoints + ins.b * lanes;
+            for (std::size_t k = 0; k < lanes; ++k) {
+                const double w = d[k];
+                a[k] += da * w;
+                b[k] += db * w;
+            }
+        }
+        std::fill(d, d + lanes, 0.0);
+    }
+
+    struct FormulaAdjointsState {
+        FormulaAdjointsState(const std::vector<FormulaInstruction>& code_,
+                             const std::vector<uint32_t>& outputs_, std::size_t registers,
+                             std::size_t inputs, std::size_t lanes_, std::size_t checkpoints)
+            : code(code_), outputs(outputs_), lanes(lanes_), machine(registers, 0, 1),
+              views(inputs), adjoints(registers * lanes_) {
+            if (checkpoints == 0) {
+                tape.resize(2 * code.size());
+            } else {
+                // More snapshots than instructions would never be used
+                snapshots.resize(std::max<std::size_t>(1, std::min(checkpoints, code.size())));
+            }
+        }
+
+        bool checkpointing() const noexcept { return !snapshots.empty(); }
+
+        // Run the program at x; without checkpointing, tape the partials
+        void forward(const double* x, double* y) {
+            for (std::size_t k = 0; k < views.size(); ++k) {
+                views[k].value = x[k];
+            }
+            if (checkpointing()) {
+                snapshots[0] = machine.registers();
+                machine.run(code, views, 0, 1);
+            } else {
+                for (std::size_t i = 0; i < code.size(); ++i) {
+                    machine.step(code[i], views, 0, 1);
+                    machine.partials(code[i], tape[2 * i], tape[2 * i + 1]);
+                }
+            }
+            for (std::size_t o = 0; o < outputs.size(); ++o) {
+                y[o] = machine.reg(outputs[o])[0];
+            }
+        }
+
+        // Set the output adjoints to the weights and clear the gradients
+        void seed(const double* weights, double* adj, double* gradients) const {
+            std::fill(adj, adj + adjoints.size(), 0.0);
+            std::fill(gradients, gradients + views.size() * lanes, 0.0);
+            for (std::size_t o = 0; o < outputs.size(); ++o) {
+                double* r = adj + outputs[o] * lanes;
+                for (std::size_t k = 0; k < lanes; ++k) {
+                    r[k] += weights[o * lanes + k];
+                }
+            }
+        }
+
+        // Reverse sweep over the tape of the last forward()
+        void reverse_tape(double* adj, double* gradients) const {
+            for (std::size_t i = code.size(); i-- > 0; ) {
+                reverse_step(code[i], tape[2 * i], tape[2 * i + 1], lanes, adj, gradients);
+            }
+        }
+
+        // Reverse instructions [begin, end). On entry the registers hold the
+        // state before `begin`, which is also stored in snapshot `slot`.
+        // Each round advances to a split point chosen so that both parts fit
+        // the binomial bound, saves a snapshot there and reverses the tail
+        // with one snapshot less.
+        void revolve(std::size_t begin, std::size_t end, std::size_t slot, double* gradients) {
+            const std::size_t free = snapshots.size() - 1 - slot;
+            while (end - begin > 1) {
+                std::size_t repetitions = 0;
+                while (revolve_capacity(free + 1, repetitions) < end - begin) {
+                    ++repetitions;
+                }
+                const std::size_t tail = std::min(end - begin - 1, revolve_capacity(free, repetitions));
+                const std::size_t split = end - tail;
+                for (std::size_t i = begin; i < split; ++i) {
+                    machine.step(code[i], views, 0, 1);
+                }
+                if (tail == 1) {
+                    reverse_one(split, gradients);
+                } else {
+                    snapshots[slot + 1] = machine.registers();
+                    revolve(split, end, slot + 1, gradients);
+                }
+                machine.registers() = snapshots[slot];
+                end = split;
+            }
+            reverse_one(begin, gradients);
+        }
+
+        // Recompute instruction i from the current registers and reverse it
+        void reverse_one(std::size_t i, double* gradients) {
+            double da = 0.0;
+            double db = 0.0;
+            machine.step(code[i], views, 0, 1);
+            machine.partials(code[i], da, db);
+            reverse_step(code[i], da, db, lanes, adjoints.data(), gradients);
+        }
+
+        const std::vector<FormulaInstruction>& code;
+        const std::vector<uint32_t>& outputs;
+        std::size_t lanes;
+        BlockMachine machine;
+        std::vector<InputView> views;
+        std::vector<double> tape;                     ///< ∂dst/∂a, ∂dst/∂b per instruction
+        std::vector<std::vector<double>> snapshots;   ///< Register files (checkpointing)
+        std::vector<double> adjoints;                 ///< Register adjoints, `lanes` per register
+    };
+} // namespace detail
+
+FormulaAdjoints::FormulaAdjoints(const Formula& formula, std::size_t lanes,
+                                 const FormulaReverseOptions& options)
+    : formula_(&formula), lanes_(lanes),
+      state_(std::make_unique<detail::FormulaAdjointsState>(formula.code_, formula.outputs_,
+                                                            formula.num_registers_, formula.num_inputs_,
+                                                            lanes, options.checkpoints)) {}
+
+FormulaAdjoints::~FormulaAdjoints() = default;
+FormulaAdjoints::FormulaAdjoints(FormulaAdjoints&&) noexcept = default;
+FormulaAdjoints& FormulaAdjoints::operator=(FormulaAdjoints&&) noexcept = default;
+
+void FormulaAdjoints::evaluate(const double* x, const double* weights, double* y, double* gradients)
+{
+    detail::FormulaAdjointsState& state = *state_;
+    state.forward(x, y);
+    state.seed(weights, state.adjoints.data(), gradients);
+    if (!state.checkpointing()) {
+        state.reverse_tape(state.adjoints.data(), gradients);
+    } else if (!formula_->code_.empty()) {
+        state.machine.registers() = state.snapshots[0];
+        state.revolve(0, formula_->code_.size(), 0, gradients);
+    }
+}
+
+std::vector<double> Formula::jacobian(const std::vector<double>& x, const FormulaReverseOptions& options) const
+{
+    if (x.size() != num_inputs_) {
+        throw std::invalid_argument("Formula::jacobian: expected " + std::to_string(num_inputs_) +
+                                    " inputs, got " + std::to_string(x.size()) + ".");
+    }
+    const std::size_t outputs = outputs_.size();
+    std::vector<double> J(outputs * num_inputs_, 0.0);
+    if (outputs == 0) {
+        return J;
+    }
+    const std::size_t lanes = std::min(std::max<std::size_t>(1, options.lanes), outputs);
+    const std::size_t groups = (outputs + lanes - 1) / lanes;
+    const std::size_t threads = detail::resolve_thread_count(options.threads, groups, 1);
+
+    // Without checkpoints, every sweep reads the same tape
+    std::unique_ptr<FormulaAdjoints> shared;
+    std::vector<double> y(outputs);
+    if (options.checkpoints == 0) {
+        shared = std::make_unique<FormulaAdjoints>(*this, lanes, options);
+        shared->state_->forward(x.data(), y.data());
+    }
+
+    detail::parallel_for(groups, threads, [&](std::size_t first, std::size_t last, std::size_t) {
+        std::unique_ptr<FormulaAdjoints> own;
+        std::vector<double> adjoints;
+        if (shared) {
+            adjoints.resize(shared->state_->adjoints.size());
+        } else {
+            own = std::make_unique<FormulaAdjoints>(*this, lanes, options);
+        }
+        std::vector<double> weights(outputs * lanes);
+        std::vector<double> gradients(num_inputs_ * lanes);
+        std::vector<double> values(outputs);
+        for (std::size_t g = first; g < last; ++g) {
+            const std::size_t o0 = g * lanes;
+            const std::size_t width = std::min(lanes, outputs - o0);
+            std::fill(weights.begin(), weights.end(), 0.0);
+            for (std::size_t k = 0; k < width; ++k) {
+                weights[(o0 + k) * lanes + k] = 1.0;
+            }
+            if (shared) {
+                shared->state_->seed(weights.data(), adjoints.data(), gradients.data());
+                shared->state_->reverse_tape(adjoints.data(), gradients.data());
+            } else {
+                own->evaluate(x.data(), weights.data(), values.data(), gradients.data());
+            }
+            for (std::size_t k = 0; k < width; ++k) {
+                for (std::size_t i = 0; i < num_inputs_; ++i) {
+                    J[(o0 + k) * num_inputs_ + i] = gradients[i * lanes + k];
+                }
+            }
+        }
+    });
+    return J;
+}
+
+std::vector<udouble> Formula::apply(const std::vector<udouble>& args) const
+{
+    std::vector<FormulaInput> inputs;
+    inputs.reserve(args.size());
+    for (const udouble& arg : args) {
+        inputs.push_back(FormulaInput::parameter(arg));
+    }
+    FormulaOptions options;
+    options.threads = 1;
+    FormulaResult result = evaluate(inputs, 1, options);
+
+    std::vector<udouble> values;
+    values.reserve(num_outputs());
+    for (std::size_t o = 0; o < num_outputs(); ++o) {
+        values.push_back(result.value(0, o));
+    }
+    return values;
+}
+
+const std::vector<double>& FormulaResult::derivative(std::size_t output, std::size_t input) const
+{
+    if (derivatives_.empty() && rows_ > 0) {
+        throw std::runtime_error("FormulaResult: derivatives were not kept.");
+    }
+    return derivatives_.at(output).at(input);
+}
+
+udouble FormulaResult::value(std::size_t row, std::size_t output) const
+{
+    if (row >= rows_ || output >= num_outputs()) {
+        throw std::out_of_range("FormulaResult::value: row or output out of range.");
+    }
+    return make_value(row, output, true);
+}
+
+udouble FormulaResult::make_value(std::size_t row, std::size_t output, bool register_row) const
+{
+    if (derivatives_.empty()) {
+        throw std::runtime_error("FormulaResult: derivatives were not kept.");
+    }
+
+    auto& registry = detail::VariableRegistry::instance();
+    udouble::DerivativeMap derivs;
+    for (std::size_t k = 0; k < inputs_.size(); ++k) {
+        const double d = derivatives_[output][k][row];
+        const InputInfo& info = inputs_[k];
+        if (d == 0.0) {
+            continue;
+        }
+        if (info.is_parameter) {
+            for (const auto& [id, deriv] : info.parameter.derivatives()) {
+                derivs[id] += d * deriv;
+            }
+        } else if (!info.stddev.empty() && info.stddev[row] > 0.0) {
+            if (register_row) {
+                registry.register_id(info.first_id + row, info.stddev[row]);
+            }
+            derivs[info.first_id + row] += d;
+        }
+    }
+    return udouble::from_derivatives(nominals_[output][row], std::move(derivs));
+}
+
+std::vector<udouble> FormulaResult::values(std::size_t output) const
+{
+    if (output >= num_outputs()) {
+        throw std::out_of_range("FormulaResult::values: output out of range.");
+    }
+    if (derivatives_.empty() && rows_ > 0) {
+        throw std::runtime_error("FormulaResult: derivatives were not kept.");
+    }
+    auto& registry = detail::VariableRegistry::instance();
+    for (const InputInfo& info : inputs_) {
+        if (!info.stddev.empty()) {
+            registry.register_ids(info.first_id, info.stddev.data(), rows_);
+        }
+    }
+    std::vector<udouble> out;
+    out.reserve(rows_);
+    for (std::size_t row = 0; row < rows_; ++row) {
+        out.push_back(make_value(row, output, false));
+    }
+    return out;
+}
+
+} // namespace uncertainties
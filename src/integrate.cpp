@@ -0,0 +1,185 @@
+#include "uncertainties/integrate.hpp"
+#include "uncertainties/parallel.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace uncertainties {
+
+namespace detail {
+
+// Roots of the Legendre polynomial P_n by Newton iteration from the
+// Chebyshev-like initial guesses; weights from the derivative at the roots
+void gauss_legendre(std::size_t order, std::vector<double>& nodes, std::vector<double>& weights) {
+    const double pi = std::acos(-1.0);
+    const std::size_t n = order;
+    nodes.assign(n, 0.0);
+    weights.assign(n, 0.0);
+    for (std::size_t i = 0; i < (n + 1) / 2; ++i) {
+        double z = std::cos(pi * (static_cast<double>(i) + 0.75) / (static_cast<double>(n) + 0.5));
+        double derivative = 0.0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            double p1 = 1.0;
+            double p2 = 0.0;
+            for (std::size_t j = 1; j <= n; ++j) {
+                double p3 = p2;
+                p2 = p1;
+                p1 = ((2.0 * static_cast<double>(j) - 1.0) * z * p2 -
+                      (static_cast<double>(j) - 1.0) * p3) / static_cast<double>(j);
+            }
+            derivative = static_cast<double>(n) * (z * p1 - p2) / (z * z - 1.0);
+            double step = p1 / derivative;
+            z -= step;
+            if (std::abs(step) < 1e-16) {
+                break;
+            }
+        }
+        double w = 2.0 / ((1.0 - z * z) * derivative * derivative);
+        nodes[i] = -z;
+        nodes[n - 1 - i] = z;
+        weights[i] = w;
+        weights[n - 1 - i] = w;
+    }
+}
+
+} // namespace detail
+
+std::vector<double> integration_weights(const std::vector<double>& x, SampleRule rule)
+{
+    const std::size_t n = x.size();
+    if (n < 2) {
+        throw std::invalid_argument("Integration needs at least two samples.");
+    }
+    for (std::size_t i = 1; i < n; ++i) {
+        if (!(x[i] > x[i - 1])) {
+            throw std::invalid_argument("Sample abscissae must be strictly increasing.");
+        }
+    }
+
+    std::vector<double> w(n, 0.0);
+    if (rule == SampleRule::Trapezoid || n == 2) {
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            double half = 0.5 * (x[i + 1] - x[i]);
+            w[i] += half;
+            w[i + 1] += half;
+        }
+        return w;
+    }
+
+    // Simpson on pairs of intervals with spacing h0, h1
+    const std::size_t intervals = n - 1;
+    const std::size_t paired = intervals - intervals % 2;
+    for (std::size_t i = 0; i < paired; i += 2) {
+        double h0 = x[i + 1] - x[i];
+        double h1 = x[i + 2] - x[i + 1];
+        double scale = (h0 + h1) / 6.0;
+        w[i] += scale * (2.0 - h1 / h0);
+        w[i + 1] += scale * (h0 + h1) * (h0 + h1) / (h0 * h1);
+        w[i + 2] += scale * (2.0 - h0 / h1);
+    }
+    if (paired < intervals) {
+        // Last interval under the quadratic through the last three samples
+        double h0 = x[n - 2] - x[n - 3];
+        double h1 = x[n - 1] - x[n - 2];
+        w[n - 1] += (2.0 * h1 * h1 + 3.0 * h0 * h1) / (6.0 * (h0 + h1));
+        w[n - 2] += (h1 * h1 + 3.0 * h0 * h1) / (6.0 * h0);
+        w[n - 3] -= h1 * h1 * h1 / (6.0 * h0 * (h0 + h1));
+    }
+    return w;
+}
+
+udouble weighted_sum(const std::vector<double>& weights, const std::vector<udouble>& values)
+{
+    if (weights.size() != values.size()) {
+        throw std::invalid_argument("Weights and values differ in size.");
+    }
+    double nominal = 0.0;
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        nominal += weights[i] * values[i].nominal_value();
+        total += values[i].derivatives().size();
+    }
+    udouble::DerivativeMap derivatives;
+    derivatives.reserve(total);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (weights[i] == 0.0) {
+            continue;
+        }
+        for (const auto& [id, deriv] : values[i].derivatives()) {
+            derivatives[id] += weights[i] * deriv;
+        }
+    }
+    return udouble::from_derivatives(nominal, std::move(derivatives));
+}
+
+udouble integrate_samples(const std::vector<double>& x, const std::vector<udouble>& y,
+                          SampleRule rule)
+{
+    if (x.size() != y.size()) {
+        throw std::invalid_argument("Sample abscissae and ordinates differ in size.");
+    }
+    return weighted_sum(integration_weights(x, rule), y);
+}
+
+udouble integrate(const std::function<udouble(double)>& f, double a, double b,
+                  const IntegrationOptions& options)
+{
+    if (options.panels == 0 || options.order == 0) {
+        throw std::invalid_argument("Integration needs at least one panel and one point.");
+    }
+    std::vector<double> nodes, weights;
+    detail::gauss_legendre(options.order, nodes, weights);
+
+    // Each panel accumulates its own sum, and panels are combined in order,
+    // so the result does not depend on the thread count
+    const std::size_t panels = options.panels;
+    const double width = (b - a) / static_cast<double>(panels);
+    std::vector<double> panel_nominal(panels, 0.0);
+    std::vector<udouble::DerivativeMap> panel_derivatives(panels);
+
+    std::size_t threads = detail::resolve_thread_count(options.threads, panels);
+    detail::parallel_for(panels, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t p = begin; p < end; ++p) {
+            double half = 0.5 * width;
+            double mid = a + (static_cast<double>(p) + 0.5) * width;
+            auto& derivatives = panel_derivatives[p];
+            for (std::size_t j = 0; j < nodes.size(); ++j) {
+                double w = half * weights[j];
+                udouble value = f(mid + half * nodes[j]);
+                panel_nominal[p] += w * value.nominal_value();
+                for (const auto& [id, deriv] : value.derivatives()) {
+                    derivatives[id] += w * deriv;
+                }
+            }
+        }
+    });
+
+    double nominal = 0.0;
+    udouble::DerivativeMap derivatives = std::move(panel_derivatives[0]);
+    nominal += panel_nominal[0];
+    for (std::size_t p = 1; p < panels; ++p) {
+        nominal += panel_nominal[p];
+        for (const auto& [id, deriv] : panel_derivatives[p]) {
+            derivatives[id] += deriv;
+        }
+    }
+    return udouble::from_derivatives(nominal, std::move(derivatives));
+}
+
+udouble integrate(const std::function<udouble(double)>& f, const udouble& a, const udouble& b,
+                  const IntegrationOptions& options)
+{
+    udouble integral = integrate(f, a.nominal_value(), b.nominal_value(), options);
+    double fa = f(a.nominal_value()).nominal_value();
+    double fb = f(b.nominal_value()).nominal_value();
+
+    udouble::DerivativeMap derivatives = integral.derivatives();
+    for (const auto& [id, deriv] : b.derivatives()) {
+        derivatives[id] += fb * deriv;
+    }
+    for (const auto& [id, deriv] : a.derivatives()) {
+        derivatives[id] -= fa * deriv;
+    }
+    return udouble::from_derivatives(integral.nominal_value(), std::move(derivatives));
+}
+
+} // namespace uncertainties
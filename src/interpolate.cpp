@@ -0,0 +1,272 @@
+#include "uncertainties/interpolate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace uncertainties {
+
+namespace {
+
+// Rows on each side of a node solved when computing its influence on the
+// spline's second derivatives. The diagonal of the system is twice the sum
+// of its off-diagonals, so the influence at least halves with every row and
+// is below 2^-64 of its peak at the window edge.
+constexpr std::size_t INFLUENCE_WINDOW = 64;
+
+// Influences smaller than this fraction of the largest are dropped
+constexpr double NEGLIGIBLE_INFLUENCE = 1e-17;
+
+void validate_table(const std::vector<double>& x, const std::vector<udouble>& y) {
+    if (x.size() != y.size()) {
+        throw std::invalid_argument("Interpolation table abscissae and ordinates differ in size.");
+    }
+    if (x.size() < 2) {
+        throw std::invalid_argument("Interpolation table needs at least two points.");
+    }
+    for (std::size_t i = 1; i < x.size(); ++i) {
+        if (!(x[i] > x[i - 1])) {
+            throw std::invalid_argument("Interpolation table abscissae must be strictly increasing.");
+        }
+    }
+}
+
+// Segment s with x[s] <= q < x[s + 1], clamped to the first and last segments
+std::size_t locate(const std::vector<double>& x, double q) {
+    auto it = std::upper_bound(x.begin(), x.end(), q);
+    std::size_t s = it == x.begin() ? 0 : static_cast<std::size_t>(it - x.begin()) - 1;
+    return std::min(s, x.size() - 2);
+}
+
+bool outside(const std::vector<double>& x, double q) {
+    return q < x.front() || q > x.back();
+}
+
+[[noreturn]] void throw_outside(double q) {
+    throw std::out_of_range("Interpolation point " + std::to_string(q) + " is outside the table.");
+}
+
+// udouble with the given nominal and Σ coef * ∂term, merged into one map
+udouble combine(double nominal, std::initializer_list<std::pair<double, const udouble*>> terms) {
+    std::size_t total = 0;
+    for (const auto& [coef, term] : terms) {
+        if (term) {
+            total += term->derivatives().size();
+        }
+    }
+    udouble::DerivativeMap derivatives;
+    derivatives.reserve(total);
+    for (const auto& [coef, term] : terms) {
+        if (!term || coef == 0.0) {
+            continue;
+        }
+        for (const auto& [id, deriv] : term->derivatives()) {
+            derivatives[id] += coef * deriv;
+        }
+    }
+    return udouble::from_derivatives(nominal, std::move(derivatives));
+}
+
+// Evaluate at every query, sweeping the segments once if the queries are sorted
+template <typename Evaluate>
+std::vector<udouble> evaluate_batch(const std::vector<double>& x, const std::vector<udouble>& queries,
+                                    Evaluate&& evaluate) {
+    bool sorted = std::is_sorted(queries.begin(), queries.end(),
+                                 [](const udouble& a, const udouble& b) {
+                                     return a.nominal_value() < b.nominal_value();
+                                 });
+    std::vector<udouble> out;
+    out.reserve(queries.size());
+    std::size_t segment = 0;
+    for (const auto& query : queries) {
+        double q = query.nominal_value();
+        if (sorted) {
+            while (segment + 2 < x.size() && q >= x[segment + 1]) {
+                ++segment;
+            }
+        } else {
+            segment = locate(x, q);
+        }
+        out.push_back(evaluate(segment, q, &query));
+    }
+    return out;
+}
+
+// Solve a tridiagonal system in place (Thomas algorithm)
+void solve_tridiagonal(const double* sub, const double* diag, const double* sup, double* rhs,
+                       std::size_t count) {
+    std::vector<double> c(count);
+    c[0] = sup[0] / diag[0];
+    rhs[0] /= diag[0];
+    for (std::size_t i = 1; i < count; ++i) {
+        double denom = diag[i] - sub[i] * c[i - 1];
+        c[i] = sup[i] / denom;
+        rhs[i] = (rhs[i] - sub[i] * rhs[i - 1]) / denom;
+    }
+    for (std::size_t i = count - 1; i > 0; --i) {
+        rhs[i - 1] -= c[i - 1] * rhs[i];
+    }
+}
+
+} // namespace
+
+LinearInterpolator::LinearInterpolator(std::vector<double> x, std::vector<udouble> y,
+                                       Extrapolation extrapolation)
+    : x_(std::move(x)), y_(std::move(y)), extrapolation_(extrapolation)
+{
+    validate_table(x_, y_);
+}
+
+udouble LinearInterpolator::evaluate(std::size_t s, double x, const udouble* query) const {
+    if (outside(x_, x)) {
+        if (extrapolation_ == Extrapolation::Throw) {
+            throw_outside(x);
+        }
+        if (extrapolation_ == Extrapolation::Clamp) {
+            return x < x_.front() ? y_.front() : y_.back();
+        }
+    }
+    const udouble& y0 = y_[s];
+    const udouble& y1 = y_[s + 1];
+    double h = x_[s + 1] - x_[s];
+    double t = (x - x_[s]) / h;
+    double slope = (y1.nominal_value() - y0.nominal_value()) / h;
+    double nominal = (1.0 - t) * y0.nominal_value() + t * y1.nominal_value();
+    return combine(nominal, {{1.0 - t, &y0}, {t, &y1}, {slope, query}});
+}
+
+udouble LinearInterpolator::operator()(double x) const {
+    return evaluate(locate(x_, x), x, nullptr);
+}
+
+udouble LinearInterpolator::operator()(const udouble& x) const {
+    return evaluate(locate(x_, x.nominal_value()), x.nominal_value(), &x);
+}
+
+std::vector<udouble> LinearInterpolator::operator()(const std::vector<udouble>& xs) const {
+    return evaluate_batch(x_, xs, [this](std::size_t s, double x, const udouble* query) {
+        return evaluate(s, x, query);
+    });
+}
+
+// Natural spline: M_0 = M_{n-1} = 0 and for interior nodes j
+//   h_{j-1} M_{j-1} + 2 (h_{j-1} + h_j) M_j + h_j M_{j+1}
+//     = 6 ((y_{j+1} - y_j) / h_j - (y_j - y_{j-1}) / h_{j-1})
+CubicSpline::CubicSpline(std::vector<double> x, std::vector<udouble> y,
+                         Extrapolation extrapolation)
+    : x_(std::move(x)), y_(std::move(y)), extrapolation_(extrapolation)
+{
+    validate_table(x_, y_);
+    const std::size_t n = x_.size();
+    m_.assign(n, udouble(0.0));
+    if (n < 3) {
+        return;
+    }
+
+    // Interior row r is node j = r + 1
+    const std::size_t rows = n - 2;
+    std::vector<double> h(n - 1);
+    for (std::size_t j = 0; j + 1 < n; ++j) {
+        h[j] = x_[j + 1] - x_[j];
+    }
+    std::vector<double> sub(rows), diag(rows), sup(rows), nominal(rows);
+    for (std::size_t r = 0; r < rows; ++r) {
+        std::size_t j = r + 1;
+        sub[r] = h[j - 1];
+        diag[r] = 2.0 * (h[j - 1] + h[j]);
+        sup[r] = h[j];
+        nominal[r] = 6.0 * ((y_[j + 1].nominal_value() - y_[j].nominal_value()) / h[j] -
+                            (y_[j].nominal_value() - y_[j - 1].nominal_value()) / h[j - 1]);
+    }
+    solve_tridiagonal(sub.data(), diag.data(), sup.data(), nominal.data(), rows);
+
+    // Influence of every uncertain ordinate on the nearby M_j
+    std::vector<udouble::DerivativeMap> derivatives(n);
+    std::vector<double> influence;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& node = y_[i].derivatives();
+        if (node.empty()) {
+            continue;
+        }
+        // Interior rows whose right-hand side contains y_i are i-2..i (r = j - 1)
+        std::size_t first = i >= 2 + INFLUENCE_WINDOW ? i - 2 - INFLUENCE_WINDOW : 0;
+        std::size_t last = std::min(rows - 1, i + INFLUENCE_WINDOW);
+        std::size_t count = last - first + 1;
+        influence.assign(count, 0.0);
+        for (std::size_t r = first; r <= last; ++r) {
+            std::size_t j = r + 1;
+            if (j + 1 == i) {
+                influence[r - first] = 6.0 / h[j];
+            } else if (j == i) {
+                influence[r - first] = -6.0 / h[j - 1] - 6.0 / h[j];
+            } else if (j == i + 1) {
+                influence[r - first] = 6.0 / h[j - 1];
+            }
+        }
+        solve_tridiagonal(sub.data() + first, diag.data() + first, sup.data() + first,
+                          influence.data(), count);
+
+        double largest = 0.0;
+        for (double g : influence) {
+            largest = std::max(largest, std::abs(g));
+        }
+        for (std::size_t k = 0; k < count; ++k) {
+            double g = influence[k];
+            if (std::abs(g) <= NEGLIGIBLE_INFLUENCE * largest) {
+                continue;
+            }
+            auto& target = derivatives[first + k + 1];
+            for (const auto& [id, deriv] : node) {
+                target[id] += g * deriv;
+            }
+        }
+    }
+    for (std::size_t r = 0; r < rows; ++r) {
+        m_[r + 1] = udouble::from_derivatives(nominal[r], std::move(derivatives[r + 1]));
+    }
+}
+
+udouble CubicSpline::evaluate(std::size_t s, double x, const udouble* query) const {
+    if (outside(x_, x)) {
+        if (extrapolation_ == Extrapolation::Throw) {
+            throw_outside(x);
+        }
+        if (extrapolation_ == Extrapolation::Clamp) {
+            return x < x_.front() ? y_.front() : y_.back();
+        }
+    }
+    const udouble& y0 = y_[s];
+    const udouble& y1 = y_[s + 1];
+    const udouble& m0 = m_[s];
+    const udouble& m1 = m_[s + 1];
+    double h = x_[s + 1] - x_[s];
+    double t = (x - x_[s]) / h;
+    double u = 1.0 - t;
+
+    double c_m0 = h * h / 6.0 * (u * u * u - u);
+    double c_m1 = h * h / 6.0 * (t * t * t - t);
+    double nominal = u * y0.nominal_value() + t * y1.nominal_value() +
+                     c_m0 * m0.nominal_value() + c_m1 * m1.nominal_value();
+    double slope = (y1.nominal_value() - y0.nominal_value()) / h +
+                   h / 6.0 * ((1.0 - 3.0 * u * u) * m0.nominal_value() +
+                              (3.0 * t * t - 1.0) * m1.nominal_value());
+    return combine(nominal, {{u, &y0}, {t, &y1}, {c_m0, &m0}, {c_m1, &m1}, {slope, query}});
+}
+
+udouble CubicSpline::operator()(double x) const {
+    return evaluate(locate(x_, x), x, nullptr);
+}
+
+udouble CubicSpline::operator()(const udouble& x) const {
+    return evaluate(locate(x_, x.nominal_value()), x.nominal_value(), &x);
+}
+
+std::vector<udouble> CubicSpline::operator()(const std::vector<udouble>& xs) const {
+    return evaluate_batch(x_, xs, [this](std::size_t s, double x, const udouble* query) {
+        return evaluate(s, x, query);
+    });
+}
+
+} // namespace uncertainties
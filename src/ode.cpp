@@ -0,0 +1,266 @@
+#include "uncertainties/ode.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace uncertainties {
+
+namespace {
+
+// Dormand–Prince 5(4) tableau
+constexpr double C2 = 1.0 / 5, C3 = 3.0 / 10, C4 = 4.0 / 5, C5 = 8.0 / 9;
+constexpr double A21 = 1.0 / 5;
+constexpr double A31 = 3.0 / 40, A32 = 9.0 / 40;
+constexpr double A41 = 44.0 / 45, A42 = -56.0 / 15, A43 = 32.0 / 9;
+constexpr double A51 = 19372.0 / 6561, A52 = -25360.0 / 2187, A53 = 64448.0 / 6561,
+                 A54 = -212.0 / 729;
+constexpr double A61 = 9017.0 / 3168, A62 = -355.0 / 33, A63 = 46732.0 / 5247,
+                 A64 = 49.0 / 176, A65 = -5103.0 / 18656;
+constexpr double B1 = 35.0 / 384, B3 = 500.0 / 1113, B4 = 125.0 / 192, B5 = -2187.0 / 6784,
+                 B6 = 11.0 / 84;
+// Difference between the 5th and 4th order weights
+constexpr double E1 = 71.0 / 57600, E3 = -71.0 / 16695, E4 = 71.0 / 1920,
+                 E5 = -17253.0 / 339200, E6 = 22.0 / 525, E7 = -1.0 / 40;
+
+// Augmented system z = (y, S) with S = ∂y/∂u stored row-major after y
+class SensitivitySystem {
+public:
+    SensitivitySystem(const Formula& rhs, std::size_t states, const std::vector<double>& params,
+                      std::size_t lanes)
+        : tangents_(rhs, lanes), states_(states), lanes_(lanes),
+          x_(1 + states + params.size()), seeds_((1 + states + params.size()) * lanes, 0.0)
+    {
+        std::copy(params.begin(), params.end(), x_.begin() + 1 + states);
+    }
+
+    /** @brief Seed the tangent of parameter `p` on lane `lane`. */
+    void seed_parameter(std::size_t p, std::size_t lane) {
+        seeds_[(1 + states_ + p) * lanes_ + lane] = 1.0;
+    }
+
+    // dz = (f(t, y, p), ∂f/∂y S + ∂f/∂p)
+    void operator()(double t, const double* z, double* dz) {
+        x_[0] = t;
+        std::copy(z, z + states_, x_.begin() + 1);
+        std::copy(z + states_, z + states_ * (1 + lanes_), seeds_.begin() + lanes_);
+        tangents_.evaluate(x_.data(), seeds_.data(), dz, dz + states_);
+        ++evaluations;
+    }
+
+    std::size_t evaluations = 0;
+
+private:
+    FormulaTangents tangents_;
+    std::size_t states_;
+    std::size_t lanes_;
+    std::vector<double> x_;
+    std::vector<double> seeds_;  ///< Rows: t, y (= S), p (unit vectors)
+};
+
+} // namespace
+
+double OdeSolution::nominal(std::size_t i, std::size_t state) const {
+    if (i >= times_.size() || state >= num_states_) {
+        throw std::out_of_range("OdeSolution: time or state index out of range.");
+    }
+    return nominals_[i * num_states_ + state];
+}
+
+double OdeSolution::sensitivity(std::size_t i, std::size_t state, std::size_t column) const {
+    if (i >= times_.size() || state >= num_states_ || column >= inputs_.size()) {
+        throw std::out_of_range("OdeSolution: time, state or column index out of range.");
+    }
+    return sensitivities_[(i * num_states_ + state) * inputs_.size() + column];
+}
+
+udouble OdeSolution::value(std::size_t i, std::size_t state) const {
+    double nominal_value = nominal(i, state);
+    const double* row = sensitivities_.data() + (i * num_states_ + state) * inputs_.size();
+    udouble::DerivativeMap derivatives;
+    for (std::size_t c = 0; c < inputs_.size(); ++c) {
+        if (row[c] == 0.0) {
+            continue;
+        }
+        for (const auto& [id, deriv] : inputs_[c].derivatives()) {
+            derivatives[id] += row[c] * deriv;
+        }
+    }
+    return udouble::from_derivatives(nominal_value, std::move(derivatives));
+}
+
+std::vector<udouble> OdeSolution::state(std::size_t i) const {
+    std::vector<udouble> out;
+    out.reserve(num_states_);
+    for (std::size_t s = 0; s < num_states_; ++s) {
+        out.push_back(value(i, s));
+    }
+    return out;
+}
+
+OdeSolution solve_ode(const Formula& rhs, const std::vector<udouble>& y0,
+                      const std::vector<udouble>& params, double t0,
+                      const std::vector<double>& t_out, const OdeOptions& options)
+{
+    const std::size_t n = y0.size();
+    if (rhs.num_inputs() != 1 + n + params.size() || rhs.num_outputs() != n) {
+        throw std::invalid_argument("solve_ode: the formula must take (t, y..., p...) and return one "
+                                    "derivative per state.");
+    }
+    const double direction = t_out.empty() || t_out.back() >= t0 ? 1.0 : -1.0;
+    double previous = t0;
+    for (double t : t_out) {
+        if ((t - previous) * direction < 0.0) {
+            throw std::invalid_argument("solve_ode: output times must be ordered in the direction of integration.");
+        }
+        previous = t;
+    }
+
+    OdeSolution solution;
+    solution.num_states_ = n;
+    solution.times_ = t_out;
+
+    // One sensitivity lane per uncertain initial state or parameter
+    std::vector<std::size_t> state_lane(n, SIZE_MAX);
+    std::vector<std::size_t> param_lane(params.size(), SIZE_MAX);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (y0[i].num_variables() > 0) {
+            state_lane[i] = solution.inputs_.size();
+            solution.inputs_.push_back(y0[i]);
+        }
+    }
+    for (std::size_t j = 0; j < params.size(); ++j) {
+        if (params[j].num_variables() > 0) {
+            param_lane[j] = solution.inputs_.size();
+            solution.inputs_.push_back(params[j]);
+        }
+    }
+    const std::size_t lanes = solution.inputs_.size();
+
+    std::vector<double> param_values(params.size());
+    for (std::size_t j = 0; j < params.size(); ++j) {
+        param_values[j] = params[j].nominal_value();
+    }
+    SensitivitySystem system(rhs, n, param_values, lanes);
+    for (std::size_t j = 0; j < params.size(); ++j) {
+        if (param_lane[j] != SIZE_MAX) {
+            system.seed_parameter(j, param_lane[j]);
+        }
+    }
+
+    const std::size_t size = n * (1 + lanes);
+    const std::size_t controlled = options.control_sensitivities ? size : n;
+    std::vector<double> z(size, 0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+        z[i] = y0[i].nominal_value();
+        if (state_lane[i] != SIZE_MAX) {
+            z[n + i * lanes + state_lane[i]] = 1.0;
+        }
+    }
+
+    std::vector<double> k1(size), k2(size), k3(size), k4(size), k5(size), k6(size), k7(size);
+    std::vector<double> stage(size), z_new(size);
+    auto error_norm = [&](const std::vector<double>& a, const std::vector<double>& b,
+                          const std::vector<double>& e) {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < controlled; ++i) {
+            double scale = options.atol + options.rtol * std::max(std::abs(a[i]), std::abs(b[i]));
+            double r = e[i] / scale;
+            sum += r * r;
+        }
+        return controlled == 0 ? 0.0 : std::sqrt(sum / static_cast<double>(controlled));
+    };
+
+    double t = t0;
+    system(t, z.data(), k1.data());
+    double span = t_out.empty() ? 0.0 : std::abs(t_out.back() - t0);
+    double h = options.initial_step;
+    if (h <= 0.0) {
+        double d0 = error_norm(z, z, z);
+        double d1 = error_norm(z, z, k1);
+        h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+        if (span > 0.0) {
+            h = std::min(h, span);
+        }
+    }
+    if (options.max_step > 0.0) {
+        h = std::min(h, options.max_step);
+    }
+
+    std::size_t steps = 0;
+    solution.nominals_.reserve(t_out.size() * n);
+    solution.sensitivities_.reserve(t_out.size() * n * lanes);
+    for (double target : t_out) {
+        while ((target - t) * direction > 1e-14 * std::max(1.0, std::abs(target))) {
+            if (++steps > options.max_steps) {
+                throw std::runtime_error("solve_ode: maximum number of steps exceeded at t = " +
+                                         std::to_string(t) + ".");
+            }
+            if (h < 1e-14 * std::max(1.0, std::abs(t))) {
+                throw std::runtime_error("solve_ode: step size underflow at t = " + std::to_string(t) + ".");
+            }
+            bool last = h >= (target - t) * direction;
+            double step = direction * (last ? (target - t) * direction : h);
+
+            for (std::size_t i = 0; i < size; ++i) {
+                stage[i] = z[i] + step * A21 * k1[i];
+            }
+            system(t + C2 * step, stage.data(), k2.data());
+            for (std::size_t i = 0; i < size; ++i) {
+                stage[i] = z[i] + step * (A31 * k1[i] + A32 * k2[i]);
+            }
+            system(t + C3 * step, stage.data(), k3.data());
+            for (std::size_t i = 0; i < size; ++i) {
+                stage[i] = z[i] + step * (A41 * k1[i] + A42 * k2[i] + A43 * k3[i]);
+            }
+            system(t + C4 * step, stage.data(), k4.data());
+            for (std::size_t i = 0; i < size; ++i) {
+                stage[i] = z[i] + step * (A51 * k1[i] + A52 * k2[i] + A53 * k3[i] + A54 * k4[i]);
+            }
+            system(t + C5 * step, stage.data(), k5.data());
+            for (std::size_t i = 0; i < size; ++i) {
+                stage[i] = z[i] + step * (A61 * k1[i] + A62 * k2[i] + A63 * k3[i] + A64 * k4[i] +
+                                          A65 * k5[i]);
+            }
+            system(t + step, stage.data(), k6.data());
+            for (std::size_t i = 0; i < size; ++i) {
+                z_new[i] = z[i] + step * (B1 * k1[i] + B3 * k3[i] + B4 * k4[i] + B5 * k5[i] +
+                                          B6 * k6[i]);
+            }
+            double t_new = last ? target : t + step;
+            system(t_new, z_new.data(), k7.data());
+
+            // Reuse stage as the error estimate
+            for (std::size_t i = 0; i < size; ++i) {
+                stage[i] = step * (E1 * k1[i] + E3 * k3[i] + E4 * k4[i] + E5 * k5[i] + E6 * k6[i] +
+                                   E7 * k7[i]);
+            }
+            double error = error_norm(z, z_new, stage);
+
+            double factor = error == 0.0 ? 5.0 : std::clamp(0.9 * std::pow(error, -0.2), 0.2, 5.0);
+            if (error <= 1.0) {
+                t = t_new;
+                z.swap(z_new);
+                k1.swap(k7);  // first same as last
+                ++solution.accepted_;
+                // A step shortened to hit an output time says little about the next one
+                if (!last || factor < 1.0) {
+                    h = std::abs(step) * factor;
+                }
+            } else {
+                ++solution.rejected_;
+                h = std::abs(step) * std::min(factor, 1.0);
+            }
+            if (options.max_step > 0.0) {
+                h = std::min(h, options.max_step);
+            }
+        }
+        solution.nominals_.insert(solution.nominals_.end(), z.begin(), z.begin() + n);
+        solution.sensitivities_.insert(solution.sensitivities_.end(), z.begin() + n, z.end());
+    }
+    solution.evaluations_ = system.evaluations;
+    return solution;
+}
+
+} // namespace uncertainties
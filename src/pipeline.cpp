@@ -0,0 +1,102 @@
+#include "uncertainties/pipeline.hpp"
+#include "uncertainties/variable_registry.hpp"
+#include <algorithm>
+#include <string>
+
+namespace uncertainties {
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0) {
+        threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers_.emplace_back([this] { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool ThreadPool::reserve_worker()
+{
+    std::lock_guard lock(mutex_);
+    if (reserved_ >= workers_.size()) {
+        return false;
+    }
+    ++reserved_;
+    return true;
+}
+
+void ThreadPool::release_worker()
+{
+    std::lock_guard lock(mutex_);
+    --reserved_;
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    ready_.notify_one();
+}
+
+void ThreadPool::work()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            ready_.wait(lock, [&] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        // Exceptions are captured by the packaged task
+        task();
+    }
+}
+
+std::vector<udouble> register_batch(const std::vector<double>& nominal, const std::vector<double>& stddev)
+{
+    if (nominal.size() != stddev.size()) {
+        throw std::invalid_argument("register_batch: " + std::to_string(nominal.size()) + " nominal values but " +
+                                    std::to_string(stddev.size()) + " stddevs.");
+    }
+    for (double sigma : stddev) {
+        if (sigma < 0.0) {
+            throw std::invalid_argument("Standard deviation cannot be negative.");
+        }
+    }
+    auto& registry = detail::VariableRegistry::instance();
+    const std::size_t n = nominal.size();
+    const uint64_t first = registry.reserve_ids(n);
+    registry.register_ids(first, stddev.data(), n);
+
+    std::vector<udouble> values;
+    values.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (stddev[i] > 0.0) {
+            values.push_back(udouble::from_derivatives(nominal[i], {{first + i, 1.0}}));
+        } else {
+            values.emplace_back(nominal[i]);
+        }
+    }
+    return values;
+}
+
+} // namespace uncertainties
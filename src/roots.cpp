@@ -0,0 +1,159 @@
+#include "uncertainties/roots.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace uncertainties {
+
+namespace {
+
+void check_signature(const Formula& f, const std::vector<udouble>& params) {
+    if (f.num_inputs() != 1 + params.size() || f.num_outputs() != 1) {
+        throw std::invalid_argument("Root finding needs a formula of (x, p...) with one output.");
+    }
+}
+
+} // namespace
+
+udouble implicit_root(const Formula& f, double root, const std::vector<udouble>& params)
+{
+    check_signature(f, params);
+
+    // Lane 0 is ∂/∂x, then one lane per uncertain parameter
+    std::vector<std::size_t> uncertain;
+    for (std::size_t j = 0; j < params.size(); ++j) {
+        if (params[j].num_variables() > 0) {
+            uncertain.push_back(j);
+        }
+    }
+    const std::size_t lanes = 1 + uncertain.size();
+    const std::size_t inputs = f.num_inputs();
+    std::vector<double> x(inputs);
+    std::vector<double> seeds(inputs * lanes, 0.0);
+    x[0] = root;
+    seeds[0] = 1.0;
+    for (std::size_t j = 0; j < params.size(); ++j) {
+        x[1 + j] = params[j].nominal_value();
+    }
+    for (std::size_t c = 0; c < uncertain.size(); ++c) {
+        seeds[(1 + uncertain[c]) * lanes + 1 + c] = 1.0;
+    }
+
+    double value = 0.0;
+    std::vector<double> tangents(lanes);
+    FormulaTangents(f, lanes).evaluate(x.data(), seeds.data(), &value, tangents.data());
+
+    const double f_x = tangents[0];
+    if (f_x == 0.0 || !std::isfinite(f_x)) {
+        throw std::runtime_error("Root finding: ∂f/∂x vanishes at the root " + std::to_string(root) + ".");
+    }
+    udouble::DerivativeMap derivatives;
+    for (std::size_t c = 0; c < uncertain.size(); ++c) {
+        double dx = -tangents[1 + c] / f_x;
+        for (const auto& [id, deriv] : params[uncertain[c]].derivatives()) {
+            derivatives[id] += dx * deriv;
+        }
+    }
+    return udouble::from_derivatives(root, std::move(derivatives));
+}
+
+// Brent's method: inverse quadratic interpolation or secant steps, falling
+// back to bisection whenever they do not shrink the bracket fast enough
+udouble find_root(const Formula& f, double lower, double upper,
+                  const std::vector<udouble>& params, const RootOptions& options)
+{
+    check_signature(f, params);
+    const std::size_t inputs = f.num_inputs();
+    std::vector<double> x(inputs);
+    for (std::size_t j = 0; j < params.size(); ++j) {
+        x[1 + j] = params[j].nominal_value();
+    }
+    std::vector<double> seeds(inputs, 0.0);
+    double tangent = 0.0;
+    FormulaTangents evaluator(f, 0);
+    auto eval = [&](double at) {
+        double value = 0.0;
+        x[0] = at;
+        evaluator.evaluate(x.data(), seeds.data(), &value, &tangent);
+        return value;
+    };
+
+    double a = lower;
+    double b = upper;
+    double fa = eval(a);
+    double fb = eval(b);
+    if (fa == 0.0) {
+        return implicit_root(f, a, params);
+    }
+    if (fb == 0.0) {
+        return implicit_root(f, b, params);
+    }
+    if ((fa > 0.0) == (fb > 0.0)) {
+        throw std::invalid_argument("Root finding: f has the same sign at both ends of the bracket.");
+    }
+
+    const double eps = std::numeric_limits<double>::epsilon();
+    double c = a;
+    double fc = fa;
+    double d = b - a;
+    double e = d;
+    for (std::size_t iteration = 0; iteration < options.max_iterations; ++iteration) {
+        if ((fb > 0.0) == (fc > 0.0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (std::abs(fc) < std::abs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        const double tol = 2.0 * eps * std::abs(b) + 0.5 * options.xtol +
+                           std::numeric_limits<double>::min();
+        const double m = 0.5 * (c - b);
+        if (std::abs(m) <= tol || fb == 0.0) {
+            return implicit_root(f, b, params);
+        }
+        if (std::abs(e) >= tol && std::abs(fa) > std::abs(fb)) {
+            double s = fb / fa;
+            double p;
+            double q;
+            if (a == c) {
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            } else {
+                double r = fb / fc;
+                q = fa / fc;
+                p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0) {
+                q = -q;
+            } else {
+                p = -p;
+            }
+            if (2.0 * p < std::min(3.0 * m * q - std::abs(tol * q), std::abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = m;
+            }
+        } else {
+            d = m;
+            e = m;
+        }
+        a = b;
+        fa = fb;
+        b += std::abs(d) > tol ? d : (m > 0.0 ? tol : -tol);
+        fb = eval(b);
+    }
+    throw std::runtime_error("Root finding did not converge in " +
+                             std::to_string(options.max_iterations) + " iterations.");
+}
+
+} // namespace uncertainties
@@ -0,0 +1,193 @@
+#include "uncertainties/scan.hpp"
+#include "uncertainties/parallel.hpp"
+#include "uncertainties/running_derivatives.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace uncertainties {
+
+using detail::RunningDerivatives;
+
+// Output k of an inclusive scan is out_k = out_{k-1} ⊕ x_k, so its
+// derivatives follow from the previous output's in O(|∂x_k|):
+//   sum:     d_k = d_{k-1} + ∂x_k
+//   product: d_k = x_k d_{k-1} + out_{k-1} ∂x_k
+template <typename Visit>
+void ScanResult::sweep(Visit&& visit) const {
+    RunningDerivatives running;
+    for (std::size_t k = 0; k < inputs_.size(); ++k) {
+        if (op_ == ScanOp::Sum) {
+            running.add_scaled(inputs_[k], 1.0);
+        } else {
+            double x = inputs_[k].nominal_value();
+            double previous = k == 0 ? 1.0 : inclusive_[k - 1];
+            if (x == 0.0) {
+                running.reset();
+            } else {
+                running.scale *= x;
+            }
+            if (previous != 0.0) {
+                running.add_scaled(inputs_[k], previous);
+            }
+            running.normalize();
+        }
+        visit(k, running);
+    }
+}
+
+ScanResult scan(const std::vector<udouble>& xs, ScanOp op, bool exclusive,
+                const ScanOptions& options)
+{
+    ScanResult result;
+    result.op_ = op;
+    result.exclusive_ = exclusive;
+    result.inputs_ = xs;
+
+    const std::size_t n = xs.size();
+    const double identity = op == ScanOp::Sum ? 0.0 : 1.0;
+    result.inclusive_.resize(n);
+    if (op == ScanOp::Product) {
+        result.nonzero_product_.resize(n);
+        result.zeros_.resize(n);
+    }
+
+    // Parallel scan of the nominals: scan each block locally, carry the
+    // block totals sequentially, then apply the carries. Block boundaries
+    // depend only on block_size, so results do not depend on the thread count.
+    const std::size_t block = std::max<std::size_t>(1, options.block_size);
+    const std::size_t blocks = (n + block - 1) / block;
+    const std::size_t threads = detail::resolve_thread_count(options.threads, blocks);
+    auto block_range = [&](std::size_t b) {
+        return std::make_pair(b * block, std::min(n, (b + 1) * block));
+    };
+
+    detail::parallel_for(blocks, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t b = begin; b < end; ++b) {
+            auto [first, last] = block_range(b);
+            if (op == ScanOp::Sum) {
+                double sum = 0.0;
+                for (std::size_t i = first; i < last; ++i) {
+                    sum += xs[i].nominal_value();
+                    result.inclusive_[i] = sum;
+                }
+            } else {
+                double product = 1.0;
+                std::size_t zeros = 0;
+                for (std::size_t i = first; i < last; ++i) {
+                    double x = xs[i].nominal_value();
+                    if (x == 0.0) {
+                        ++zeros;
+                    } else {
+                        product *= x;
+                    }
+                    result.nonzero_product_[i] = product;
+                    result.zeros_[i] = zeros;
+                }
+            }
+        }
+    });
+
+    std::vector<double> carry(blocks, identity);
+    std::vector<std::size_t> carry_zeros(blocks, 0);
+    for (std::size_t b = 1; b < blocks; ++b) {
+        std::size_t last = block_range(b - 1).second - 1;
+        if (op == ScanOp::Sum) {
+            carry[b] = carry[b - 1] + result.inclusive_[last];
+        } else {
+            carry[b] = carry[b - 1] * result.nonzero_product_[last];
+            carry_zeros[b] = carry_zeros[b - 1] + result.zeros_[last];
+        }
+    }
+
+    detail::parallel_for(blocks, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t b = begin; b < end; ++b) {
+            auto [first, last] = block_range(b);
+            for (std::size_t i = first; i < last; ++i) {
+                if (op == ScanOp::Sum) {
+                    if (b > 0) {
+                        result.inclusive_[i] += carry[b];
+                    }
+                } else {
+                    result.nonzero_product_[i] *= carry[b];
+                    result.zeros_[i] += carry_zeros[b];
+                    result.inclusive_[i] = result.zeros_[i] > 0 ? 0.0 : result.nonzero_product_[i];
+                }
+            }
+        }
+    });
+
+    if (exclusive) {
+        result.nominals_.reserve(n);
+        if (n > 0) {
+            result.nominals_.push_back(identity);
+            result.nominals_.insert(result.nominals_.end(), result.inclusive_.begin(),
+                                    result.inclusive_.end() - 1);
+        }
+    } else {
+        result.nominals_ = result.inclusive_;
+    }
+
+    // Stddevs in one incremental pass over the inputs' derivatives
+    result.stddevs_.assign(n, 0.0);
+    std::size_t shift = exclusive ? 1 : 0;
+    result.sweep([&](std::size_t k, const RunningDerivatives& running) {
+        if (k + shift < n) {
+            result.stddevs_[k + shift] = running.stddev();
+        }
+    });
+    return result;
+}
+
+double ScanResult::coefficient(std::size_t k, std::size_t i) const {
+    if (k >= size() || i >= row_length(k)) {
+        return 0.0;
+    }
+    if (op_ == ScanOp::Sum) {
+        return 1.0;
+    }
+    // Product of the row's inputs except x_i
+    std::size_t row = exclusive_ ? k - 1 : k;
+    double x = inputs_[i].nominal_value();
+    switch (zeros_[row]) {
+    case 0:
+        return nonzero_product_[row] / x;
+    case 1:
+        return x == 0.0 ? nonzero_product_[row] : 0.0;
+    default:
+        return 0.0;
+    }
+}
+
+udouble ScanResult::value(std::size_t k) const {
+    if (k >= size()) {
+        throw std::out_of_range("Scan output index out of range");
+    }
+    udouble::DerivativeMap derivatives;
+    for (std::size_t i = 0; i < row_length(k); ++i) {
+        double c = coefficient(k, i);
+        if (c == 0.0) {
+            continue;
+        }
+        for (const auto& [id, deriv] : inputs_[i].derivatives()) {
+            derivatives[id] += c * deriv;
+        }
+    }
+    return udouble::from_derivatives(nominals_[k], std::move(derivatives));
+}
+
+std::vector<udouble> ScanResult::values() const {
+    std::vector<udouble> out;
+    out.reserve(size());
+    if (exclusive_ && size() > 0) {
+        out.emplace_back(nominals_[0]);
+    }
+    sweep([&](std::size_t, const RunningDerivatives& running) {
+        if (out.size() == size()) {
+            return;
+        }
+        out.push_back(udouble::from_derivatives(nominals_[out.size()], running.derivatives()));
+    });
+    return out;
+}
+
+} // namespace uncertainties
@@ -0,0 +1,143 @@
+#include "uncertainties/shared_registry.hpp"
+#include "uncertainties/variable_registry.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define UNCERTAINTIES_HAVE_SHM 1
+#endif
+
+namespace uncertainties {
+
+#ifdef UNCERTAINTIES_HAVE_SHM
+
+namespace {
+
+std::runtime_error system_error(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " shared registry '" + name + "': " + std::strerror(errno));
+}
+
+// Size of the current mapping, needed by munmap
+std::size_t mapped_bytes = 0;
+
+void unmap(detail::SharedRegistryTable* table)
+{
+    munmap(table, mapped_bytes);
+    mapped_bytes = 0;
+}
+
+} // namespace
+
+void attach_shared_registry(const std::string& name, const SharedRegistryOptions& options)
+{
+    auto& registry = detail::VariableRegistry::instance();
+    if (registry.shared() != nullptr) {
+        throw std::runtime_error("A shared registry is already attached.");
+    }
+    if (options.capacity == 0) {
+        throw std::invalid_argument("Shared registry capacity must be positive.");
+    }
+
+    bool created = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        throw system_error("Cannot open", name);
+    }
+
+    std::size_t bytes = 0;
+    if (created) {
+        // At most half full, so probe sequences stay short
+        uint64_t slots = 1;
+        while (slots < 2 * static_cast<uint64_t>(options.capacity)) {
+            slots <<= 1;
+        }
+        bytes = detail::SharedRegistryTable::bytes(slots);
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            int saved = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            errno = saved;
+            throw system_error("Cannot size", name);
+        }
+    } else {
+        // The creator may not have sized the segment yet
+        struct stat info{};
+        while (fstat(fd, &info) == 0 && info.st_size == 0) {
+            std::this_thread::yield();
+        }
+        if (static_cast<std::size_t>(info.st_size) < sizeof(detail::SharedRegistryTable)) {
+            close(fd);
+            throw std::runtime_error("'" + name + "' is not a shared registry segment.");
+        }
+        bytes = static_cast<std::size_t>(info.st_size);
+    }
+
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        throw system_error("Cannot map", name);
+    }
+
+    detail::SharedRegistryTable* table = nullptr;
+    if (created) {
+        uint64_t slots = (bytes - sizeof(detail::SharedRegistryTable)) / sizeof(detail::SharedRegistryTable::Slot);
+        table = detail::SharedRegistryTable::create(memory, slots);
+    } else {
+        table = static_cast<detail::SharedRegistryTable*>(memory);
+        // The creator publishes the magic number last
+        while (table->magic.load(std::memory_order_acquire) != detail::SharedRegistryTable::MAGIC) {
+            std::this_thread::yield();
+        }
+        if (detail::SharedRegistryTable::bytes(table->slot_count) != bytes) {
+            munmap(memory, bytes);
+            throw std::runtime_error("'" + name + "' is not a shared registry segment.");
+        }
+    }
+    mapped_bytes = bytes;
+    registry.attach_shared(table, unmap);
+}
+
+void detach_shared_registry()
+{
+    detail::SharedRegistryTable* table = detail::VariableRegistry::instance().detach_shared();
+    if (table != nullptr) {
+        unmap(table);
+    }
+}
+
+void remove_shared_registry(const std::string& name)
+{
+    if (shm_unlink(name.c_str()) != 0 && errno != ENOENT) {
+        throw system_error("Cannot remove", name);
+    }
+}
+
+#else
+
+void attach_shared_registry(const std::string&, const SharedRegistryOptions&)
+{
+    throw std::runtime_error("Shared registries need POSIX shared memory.");
+}
+
+void detach_shared_registry() {}
+
+void remove_shared_registry(const std::string&) {}
+
+#endif
+
+bool shared_registry_attached()
+{
+    return detail::VariableRegistry::instance().shared() != nullptr;
+}
+
+} // namespace uncertainties
@@ -0,0 +1,261 @@
+#include "uncertainties/sparse.hpp"
+#include "uncertainties/parallel.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace uncertainties {
+
+namespace {
+
+// Rows per thread below which threading does not pay off
+constexpr std::size_t MIN_ROWS_PER_THREAD = 256;
+
+template <typename Vector>
+void check_product(const SparseUMatrix& A, const Vector& x) {
+    if (x.size() != A.cols()) {
+        throw std::invalid_argument("spmv: vector of size " + std::to_string(x.size()) +
+                                    " does not match a matrix with " + std::to_string(A.cols()) +
+                                    " columns.");
+    }
+}
+
+// Rows in parallel; `row_value(i, derivatives)` returns the nominal value of
+// row i and accumulates its derivatives
+template <typename RowValue>
+std::vector<udouble> for_each_row(const SparseUMatrix& A, const SparseOptions& options,
+                                  RowValue&& row_value) {
+    std::vector<udouble> y(A.rows());
+    std::size_t threads = detail::resolve_thread_count(options.threads, A.rows(), MIN_ROWS_PER_THREAD);
+    detail::parallel_for(A.rows(), threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            udouble::DerivativeMap derivatives;
+            double nominal = row_value(i, derivatives);
+            y[i] = udouble::from_derivatives(nominal, std::move(derivatives));
+        }
+    });
+    return y;
+}
+
+} // namespace
+
+SparseUMatrix::SparseUMatrix(std::size_t rows, std::size_t cols, const std::vector<SparseEntry>& entries)
+    : rows_(rows), cols_(cols), row_offsets_(rows + 1, 0)
+{
+    std::vector<std::size_t> order(entries.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    for (const auto& entry : entries) {
+        if (entry.row >= rows || entry.col >= cols) {
+            throw std::invalid_argument("SparseUMatrix: entry (" + std::to_string(entry.row) + ", " +
+                                        std::to_string(entry.col) + ") lies outside the matrix.");
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return entries[a].row != entries[b].row ? entries[a].row < entries[b].row
+                                                : entries[a].col < entries[b].col;
+    });
+
+    columns_.reserve(entries.size());
+    values_.reserve(entries.size());
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        const SparseEntry& entry = entries[order[k]];
+        bool duplicate = k > 0 && entry.row == entries[order[k - 1]].row &&
+                         entry.col == entries[order[k - 1]].col;
+        if (duplicate) {
+            values_.back() += entry.value;
+            continue;
+        }
+        columns_.push_back(entry.col);
+        values_.push_back(entry.value);
+        ++row_offsets_[entry.row + 1];
+    }
+    std::partial_sum(row_offsets_.begin(), row_offsets_.end(), row_offsets_.begin());
+    nominals_.reserve(values_.size());
+    for (const auto& value : values_) {
+        nominals_.push_back(value.nominal_value());
+    }
+}
+
+udouble SparseUMatrix::coeff(std::size_t row, std::size_t col) const {
+    if (row >= rows_ || col >= cols_) {
+        throw std::out_of_range("SparseUMatrix: index out of range.");
+    }
+    auto first = columns_.begin() + static_cast<std::ptrdiff_t>(row_offsets_[row]);
+    auto last = columns_.begin() + static_cast<std::ptrdiff_t>(row_offsets_[row + 1]);
+    auto it = std::lower_bound(first, last, col);
+    if (it == last || *it != col) {
+        return udouble(0.0);
+    }
+    return values_[static_cast<std::size_t>(it - columns_.begin())];
+}
+
+SparseUMatrix SparseUMatrix::transpose() const {
+    std::vector<SparseEntry> entries;
+    entries.reserve(values_.size());
+    for (std::size_t i = 0; i < rows_; ++i) {
+        for (std::size_t k = row_offsets_[i]; k < row_offsets_[i + 1]; ++k) {
+            entries.push_back({columns_[k], i, values_[k]});
+        }
+    }
+    return SparseUMatrix(cols_, rows_, entries);
+}
+
+std::vector<udouble> spmv(const SparseUMatrix& A, const std::vector<udouble>& x,
+                          const SparseOptions& options)
+{
+    check_product(A, x);
+    const auto& offsets = A.row_offsets();
+    const auto& columns = A.column_indices();
+    const auto& values = A.values();
+    const auto& nominals = A.nominal_values();
+    std::vector<double> x_nominal(x.size());
+    for (std::size_t j = 0; j < x.size(); ++j) {
+        x_nominal[j] = x[j].nominal_value();
+    }
+    // dy_i = Σ_k (x_k da_ik + a_ik dx_k)
+    return for_each_row(A, options, [&](std::size_t i, udouble::DerivativeMap& derivatives) {
+        double sum = 0.0;
+        for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const std::size_t j = columns[k];
+            sum += nominals[k] * x_nominal[j];
+            if (values[k].num_variables() > 0 && x_nominal[j] != 0.0) {
+                for (const auto& [id, deriv] : values[k].derivatives()) {
+                    derivatives[id] += x_nominal[j] * deriv;
+                }
+            }
+            if (x[j].num_variables() > 0 && nominals[k] != 0.0) {
+                for (const auto& [id, deriv] : x[j].derivatives()) {
+                    derivatives[id] += nominals[k] * deriv;
+                }
+            }
+        }
+        return sum;
+    });
+}
+
+std::vector<udouble> spmv(const SparseUMatrix& A, const std::vector<double>& x,
+                          const SparseOptions& options)
+{
+    check_product(A, x);
+    const auto& offsets = A.row_offsets();
+    const auto& columns = A.column_indices();
+    const auto& values = A.values();
+    const auto& nominals = A.nominal_values();
+    return for_each_row(A, options, [&](std::size_t i, udouble::DerivativeMap& derivatives) {
+        double sum = 0.0;
+        for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const double xj = x[columns[k]];
+            sum += nominals[k] * xj;
+            if (values[k].num_variables() > 0 && xj != 0.0) {
+                for (const auto& [id, deriv] : values[k].derivatives()) {
+                    derivatives[id] += xj * deriv;
+                }
+            }
+        }
+        return sum;
+    });
+}
+
+std::vector<udouble> triangular_solve(const SparseUMatrix& A, const std::vector<udouble>& b,
+                                      Triangle triangle, const SparseOptions& options)
+{
+    const std::size_t n = A.rows();
+    if (A.cols() != n) {
+        throw std::invalid_argument("triangular_solve: the matrix must be square.");
+    }
+    if (b.size() != n) {
+        throw std::invalid_argument("triangular_solve: right-hand side of size " +
+                                    std::to_string(b.size()) + " does not match a matrix with " +
+                                    std::to_string(n) + " rows.");
+    }
+    const auto& offsets = A.row_offsets();
+    const auto& columns = A.column_indices();
+    const auto& values = A.values();
+    const auto& nominals = A.nominal_values();
+    const bool lower = triangle == Triangle::Lower;
+    auto in_triangle = [&](std::size_t i, std::size_t j) { return lower ? j <= i : j >= i; };
+
+    // Nominal substitution, recording the diagonal and the level of every row
+    std::vector<double> x(n);
+    std::vector<double> diagonal(n, 0.0);
+    std::vector<std::size_t> level(n, 0);
+    std::size_t levels = 0;
+    for (std::size_t step = 0; step < n; ++step) {
+        const std::size_t i = lower ? step : n - 1 - step;
+        double sum = b[i].nominal_value();
+        for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const std::size_t j = columns[k];
+            if (j == i) {
+                diagonal[i] = nominals[k];
+            } else if (in_triangle(i, j)) {
+                sum -= nominals[k] * x[j];
+                level[i] = std::max(level[i], level[j] + 1);
+            }
+        }
+        if (diagonal[i] == 0.0) {
+            throw std::runtime_error("triangular_solve: zero or missing diagonal entry in row " +
+                                     std::to_string(i) + ".");
+        }
+        x[i] = sum / diagonal[i];
+        levels = std::max(levels, level[i] + 1);
+    }
+
+    // Rows grouped by level
+    std::vector<std::size_t> level_offsets(levels + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        ++level_offsets[level[i] + 1];
+    }
+    std::partial_sum(level_offsets.begin(), level_offsets.end(), level_offsets.begin());
+    std::vector<std::size_t> by_level(n);
+    {
+        std::vector<std::size_t> fill(level_offsets.begin(), level_offsets.end() - 1);
+        for (std::size_t i = 0; i < n; ++i) {
+            by_level[fill[level[i]]++] = i;
+        }
+    }
+
+    // dx_i = (db_i − Σ_j da_ij x_j − Σ_{j≠i} a_ij dx_j) / a_ii
+    std::vector<udouble::DerivativeMap> dx(n);
+    for (std::size_t l = 0; l < levels; ++l) {
+        const std::size_t first = level_offsets[l];
+        const std::size_t count = level_offsets[l + 1] - first;
+        std::size_t threads = detail::resolve_thread_count(options.threads, count, MIN_ROWS_PER_THREAD);
+        detail::parallel_for(count, threads, [&](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t r = begin; r < end; ++r) {
+                const std::size_t i = by_level[first + r];
+                udouble::DerivativeMap& derivatives = dx[i];
+                if (b[i].num_variables() > 0) {
+                    derivatives = b[i].derivatives();
+                }
+                for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+                    const std::size_t j = columns[k];
+                    if (!in_triangle(i, j)) {
+                        continue;
+                    }
+                    if (values[k].num_variables() > 0 && x[j] != 0.0) {
+                        for (const auto& [id, deriv] : values[k].derivatives()) {
+                            derivatives[id] -= x[j] * deriv;
+                        }
+                    }
+                    if (j != i && nominals[k] != 0.0) {
+                        for (const auto& [id, deriv] : dx[j]) {
+                            derivatives[id] -= nominals[k] * deriv;
+                        }
+                    }
+                }
+                for (auto& entry : derivatives) {
+                    entry.second /= diagonal[i];
+                }
+            }
+        });
+    }
+
+    std::vector<udouble> result(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        result[i] = udouble::from_derivatives(x[i], std::move(dx[i]));
+    }
+    return result;
+}
+
+} // namespace uncertainties
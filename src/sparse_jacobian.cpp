@@ -0,0 +1,230 @@
+#include "uncertainties/sparse_jacobian.hpp"
+#include "uncertainties/variable_registry.hpp"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace uncertainties {
+
+namespace {
+
+// Jacobian of the formula at x composed with a sparse matrix D that maps
+// `D.cols` columns to the formula inputs: J = J_f(x) · D. Rows of D are
+// formula inputs and must have sorted column indices.
+SparseJacobian compressed_jacobian(const Formula& formula, const std::vector<double>& x,
+                                   const SparseJacobian& D)
+{
+    const SparsityPattern inner = sparsity_pattern(formula);
+
+    // Pattern of the product: row o is the union of the D rows of the
+    // inputs output o depends on
+    SparseJacobian J;
+    J.rows = inner.rows;
+    J.cols = D.cols;
+    J.row_offsets.assign(1, 0);
+    constexpr std::size_t UNSEEN = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> seen(D.cols, UNSEEN);
+    for (std::size_t o = 0; o < inner.rows; ++o) {
+        const std::size_t row_begin = J.column_indices.size();
+        for (std::size_t k = inner.row_offsets[o]; k < inner.row_offsets[o + 1]; ++k) {
+            const std::size_t j = inner.column_indices[k];
+            for (std::size_t m = D.row_offsets[j]; m < D.row_offsets[j + 1]; ++m) {
+                const std::size_t col = D.column_indices[m];
+                if (seen[col] != o) {
+                    seen[col] = o;
+                    J.column_indices.push_back(col);
+                }
+            }
+        }
+        std::sort(J.column_indices.begin() + static_cast<std::ptrdiff_t>(row_begin), J.column_indices.end());
+        J.row_offsets.push_back(J.column_indices.size());
+    }
+
+    // One tangent lane per color: the seed of input j on lane c sums D(j, col)
+    // over the columns of color c
+    std::size_t colors = 0;
+    const std::vector<std::size_t> color = color_columns(J, colors);
+    const std::size_t inputs = formula.num_inputs();
+    std::vector<double> seeds(inputs * colors, 0.0);
+    for (std::size_t j = 0; j < inputs; ++j) {
+        for (std::size_t m = D.row_offsets[j]; m < D.row_offsets[j + 1]; ++m) {
+            seeds[j * colors + color[D.column_indices[m]]] += D.values[m];
+        }
+    }
+    std::vector<double> y(formula.num_outputs());
+    std::vector<double> tangents(formula.num_outputs() * colors);
+    FormulaTangents(formula, colors).evaluate(x.data(), seeds.data(), y.data(), tangents.data());
+
+    // No two columns of a row share a color, so each lane holds one entry
+    J.values.resize(J.nonzeros());
+    for (std::size_t o = 0; o < J.rows; ++o) {
+        for (std::size_t k = J.row_offsets[o]; k < J.row_offsets[o + 1]; ++k) {
+            J.values[k] = tangents[o * colors + color[J.column_indices[k]]];
+        }
+    }
+    return J;
+}
+
+void check_size(const Formula& formula, std::size_t size)
+{
+    if (size != formula.num_inputs()) {
+        throw std::invalid_argument("sparse_jacobian: expected " + std::to_string(formula.num_inputs()) +
+                                    " inputs, got " + std::to_string(size) + ".");
+    }
+}
+
+} // namespace
+
+SparsityPattern sparsity_pattern(const Formula& formula)
+{
+    // Sorted input indices each register depends on
+    std::vector<std::vector<std::size_t>> deps(formula.num_registers_);
+    std::vector<std::size_t> merged;
+    for (const detail::FormulaInstruction& ins : formula.code_) {
+        std::vector<std::size_t>& d = deps[ins.dst];
+        switch (arity(ins.op)) {
+            case 0:
+                d.clear();
+                if (ins.op == detail::FormulaOp::Input) {
+                    d.push_back(ins.a);
+                }
+                break;
+            case 1:
+                d = deps[ins.a];
+                break;
+            default:
+                merged.clear();
+                std::set_union(deps[ins.a].begin(), deps[ins.a].end(), deps[ins.b].begin(),
+                               deps[ins.b].end(), std::back_inserter(merged));
+                d.swap(merged);
+                break;
+        }
+    }
+
+    SparsityPattern pattern;
+    pattern.rows = formula.outputs_.size();
+    pattern.cols = formula.num_inputs_;
+    pattern.row_offsets.assign(1, 0);
+    for (uint32_t reg : formula.outputs_) {
+        const std::vector<std::size_t>& d = deps[reg];
+        pattern.column_indices.insert(pattern.column_indices.end(), d.begin(), d.end());
+        pattern.row_offsets.push_back(pattern.column_indices.size());
+    }
+    return pattern;
+}
+
+std::vector<std::size_t> color_columns(const SparsityPattern& pattern, std::size_t& colors)
+{
+    // Rows of each column (CSC)
+    std::vector<std::size_t> col_offsets(pattern.cols + 1, 0);
+    for (std::size_t col : pattern.column_indices) {
+        ++col_offsets[col + 1];
+    }
+    std::partial_sum(col_offsets.begin(), col_offsets.end(), col_offsets.begin());
+    std::vector<std::size_t> col_rows(pattern.nonzeros());
+    std::vector<std::size_t> fill(col_offsets.begin(), col_offsets.end() - 1);
+    for (std::size_t r = 0; r < pattern.rows; ++r) {
+        for (std::size_t k = pattern.row_offsets[r]; k < pattern.row_offsets[r + 1]; ++k) {
+            col_rows[fill[pattern.column_indices[k]]++] = r;
+        }
+    }
+
+    // Greedy coloring, densest columns first
+    std::vector<std::size_t> order(pattern.cols);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return col_offsets[a + 1] - col_offsets[a] > col_offsets[b + 1] - col_offsets[b];
+    });
+
+    constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> color(pattern.cols, NONE);
+    std::vector<std::size_t> forbidden(pattern.cols, NONE);  // color -> column it is forbidden for
+    colors = 0;
+    for (std::size_t col : order) {
+        for (std::size_t m = col_offsets[col]; m < col_offsets[col + 1]; ++m) {
+            const std::size_t r = col_rows[m];
+            for (std::size_t k = pattern.row_offsets[r]; k < pattern.row_offsets[r + 1]; ++k) {
+                const std::size_t other = color[pattern.column_indices[k]];
+                if (other != NONE) {
+                    forbidden[other] = col;
+                }
+            }
+        }
+        std::size_t c = 0;
+        while (forbidden[c] == col) {
+            ++c;
+        }
+        color[col] = c;
+        colors = std::max(colors, c + 1);
+    }
+    return color;
+}
+
+SparseJacobian sparse_jacobian(const Formula& formula, const std::vector<double>& x)
+{
+    check_size(formula, x.size());
+    const std::size_t n = formula.num_inputs();
+    SparseJacobian identity;
+    identity.rows = identity.cols = n;
+    identity.row_offsets.resize(n + 1);
+    std::iota(identity.row_offsets.begin(), identity.row_offsets.end(), std::size_t{0});
+    identity.column_indices.resize(n);
+    std::iota(identity.column_indices.begin(), identity.column_indices.end(), std::size_t{0});
+    identity.values.assign(n, 1.0);
+    return compressed_jacobian(formula, x, identity);
+}
+
+SparseJacobian sparse_jacobian(const Formula& formula, const std::vector<udouble>& args)
+{
+    check_size(formula, args.size());
+    auto& registry = detail::VariableRegistry::instance();
+
+    std::vector<uint64_t> ids;
+    for (const udouble& arg : args) {
+        for (const auto& [id, deriv] : arg.derivatives()) {
+            ids.push_back(id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    std::unordered_map<uint64_t, std::size_t> column_of;
+    column_of.reserve(ids.size());
+    for (std::size_t c = 0; c < ids.size(); ++c) {
+        column_of.emplace(ids[c], c);
+    }
+
+    // ∂arg/∂atomic, rows sorted by column
+    SparseJacobian D;
+    D.rows = args.size();
+    D.cols = ids.size();
+    D.row_offsets.assign(1, 0);
+    std::vector<std::pair<std::size_t, double>> row;
+    std::vector<double> x(args.size());
+    for (std::size_t j = 0; j < args.size(); ++j) {
+        x[j] = args[j].nominal_value();
+        row.clear();
+        for (const auto& [id, deriv] : args[j].derivatives()) {
+            row.emplace_back(column_of.at(id), deriv);
+        }
+        std::sort(row.begin(), row.end());
+        for (const auto& [col, deriv] : row) {
+            D.column_indices.push_back(col);
+            D.values.push_back(deriv);
+        }
+        D.row_offsets.push_back(D.column_indices.size());
+    }
+
+    SparseJacobian J = compressed_jacobian(formula, x, D);
+    J.sigma.reserve(ids.size());
+    for (uint64_t id : ids) {
+        J.sigma.push_back(registry.get_stddev(id));
+    }
+    J.ids = std::move(ids);
+    return J;
+}
+
+} // namespace uncertainties
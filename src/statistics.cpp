@@ -0,0 +1,295 @@
+#include "uncertainties/statistics.hpp"
+#include "uncertainties/parallel.hpp"
+#include "uncertainties/variable_registry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace uncertainties {
+
+namespace {
+
+constexpr std::size_t MIN_SAMPLES_PER_THREAD = 1 << 15;
+
+// Four independent partial sums let the compiler keep the loop in vector
+// registers without reassociating floating point additions itself
+template <typename Term>
+double blocked_sum(const double* x, std::size_t n, Term term) noexcept {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += term(x[i]);
+        s1 += term(x[i + 1]);
+        s2 += term(x[i + 2]);
+        s3 += term(x[i + 3]);
+    }
+    for (; i < n; ++i) {
+        s0 += term(x[i]);
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+void require_samples(uint64_t count) {
+    if (count < 2) {
+        throw std::runtime_error("Sample statistics need at least two samples, got " +
+                                 std::to_string(count) + ".");
+    }
+}
+
+} // namespace
+
+void SampleAccumulator::add(const double* samples, std::size_t n) noexcept
+{
+    if (n == 0) {
+        return;
+    }
+    // Two passes over the batch, then one pairwise merge
+    SampleAccumulator batch;
+    batch.count_ = n;
+    batch.mean_ = blocked_sum(samples, n, [](double x) { return x; }) / static_cast<double>(n);
+    const double mean = batch.mean_;
+    batch.m2_ = blocked_sum(samples, n, [mean](double x) { return (x - mean) * (x - mean); });
+    merge(batch);
+}
+
+void SampleAccumulator::merge(const SampleAccumulator& other) noexcept
+{
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    const double na = static_cast<double>(count_);
+    const double nb = static_cast<double>(other.count_);
+    const double n = na + nb;
+    const double delta = other.mean_ - mean_;
+    mean_ += delta * nb / n;
+    m2_ += other.m2_ + delta * delta * na * nb / n;
+    count_ += other.count_;
+}
+
+double SampleAccumulator::variance() const
+{
+    require_samples(count_);
+    return m2_ / static_cast<double>(count_ - 1);
+}
+
+double SampleAccumulator::standard_error() const
+{
+    return std::sqrt(variance() / static_cast<double>(count_));
+}
+
+udouble SampleAccumulator::result() const
+{
+    return udouble(mean_, standard_error());
+}
+
+SampleAccumulator accumulate(const std::vector<double>& samples, const StatisticsOptions& options)
+{
+    const std::size_t threads = detail::resolve_thread_count(options.threads, samples.size(),
+                                                             MIN_SAMPLES_PER_THREAD);
+    std::vector<SampleAccumulator> parts(threads);
+    detail::parallel_for(samples.size(), threads, [&](std::size_t begin, std::size_t end, std::size_t t) {
+        parts[t].add(samples.data() + begin, end - begin);
+    });
+    SampleAccumulator total;
+    for (const SampleAccumulator& part : parts) {
+        total.merge(part);
+    }
+    return total;
+}
+
+JointSampleAccumulator::JointSampleAccumulator(std::size_t dimension)
+    : mean_(dimension, 0.0), comoment_(dimension * dimension, 0.0) {}
+
+void JointSampleAccumulator::add(const double* row)
+{
+    const std::size_t d = dimension();
+    ++count_;
+    const double n = static_cast<double>(count_);
+    // Deviations from the old mean times deviations from the new one
+    std::vector<double> delta(d);
+    for (std::size_t i = 0; i < d; ++i) {
+        delta[i] = row[i] - mean_[i];
+        mean_[i] += delta[i] / n;
+    }
+    for (std::size_t i = 0; i < d; ++i) {
+        for (std::size_t j = 0; j < d; ++j) {
+            comoment_[i * d + j] += delta[i] * (row[j] - mean_[j]);
+        }
+    }
+}
+
+void JointSampleAccumulator::add(std::initializer_list<double> row)
+{
+    if (row.size() != dimension()) {
+        throw std::invalid_argument("JointSampleAccumulator::add: expected " + std::to_string(dimension()) +
+                                    " samples per row, got " + std::to_string(row.size()) + ".");
+    }
+    add(row.begin());
+}
+
+void JointSampleAccumulator::add(const double* rows, std::size_t n)
+{
+    if (n == 0) {
+        return;
+    }
+    const std::size_t d = dimension();
+    JointSampleAccumulator batch(d);
+    batch.count_ = n;
+    for (std::size_t r = 0; r < n; ++r) {
+        for (std::size_t i = 0; i < d; ++i) {
+            batch.mean_[i] += rows[r * d + i];
+        }
+    }
+    for (double& m : batch.mean_) {
+        m /= static_cast<double>(n);
+    }
+    std::vector<double> dev(d);
+    for (std::size_t r = 0; r < n; ++r) {
+        for (std::size_t i = 0; i < d; ++i) {
+            dev[i] = rows[r * d + i] - batch.mean_[i];
+        }
+        for (std::size_t i = 0; i < d; ++i) {
+            for (std::size_t j = i; j < d; ++j) {
+                batch.comoment_[i * d + j] += dev[i] * dev[j];
+            }
+        }
+    }
+    for (std::size_t i = 0; i < d; ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            batch.comoment_[i * d + j] = batch.comoment_[j * d + i];
+        }
+    }
+    merge(batch);
+}
+
+void JointSampleAccumulator::merge(const JointSampleAccumulator& other)
+{
+    if (other.dimension() != dimension()) {
+        throw std::invalid_argument("JointSampleAccumulator::merge: dimensions differ.");
+    }
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    const std::size_t d = dimension();
+    const double na = static_cast<double>(count_);
+    const double nb = static_cast<double>(other.count_);
+    const double n = na + nb;
+    std::vector<double> delta(d);
+    for (std::size_t i = 0; i < d; ++i) {
+        delta[i] = other.mean_[i] - mean_[i];
+        mean_[i] += delta[i] * nb / n;
+    }
+    const double weight = na * nb / n;
+    for (std::size_t i = 0; i < d; ++i) {
+        for (std::size_t j = 0; j < d; ++j) {
+            comoment_[i * d + j] += other.comoment_[i * d + j] + delta[i] * delta[j] * weight;
+        }
+    }
+    count_ += other.count_;
+}
+
+std::vector<double> JointSampleAccumulator::covariance() const
+{
+    require_samples(count_);
+    std::vector<double> cov(comoment_);
+    for (double& c : cov) {
+        c /= static_cast<double>(count_ - 1);
+    }
+    return cov;
+}
+
+std::vector<udouble> JointSampleAccumulator::means() const
+{
+    std::vector<double> cov = covariance();
+    for (double& c : cov) {
+        c /= static_cast<double>(count_);
+    }
+    return correlated_values(mean_, cov);
+}
+
+std::vector<udouble> correlated_values(const std::vector<double>& nominal,
+                                       const std::vector<double>& covariance)
+{
+    const std::size_t n = nominal.size();
+    if (covariance.size() != n * n) {
+        throw std::invalid_argument("correlated_values: covariance must be " + std::to_string(n) + " x " +
+                                    std::to_string(n) + ".");
+    }
+    double scale = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        scale = std::max(scale, std::abs(covariance[i * n + i]));
+    }
+    const double tolerance = 1e-12 * scale;
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            if (std::abs(covariance[i * n + j] - covariance[j * n + i]) > tolerance) {
+                throw std::invalid_argument("correlated_values: covariance is not symmetric.");
+            }
+        }
+    }
+
+    // Cholesky factor L (lower, row-major); columns of zero pivots stay zero,
+    // so semidefinite matrices of perfectly correlated values are accepted
+    std::vector<double> L(n * n, 0.0);
+    for (std::size_t j = 0; j < n; ++j) {
+        double pivot = covariance[j * n + j];
+        for (std::size_t k = 0; k < j; ++k) {
+            pivot -= L[j * n + k] * L[j * n + k];
+        }
+        if (pivot < -tolerance) {
+            throw std::invalid_argument("correlated_values: covariance is not positive semidefinite.");
+        }
+        if (pivot <= tolerance) {
+            // A zero pivot needs a zero column below it, or the matrix is indefinite
+            for (std::size_t i = j + 1; i < n; ++i) {
+                double s = covariance[i * n + j];
+                for (std::size_t k = 0; k < j; ++k) {
+                    s -= L[i * n + k] * L[j * n + k];
+                }
+                if (std::abs(s) > tolerance) {
+                    throw std::invalid_argument("correlated_values: covariance is not positive semidefinite.");
+                }
+            }
+            continue;
+        }
+        const double diagonal = std::sqrt(pivot);
+        L[j * n + j] = diagonal;
+        for (std::size_t i = j + 1; i < n; ++i) {
+            double s = covariance[i * n + j];
+            for (std::size_t k = 0; k < j; ++k) {
+                s -= L[i * n + k] * L[j * n + k];
+            }
+            L[i * n + j] = s / diagonal;
+        }
+    }
+
+    // One unit atomic per column of L
+    auto& registry = detail::VariableRegistry::instance();
+    const uint64_t first = registry.reserve_ids(n);
+    const std::vector<double> unit(n, 1.0);
+    registry.register_ids(first, unit.data(), n);
+
+    std::vector<udouble> values;
+    values.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        udouble::DerivativeMap derivatives;
+        for (std::size_t k = 0; k <= i; ++k) {
+            if (L[i * n + k] != 0.0) {
+                derivatives[first + k] = L[i * n + k];
+            }
+        }
+        values.push_back(udouble::from_derivatives(nominal[i], std::move(derivatives)));
+    }
+    return values;
+}
+
+} // namespace uncertainties
@@ -1,4 +1,5 @@
 #include "uncertainties/udouble.hpp"
+#include "uncertainties/derivative_budget.hpp"
 #include <cmath>
 #include <stdexcept>
 
@@ -8,8 +9,8 @@ namespace {
     // Threshold for pruning near-zero derivatives
     constexpr double PRUNE_THRESHOLD = 1e-300;
 
-    // Helper to prune near-zero derivatives from a map
-    void prune_derivatives(udouble::DerivativeMap& derivs) {
+    // Drop near-zero derivatives from a map
+    void drop_near_zero(udouble::DerivativeMap& derivs) {
         for (auto it = derivs.begin(); it != derivs.end(); ) {
             if (std::abs(it->second) < PRUNE_THRESHOLD) {
                 it = derivs.erase(it);
@@ -18,71 +19,176 @@ namespace {
             }
         }
     }
+
+    // Helper to prune near-zero derivatives from a map and apply the
+    // thread's derivative budget to the result
+    void prune_derivatives(udouble::DerivativeMap& derivs) {
+        drop_near_zero(derivs);
+        detail::enforce_derivative_budget(derivs);
+    }
+
+    // Grow the bucket array once up front if `extra` more entries could
+    // exceed the load factor, so a merge never rehashes midway
+    void reserve_for_merge(udouble::DerivativeMap& derivs, std::size_t extra) {
+        std::size_t needed = derivs.size() + extra;
+        if (static_cast<double>(needed) >
+            static_cast<double>(derivs.bucket_count()) * derivs.max_load_factor()) {
+            derivs.reserve(needed);
+        }
+    }
+
+    // Scale every derivative in place
+    void scale_in_place(udouble::DerivativeMap& derivs, double coef) {
+        if (coef != 1.0) {
+            for (auto& [id, deriv] : derivs) {
+                deriv *= coef;
+            }
+        }
+    }
+
+    // Build c_lhs * lhs + c_rhs * rhs. The wider map is copied and scaled in
+    // place, which allocates its nodes without any lookups, and only the
+    // narrower map is folded in entry by entry.
+    udouble::DerivativeMap linear_merge(const udouble::DerivativeMap& lhs, double c_lhs,
+                                        const udouble::DerivativeMap& rhs, double c_rhs) {
+        const bool lhs_wider = lhs.size() >= rhs.size();
+        const auto& wide = lhs_wider ? lhs : rhs;
+        const auto& narrow = lhs_wider ? rhs : lhs;
+        const double c_narrow = lhs_wider ? c_rhs : c_lhs;
+
+        udouble::DerivativeMap new_derivs(wide);
+        scale_in_place(new_derivs, lhs_wider ? c_lhs : c_rhs);
+        reserve_for_merge(new_derivs, narrow.size());
+        for (const auto& [id, deriv] : narrow) {
+            new_derivs[id] += c_narrow * deriv;
+        }
+
+        prune_derivatives(new_derivs);
+        return new_derivs;
+    }
+
+    // Copy of a map with every derivative scaled by coef
+    udouble::DerivativeMap scaled_copy(const udouble::DerivativeMap& derivs, double coef) {
+        udouble::DerivativeMap new_derivs(derivs);
+        scale_in_place(new_derivs, coef);
+        prune_derivatives(new_derivs);
+        return new_derivs;
+    }
+
+    // derivs += coef * src in place; only entries touched by src can cancel,
+    // so only those are checked for pruning
+    void accumulate_in_place(udouble::DerivativeMap& derivs,
+                             const udouble::DerivativeMap& src, double coef) {
+        reserve_for_merge(derivs, src.size());
+        for (const auto& [id, deriv] : src) {
+            derivs[id] += coef * deriv;
+        }
+        for (const auto& entry : src) {
+            auto it = derivs.find(entry.first);
+            if (std::abs(it->second) < PRUNE_THRESHOLD) {
+                derivs.erase(it);
+            }
+        }
+        detail::enforce_derivative_budget(derivs);
+    }
+
+    // Whether applying the thread's budget can throw (the Throw action, or a
+    // callback that may throw)
+    bool budget_may_throw() {
+        const DerivativeBudget& budget = derivative_budget();
+        return (budget.max_entries != 0 || budget.max_bytes != 0) && budget.action != BudgetAction::Prune;
+    }
+
+    // Apply `update` to derivs with the strong exception guarantee: when the
+    // budget can throw, the update runs on a copy that is swapped in only
+    // once it has passed the budget check
+    template <typename Update>
+    void update_derivatives(udouble::DerivativeMap& derivs, Update&& update) {
+        if (!budget_may_throw()) {
+            update(derivs);
+            return;
+        }
+        udouble::DerivativeMap result(derivs);
+        update(result);
+        derivs.swap(result);
+    }
 }
 
-// Addition: d(a+b)/dx = da/dx + db/dx
-udouble operator+(const udouble& lhs, const udouble& rhs)
+udouble udouble::from_derivatives(double nominal, DerivativeMap derivatives)
 {
-    double new_nominal = lhs.nominal_ + rhs.nominal_;
+    prune_derivatives(derivatives);
+    return udouble(nominal, std::move(derivatives));
+}
+
+// Slow path of stddev(): compute σ = sqrt(Σ (∂f/∂xi)² σi²) and publish it
+// seqlock-style. The writer claims the cache by setting STATE_BUSY; readers
+// that observe a different state before and after loading sigma_ recompute.
+// If another thread is already writing, the result is returned uncached.
+double udouble::refresh_stddev(uint64_t state, uint64_t generation) const
+{
+    const auto& registry = detail::VariableRegistry::instance();
+    double sigma = 0.0;
+    if (state & STATE_UNREGISTERED) {
+        // A copy of this atomic may have registered it and the registered
+        // stddev may have been changed since
+        if (!registry.try_get_stddev(derivatives_.begin()->first, sigma)) {
+            sigma = sigma_.load(std::memory_order_relaxed);
+        }
+    } else {
+        double variance = 0.0;
+        for (const auto& [id, deriv] : derivatives_) {
+            double original_stddev = registry.get_stddev(id);
+            variance += deriv * deriv * original_stddev * original_stddev;
+        }
+        sigma = std::sqrt(variance);
+    }
 
-    // Merge derivative maps
-    udouble::DerivativeMap new_derivs = lhs.derivatives_;
-    for (const auto& [id, deriv] : rhs.derivatives_) {
-        new_derivs[id] += deriv;
+    uint64_t expected = state & ~STATE_BUSY;
+    if (state_.compare_exchange_strong(expected, expected | STATE_BUSY,
+                                       std::memory_order_relaxed)) {
+        std::atomic_thread_fence(std::memory_order_release);
+        sigma_.store(sigma, std::memory_order_relaxed);
+        uint64_t busy = expected | STATE_BUSY;
+        uint64_t published = (expected & STATE_UNREGISTERED) | ((generation + 1) << CACHE_SHIFT);
+        if (!state_.compare_exchange_strong(busy, published, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+            // ensure_registered() cleared STATE_UNREGISTERED meanwhile
+            state_.store(published & ~STATE_UNREGISTERED, std::memory_order_release);
+        }
     }
+    return sigma;
+}
 
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+// Addition: d(a+b)/dx = da/dx + db/dx
+udouble operator+(const udouble& lhs, const udouble& rhs)
+{
+    double new_nominal = lhs.nominal_ + rhs.nominal_;
+    return udouble(new_nominal,
+                   linear_merge(lhs.linked_derivatives(), 1.0, rhs.linked_derivatives(), 1.0));
 }
 
 // Subtraction: d(a-b)/dx = da/dx - db/dx
 udouble operator-(const udouble& lhs, const udouble& rhs)
 {
     double new_nominal = lhs.nominal_ - rhs.nominal_;
-
-    // Merge derivative maps with subtraction
-    udouble::DerivativeMap new_derivs = lhs.derivatives_;
-    for (const auto& [id, deriv] : rhs.derivatives_) {
-        new_derivs[id] -= deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal,
+                   linear_merge(lhs.linked_derivatives(), 1.0, rhs.linked_derivatives(), -1.0));
 }
 
 // Multiplication: d(a*b)/dx = b*(da/dx) + a*(db/dx)
 udouble operator*(const udouble& lhs, const udouble& rhs)
 {
     double new_nominal = lhs.nominal_ * rhs.nominal_;
-
-    udouble::DerivativeMap new_derivs;
-
-    // b * (da/dx)
-    for (const auto& [id, deriv] : lhs.derivatives_) {
-        new_derivs[id] += rhs.nominal_ * deriv;
-    }
-
-    // a * (db/dx)
-    for (const auto& [id, deriv] : rhs.derivatives_) {
-        new_derivs[id] += lhs.nominal_ * deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal,
+                   linear_merge(lhs.linked_derivatives(), rhs.nominal_,
+                                rhs.linked_derivatives(), lhs.nominal_));
 }
 
 // Scalar multiplication: d(c*a)/dx = c * (da/dx)
 udouble operator*(const udouble& lhs, const double& rhs)
 {
     double new_nominal = lhs.nominal_ * rhs;
-
-    udouble::DerivativeMap new_derivs;
-    for (const auto& [id, deriv] : lhs.derivatives_) {
-        new_derivs[id] = rhs * deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal, scaled_copy(lhs.linked_derivatives(), rhs));
 }
 
 udouble operator*(const double& lhs, const udouble& rhs)
@@ -101,20 +207,8 @@ udouble operator/(const udouble& lhs, const udouble& rhs)
     double inv_b = 1.0 / rhs.nominal_;
     double a_over_b_sq = lhs.nominal_ / (rhs.nominal_ * rhs.nominal_);
 
-    udouble::DerivativeMap new_derivs;
-
-    // (1/b) * (da/dx)
-    for (const auto& [id, deriv] : lhs.derivatives_) {
-        new_derivs[id] += inv_b * deriv;
-    }
-
-    // -(a/b²) * (db/dx)
-    for (const auto& [id, deriv] : rhs.derivatives_) {
-        new_derivs[id] -= a_over_b_sq * deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal,
+                   linear_merge(lhs.linked_derivatives(), inv_b, rhs.linked_derivatives(), -a_over_b_sq));
 }
 
 // Scalar division: d(a/c)/dx = (1/c) * (da/dx)
@@ -126,14 +220,7 @@ udouble operator/(const udouble& lhs, const double& rhs)
 
     double new_nominal = lhs.nominal_ / rhs;
     double inv_rhs = 1.0 / rhs;
-
-    udouble::DerivativeMap new_derivs;
-    for (const auto& [id, deriv] : lhs.derivatives_) {
-        new_derivs[id] = inv_rhs * deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal, scaled_copy(lhs.linked_derivatives(), inv_rhs));
 }
 
 // Constant divided by udouble: d(c/b)/dx = -c/b² * (db/dx)
@@ -145,14 +232,7 @@ udouble operator/(const double& lhs, const udouble& rhs)
 
     double new_nominal = lhs / rhs.nominal_;
     double coef = -lhs / (rhs.nominal_ * rhs.nominal_);
-
-    udouble::DerivativeMap new_derivs;
-    for (const auto& [id, deriv] : rhs.derivatives_) {
-        new_derivs[id] = coef * deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal, scaled_copy(rhs.linked_derivatives(), coef));
 }
 
 // Power: d(a^b)/dx = a^b * (b/a * da/dx + ln(a) * db/dx)
@@ -166,56 +246,105 @@ udouble pow(const udouble& base, const udouble& exp)
     double coef_base = new_nominal * exp.nominal_ / base.nominal_;
     double coef_exp = new_nominal * std::log(base.nominal_);
 
-    udouble::DerivativeMap new_derivs;
-
-    // a^b * (b/a) * (da/dx)
-    for (const auto& [id, deriv] : base.derivatives_) {
-        new_derivs[id] += coef_base * deriv;
-    }
-
-    // a^b * ln(a) * (db/dx)
-    for (const auto& [id, deriv] : exp.derivatives_) {
-        new_derivs[id] += coef_exp * deriv;
-    }
-
-    prune_derivatives(new_derivs);
-    return udouble(new_nominal, std::move(new_derivs));
+    return udouble(new_nominal,
+                   linear_merge(base.linked_derivatives(), coef_base,
+                                exp.linked_derivatives(), coef_exp));
 }
 
-// Compound assignment operators
+// Compound assignment operators update the derivative map in place, so a
+// running sum costs O(size of rhs) per step instead of copying the whole
+// accumulated map. Self-assignment falls back to the binary operators. If
+// the derivative budget throws, the value is left unchanged (only a budget
+// that can throw costs a copy of the map).
 udouble& udouble::operator+=(const udouble& rhs)
 {
-    *this = *this + rhs;
+    if (&rhs == this) {
+        *this = *this + rhs;
+        return *this;
+    }
+    make_derived();
+    update_derivatives(derivatives_, [&](DerivativeMap& derivs) {
+        accumulate_in_place(derivs, rhs.linked_derivatives(), 1.0);
+    });
+    nominal_ += rhs.nominal_;
     return *this;
 }
 
 udouble& udouble::operator-=(const udouble& rhs)
 {
-    *this = *this - rhs;
+    if (&rhs == this) {
+        *this = *this - rhs;
+        return *this;
+    }
+    make_derived();
+    update_derivatives(derivatives_, [&](DerivativeMap& derivs) {
+        accumulate_in_place(derivs, rhs.linked_derivatives(), -1.0);
+    });
+    nominal_ -= rhs.nominal_;
     return *this;
 }
 
 udouble& udouble::operator*=(const udouble& rhs)
 {
-    *this = *this * rhs;
+    if (&rhs == this) {
+        *this = *this * rhs;
+        return *this;
+    }
+    make_derived();
+    // d(a*b) = b*da + a*db, using the nominal of a before the update
+    update_derivatives(derivatives_, [&](DerivativeMap& derivs) {
+        // The budget applies to the result only, not to the scaled lhs
+        scale_in_place(derivs, rhs.nominal_);
+        drop_near_zero(derivs);
+        accumulate_in_place(derivs, rhs.linked_derivatives(), nominal_);
+    });
+    nominal_ *= rhs.nominal_;
     return *this;
 }
 
 udouble& udouble::operator/=(const udouble& rhs)
 {
-    *this = *this / rhs;
+    if (&rhs == this) {
+        *this = *this / rhs;
+        return *this;
+    }
+    if (rhs.nominal_ == 0.0) {
+        throw std::runtime_error("Division by zero in udouble.");
+    }
+    make_derived();
+    double inv_b = 1.0 / rhs.nominal_;
+    double a_over_b_sq = nominal_ / (rhs.nominal_ * rhs.nominal_);
+    update_derivatives(derivatives_, [&](DerivativeMap& derivs) {
+        scale_in_place(derivs, inv_b);
+        drop_near_zero(derivs);
+        accumulate_in_place(derivs, rhs.linked_derivatives(), -a_over_b_sq);
+    });
+    nominal_ /= rhs.nominal_;
     return *this;
 }
 
 udouble& udouble::operator*=(double rhs)
 {
-    *this = *this * rhs;
+    make_derived();
+    update_derivatives(derivatives_, [&](DerivativeMap& derivs) {
+        scale_in_place(derivs, rhs);
+        prune_derivatives(derivs);
+    });
+    nominal_ *= rhs;
     return *this;
 }
 
 udouble& udouble::operator/=(double rhs)
 {
-    *this = *this / rhs;
+    if (rhs == 0.0) {
+        throw std::runtime_error("Division by zero in udouble.");
+    }
+    make_derived();
+    update_derivatives(derivatives_, [&](DerivativeMap& derivs) {
+        scale_in_place(derivs, 1.0 / rhs);
+        prune_derivatives(derivs);
+    });
+    nominal_ /= rhs;
     return *this;
 }
 
@@ -1,6 +1,7 @@
 #include <cmath>
 #include <stdexcept>
 #include "uncertainties/umath.hpp"
+#include "uncertainties/derivative_budget.hpp"
 
 namespace uncertainties {
 
@@ -9,17 +10,22 @@ namespace {
     constexpr double PRUNE_THRESHOLD = 1e-300;
 
     // Helper to apply chain rule: d(f(g))/dx = f'(g) * (dg/dx)
+    // The input map is copied and scaled in place, which avoids a hash
+    // lookup per entry for wide inputs.
     udouble::DerivativeMap apply_chain_rule(
         const udouble::DerivativeMap& input_derivs,
         double derivative)
     {
-        udouble::DerivativeMap new_derivs;
-        for (const auto& [id, deriv] : input_derivs) {
-            double new_deriv = derivative * deriv;
-            if (std::abs(new_deriv) >= PRUNE_THRESHOLD) {
-                new_derivs[id] = new_deriv;
+        udouble::DerivativeMap new_derivs(input_derivs);
+        for (auto it = new_derivs.begin(); it != new_derivs.end(); ) {
+            it->second = derivative * it->second;
+            if (std::abs(it->second) < PRUNE_THRESHOLD) {
+                it = new_derivs.erase(it);
+            } else {
+                ++it;
             }
         }
+        detail::enforce_derivative_budget(new_derivs);
         return new_derivs;
     }
 }
@@ -31,7 +37,7 @@ udouble sin(const udouble& x)
     double new_nominal = std::sin(x.nominal_value());
     // sin'(x) = cos(x)
     double derivative = std::cos(x.nominal_value());
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble cos(const udouble& x)
@@ -39,7 +45,7 @@ udouble cos(const udouble& x)
     double new_nominal = std::cos(x.nominal_value());
     // cos'(x) = -sin(x)
     double derivative = -std::sin(x.nominal_value());
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble tan(const udouble& x)
@@ -51,7 +57,7 @@ udouble tan(const udouble& x)
     double new_nominal = std::tan(x.nominal_value());
     // tan'(x) = sec²(x) = 1/cos²(x)
     double derivative = 1.0 / (cos_x * cos_x);
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 // Inverse trigonometric functions
@@ -69,7 +75,7 @@ udouble asin(const udouble& x)
         throw std::invalid_argument("asin derivative undefined at x = ±1.");
     }
     double derivative = 1.0 / denom;
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble acos(const udouble& x)
@@ -85,7 +91,7 @@ udouble acos(const udouble& x)
         throw std::invalid_argument("acos derivative undefined at x = ±1.");
     }
     double derivative = -1.0 / denom;
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble atan(const udouble& x)
@@ -94,7 +100,7 @@ udouble atan(const udouble& x)
     double new_nominal = std::atan(val);
     // atan'(x) = 1/(1+x²)
     double derivative = 1.0 / (1.0 + val * val);
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble atan2(const udouble& y, const udouble& x)
@@ -113,14 +119,15 @@ udouble atan2(const udouble& y, const udouble& x)
     double df_dx = -yv / denom;
 
     udouble::DerivativeMap new_derivs;
+    new_derivs.reserve(x.linked_derivatives().size() + y.linked_derivatives().size());
 
     // Apply partial derivatives for y
-    for (const auto& [id, deriv] : y.derivatives_) {
+    for (const auto& [id, deriv] : y.linked_derivatives()) {
         new_derivs[id] += df_dy * deriv;
     }
 
     // Apply partial derivatives for x
-    for (const auto& [id, deriv] : x.derivatives_) {
+    for (const auto& [id, deriv] : x.linked_derivatives()) {
         new_derivs[id] += df_dx * deriv;
     }
 
@@ -132,6 +139,7 @@ udouble atan2(const udouble& y, const udouble& x)
             ++it;
         }
     }
+    detail::enforce_derivative_budget(new_derivs);
 
     return udouble(new_nominal, std::move(new_derivs));
 }
@@ -143,7 +151,7 @@ udouble sinh(const udouble& x)
     double new_nominal = std::sinh(x.nominal_value());
     // sinh'(x) = cosh(x)
     double derivative = std::cosh(x.nominal_value());
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble cosh(const udouble& x)
@@ -151,7 +159,7 @@ udouble cosh(const udouble& x)
     double new_nominal = std::cosh(x.nominal_value());
     // cosh'(x) = sinh(x)
     double derivative = std::sinh(x.nominal_value());
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble tanh(const udouble& x)
@@ -160,7 +168,7 @@ udouble tanh(const udouble& x)
     double new_nominal = std::tanh(x.nominal_value());
     // tanh'(x) = sech²(x) = 1/cosh²(x)
     double derivative = 1.0 / (cosh_x * cosh_x);
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 // Inverse hyperbolic functions
@@ -171,7 +179,7 @@ udouble asinh(const udouble& x)
     double new_nominal = std::asinh(val);
     // asinh'(x) = 1/sqrt(1 + x²)
     double derivative = 1.0 / std::sqrt(1.0 + val * val);
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble acosh(const udouble& x)
@@ -187,7 +195,7 @@ udouble acosh(const udouble& x)
         throw std::invalid_argument("acosh derivative undefined at x = 1.");
     }
     double derivative = 1.0 / denom;
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble atanh(const udouble& x)
@@ -199,7 +207,7 @@ udouble atanh(const udouble& x)
     double new_nominal = std::atanh(val);
     // atanh'(x) = 1/(1 - x²)
     double derivative = 1.0 / (1.0 - val * val);
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 // Exponential and logarithmic functions
@@ -209,7 +217,7 @@ udouble exp(const udouble& x)
     double new_nominal = std::exp(x.nominal_value());
     // exp'(x) = exp(x)
     double derivative = new_nominal;
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble log(const udouble& x)
@@ -220,7 +228,7 @@ udouble log(const udouble& x)
     double new_nominal = std::log(x.nominal_value());
     // log'(x) = 1/x
     double derivative = 1.0 / x.nominal_value();
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble log10(const udouble& x)
@@ -231,7 +239,7 @@ udouble log10(const udouble& x)
     double new_nominal = std::log10(x.nominal_value());
     // log10'(x) = 1/(x * ln(10))
     double derivative = 1.0 / (x.nominal_value() * std::log(10.0));
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble sqrt(const udouble& x)
@@ -242,7 +250,7 @@ udouble sqrt(const udouble& x)
     double new_nominal = std::sqrt(x.nominal_value());
     // sqrt'(x) = 1/(2*sqrt(x))
     double derivative = 1.0 / (2.0 * new_nominal);
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 // Other mathematical functions
@@ -256,7 +264,7 @@ udouble abs(const udouble& x)
     // For x = 0, derivative is undefined but we use 0
     double derivative = (val > 0.0) ? 1.0 : ((val < 0.0) ? -1.0 : 0.0);
 
-    return udouble(new_nominal, apply_chain_rule(x.derivatives_, derivative));
+    return udouble(new_nominal, apply_chain_rule(x.linked_derivatives(), derivative));
 }
 
 udouble hypot(const udouble& x, const udouble& y)
@@ -266,6 +274,7 @@ udouble hypot(const udouble& x, const udouble& y)
     double new_nominal = std::hypot(xv, yv);
 
     udouble::DerivativeMap new_derivs;
+    new_derivs.reserve(x.linked_derivatives().size() + y.linked_derivatives().size());
 
     if (new_nominal == 0.0) {
         // At origin, derivatives are undefined (0/0)
@@ -275,12 +284,13 @@ udouble hypot(const udouble& x, const udouble& y)
         //
         // We create a new result whose stddev() equals sqrt(σ_x² + σ_y²)
         // by combining the derivative maps (as if adding them in quadrature)
-        for (const auto& [id, deriv] : x.derivatives_) {
+        for (const auto& [id, deriv] : x.linked_derivatives()) {
             new_derivs[id] += deriv;
         }
-        for (const auto& [id, deriv] : y.derivatives_) {
+        for (const auto& [id, deriv] : y.linked_derivatives()) {
             new_derivs[id] += deriv;
         }
+        detail::enforce_derivative_budget(new_derivs);
         return udouble(0.0, std::move(new_derivs));
     }
 
@@ -289,12 +299,12 @@ udouble hypot(const udouble& x, const udouble& y)
     double df_dy = yv / new_nominal;
 
     // Apply partial derivatives for x
-    for (const auto& [id, deriv] : x.derivatives_) {
+    for (const auto& [id, deriv] : x.linked_derivatives()) {
         new_derivs[id] += df_dx * deriv;
     }
 
     // Apply partial derivatives for y
-    for (const auto& [id, deriv] : y.derivatives_) {
+    for (const auto& [id, deriv] : y.linked_derivatives()) {
         new_derivs[id] += df_dy * deriv;
     }
 
@@ -306,6 +316,7 @@ udouble hypot(const udouble& x, const udouble& y)
             ++it;
         }
     }
+    detail::enforce_derivative_budget(new_derivs);
 
     return udouble(new_nominal, std::move(new_derivs));
 }
@@ -0,0 +1,479 @@
+#pragma once
+
+/**
+ * @file differential_harness.hpp
+ * @brief Random expression programs and a reference propagator for
+ *        differential testing of udouble.
+ *
+ * An ExpressionProgram is a straight-line list of operations over a fixed set
+ * of atomic leaves. The same program can be evaluated with udouble and with
+ * ReferenceValue, a dense forward-mode propagator that keeps one gradient
+ * slot per leaf and shares no code with the library. Agreement of nominals,
+ * derivatives and stddevs is checked by compare_with_reference().
+ *
+ * Programs are generated from a ChoiceSource, so the same generator drives
+ * both the seeded property tests and the libFuzzer entry point.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "uncertainties/formula.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+namespace differential {
+
+/// Operations covered by the generator
+enum class Op {
+    Add, Sub, Mul, Div, Pow, Atan2, Hypot,
+    AddAssign, SubAssign, MulAssign, DivAssign,
+    Neg, ScaleConst, AddConst, DivConst, ConstDiv,
+    Sin, Cos, Tan, Asin, Acos, Atan,
+    Sinh, Cosh, Tanh, Asinh, Acosh, Atanh,
+    Exp, Log, Log10, Sqrt, Abs,
+    Count
+};
+
+/// One operation; `a` and `b` index earlier slots (leaves come first)
+struct Node {
+    Op op;
+    std::size_t a;
+    std::size_t b;
+    double constant;
+};
+
+/// Leaves plus a straight-line list of operations
+struct ExpressionProgram {
+    std::vector<double> leaf_nominals;
+    std::vector<double> leaf_stddevs;
+    std::vector<Node> nodes;
+
+    std::size_t num_leaves() const { return leaf_nominals.size(); }
+    std::size_t num_slots() const { return leaf_nominals.size() + nodes.size(); }
+};
+
+/**
+ * @brief Dense forward-mode value with one gradient slot per leaf.
+ */
+struct ReferenceValue {
+    double value = 0.0;
+    std::vector<double> grad;
+
+    static ReferenceValue leaf(double value, std::size_t index, std::size_t n) {
+        ReferenceValue r{value, std::vector<double>(n, 0.0)};
+        r.grad[index] = 1.0;
+        return r;
+    }
+
+    // f(a, b) with partials da, db
+    static ReferenceValue combine(double value, double da, const ReferenceValue& a,
+                                  double db, const ReferenceValue& b) {
+        ReferenceValue r{value, std::vector<double>(a.grad.size(), 0.0)};
+        for (std::size_t i = 0; i < r.grad.size(); ++i) {
+            r.grad[i] = da * a.grad[i] + db * b.grad[i];
+        }
+        return r;
+    }
+
+    static ReferenceValue chain(double value, double da, const ReferenceValue& a) {
+        ReferenceValue r{value, a.grad};
+        for (double& g : r.grad) {
+            g *= da;
+        }
+        return r;
+    }
+
+    double stddev(const std::vector<double>& sigmas) const {
+        double variance = 0.0;
+        for (std::size_t i = 0; i < grad.size(); ++i) {
+            variance += grad[i] * grad[i] * sigmas[i] * sigmas[i];
+        }
+        return std::sqrt(variance);
+    }
+};
+
+/**
+ * @brief Source of bounded random choices.
+ */
+class ChoiceSource {
+public:
+    virtual ~ChoiceSource() = default;
+
+    /// Uniform integer in [0, n)
+    virtual std::size_t next(std::size_t n) = 0;
+
+    /// Uniform double in [lo, hi)
+    virtual double next_double(double lo, double hi) = 0;
+};
+
+/// Choices from a seeded Mersenne Twister (deterministic, for CI)
+class SeededChoices : public ChoiceSource {
+public:
+    explicit SeededChoices(uint64_t seed) : rng_(seed) {}
+
+    std::size_t next(std::size_t n) override {
+        return std::uniform_int_distribution<std::size_t>(0, n - 1)(rng_);
+    }
+
+    double next_double(double lo, double hi) override {
+        return std::uniform_real_distribution<double>(lo, hi)(rng_);
+    }
+
+private:
+    std::mt19937_64 rng_;
+};
+
+/// Choices decoded from a fuzzer input; exhausted input yields zeros
+class ByteChoices : public ChoiceSource {
+public:
+    ByteChoices(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+    std::size_t next(std::size_t n) override {
+        return n == 0 ? 0 : static_cast<std::size_t>(next_u16()) % n;
+    }
+
+    double next_double(double lo, double hi) override {
+        return lo + (hi - lo) * (next_u16() / 65536.0);
+    }
+
+private:
+    uint16_t next_u16() {
+        uint16_t v = 0;
+        for (int i = 0; i < 2 && pos_ < size_; ++i) {
+            v = static_cast<uint16_t>((v << 8) | data_[pos_++]);
+        }
+        return v;
+    }
+
+    const uint8_t* data_;
+    std::size_t size_;
+    std::size_t pos_ = 0;
+};
+
+/**
+ * @brief Check whether op is well-conditioned at the given operand values.
+ *
+ * Values near singularities or discontinuities of the derivative are
+ * rejected so that both propagators are compared where first-order
+ * propagation is well defined.
+ */
+inline bool op_is_safe(Op op, double a, double b, double c) {
+    auto bounded = [](double v) { return std::isfinite(v) && std::abs(v) < 1e6; };
+    if (!bounded(a) || !bounded(b)) {
+        return false;
+    }
+    switch (op) {
+        case Op::Div: case Op::DivAssign: return std::abs(b) > 1e-2;
+        case Op::ConstDiv: return std::abs(a) > 1e-2;
+        case Op::DivConst: return std::abs(c) > 1e-2;
+        case Op::Pow: return a > 1e-2 && a < 1e2 && std::abs(b) < 4.0;
+        case Op::Atan2: case Op::Hypot: return std::abs(a) + std::abs(b) > 1e-2;
+        case Op::Tan: return std::abs(std::cos(a)) > 1e-2;
+        case Op::Asin: case Op::Acos: case Op::Atanh: return std::abs(a) < 0.99;
+        case Op::Acosh: return a > 1.01;
+        case Op::Sinh: case Op::Cosh: case Op::Exp: return std::abs(a) < 20.0;
+        case Op::Log: case Op::Log10: case Op::Sqrt: return a > 1e-2;
+        case Op::Abs: return std::abs(a) > 1e-6;
+        default: return true;
+    }
+}
+
+/**
+ * @brief Generate a random program with the given number of leaves and nodes.
+ *
+ * Operations whose operands fall outside a safe domain are replaced by tanh,
+ * which is defined everywhere and keeps values bounded, so every generated
+ * program evaluates without exceptions.
+ */
+inline ExpressionProgram generate_program(ChoiceSource& choices,
+                                          std::size_t num_leaves,
+                                          std::size_t num_nodes) {
+    ExpressionProgram program;
+    std::vector<double> values;
+    for (std::size_t i = 0; i < num_leaves; ++i) {
+        double nominal = choices.next_double(-2.0, 2.0);
+        program.leaf_nominals.push_back(nominal);
+        program.leaf_stddevs.push_back(choices.next_double(0.01, 0.5));
+        values.push_back(nominal);
+    }
+
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        // Bias operand choice towards recent slots to build deep expressions
+        std::size_t n = values.size();
+        std::size_t a = (choices.next(2) == 0) ? n - 1 - choices.next(std::min<std::size_t>(n, 4))
+                                               : choices.next(n);
+        std::size_t b = choices.next(n);
+        double c = choices.next_double(-3.0, 3.0);
+        Op op = static_cast<Op>(choices.next(static_cast<std::size_t>(Op::Count)));
+
+        if (!op_is_safe(op, values[a], values[b], c)) {
+            op = Op::Tanh;
+        }
+
+        Node node{op, a, b, c};
+        program.nodes.push_back(node);
+
+        // Track nominals with plain doubles to drive the domain checks
+        values.push_back(0.0);
+        switch (op) {
+            case Op::Add: case Op::AddAssign: values.back() = values[a] + values[b]; break;
+            case Op::Sub: case Op::SubAssign: values.back() = values[a] - values[b]; break;
+            case Op::Mul: case Op::MulAssign: values.back() = values[a] * values[b]; break;
+            case Op::Div: case Op::DivAssign: values.back() = values[a] / values[b]; break;
+            case Op::Pow: values.back() = std::pow(values[a], values[b]); break;
+            case Op::Atan2: values.back() = std::atan2(values[a], values[b]); break;
+            case Op::Hypot: values.back() = std::hypot(values[a], values[b]); break;
+            case Op::Neg: values.back() = -values[a]; break;
+            case Op::ScaleConst: values.back() = values[a] * c; break;
+            case Op::AddConst: values.back() = values[a] + c; break;
+            case Op::DivConst: values.back() = values[a] / c; break;
+            case Op::ConstDiv: values.back() = c / values[a]; break;
+            case Op::Sin: values.back() = std::sin(values[a]); break;
+            case Op::Cos: values.back() = std::cos(values[a]); break;
+            case Op::Tan: values.back() = std::tan(values[a]); break;
+            case Op::Asin: values.back() = std::asin(values[a]); break;
+            case Op::Acos: values.back() = std::acos(values[a]); break;
+            case Op::Atan: values.back() = std::atan(values[a]); break;
+            case Op::Sinh: values.back() = std::sinh(values[a]); break;
+            case Op::Cosh: values.back() = std::cosh(values[a]); break;
+            case Op::Tanh: values.back() = std::tanh(values[a]); break;
+            case Op::Asinh: values.back() = std::asinh(values[a]); break;
+            case Op::Acosh: values.back() = std::acosh(values[a]); break;
+            case Op::Atanh: values.back() = std::atanh(values[a]); break;
+            case Op::Exp: values.back() = std::exp(values[a]); break;
+            case Op::Log: values.back() = std::log(values[a]); break;
+            case Op::Log10: values.back() = std::log10(values[a]); break;
+            case Op::Sqrt: values.back() = std::sqrt(values[a]); break;
+            case Op::Abs: values.back() = std::abs(values[a]); break;
+            case Op::Count: break;
+        }
+    }
+    return program;
+}
+
+/**
+ * @brief Apply one node to udouble or FormulaVar operands.
+ */
+template <typename Value>
+Value apply_node(const Node& node, const Value& a, const Value& b) {
+    namespace u = uncertainties;
+    const double c = node.constant;
+    Value r;
+    switch (node.op) {
+        case Op::Add: r = a + b; break;
+        case Op::Sub: r = a - b; break;
+        case Op::Mul: r = a * b; break;
+        case Op::Div: r = a / b; break;
+        case Op::Pow: r = pow(a, b); break;  // found by ADL
+        case Op::Atan2: r = u::atan2(a, b); break;
+        case Op::Hypot: r = u::hypot(a, b); break;
+        case Op::AddAssign: r = a; r += b; break;
+        case Op::SubAssign: r = a; r -= b; break;
+        case Op::MulAssign: r = a; r *= b; break;
+        case Op::DivAssign: r = a; r /= b; break;
+        case Op::Neg: r = -a; break;
+        case Op::ScaleConst: r = a * c; break;
+        case Op::AddConst: r = a + c; break;
+        case Op::DivConst: r = a / c; break;
+        case Op::ConstDiv: r = c / a; break;
+        case Op::Sin: r = u::sin(a); break;
+        case Op::Cos: r = u::cos(a); break;
+        case Op::Tan: r = u::tan(a); break;
+        case Op::Asin: r = u::asin(a); break;
+        case Op::Acos: r = u::acos(a); break;
+        case Op::Atan: r = u::atan(a); break;
+        case Op::Sinh: r = u::sinh(a); break;
+        case Op::Cosh: r = u::cosh(a); break;
+        case Op::Tanh: r = u::tanh(a); break;
+        case Op::Asinh: r = u::asinh(a); break;
+        case Op::Acosh: r = u::acosh(a); break;
+        case Op::Atanh: r = u::atanh(a); break;
+        case Op::Exp: r = u::exp(a); break;
+        case Op::Log: r = u::log(a); break;
+        case Op::Log10: r = u::log10(a); break;
+        case Op::Sqrt: r = u::sqrt(a); break;
+        case Op::Abs: r = u::abs(a); break;
+        case Op::Count: break;
+    }
+    return r;
+}
+
+/**
+ * @brief Evaluate a program with udouble arithmetic.
+ * @param program The program
+ * @param leaves Output: the atomic leaves (used to map registry IDs to leaves)
+ * @return Value of every slot, leaves first
+ */
+inline std::vector<uncertainties::udouble> evaluate_udouble(
+    const ExpressionProgram& program,
+    std::vector<uncertainties::udouble>& leaves)
+{
+    using uncertainties::udouble;
+
+    std::vector<udouble> slots;
+    slots.reserve(program.num_slots());
+    leaves.clear();
+    for (std::size_t i = 0; i < program.num_leaves(); ++i) {
+        leaves.emplace_back(program.leaf_nominals[i], program.leaf_stddevs[i]);
+        slots.push_back(leaves.back());
+    }
+
+    for (const Node& node : program.nodes) {
+        slots.push_back(apply_node(node, slots[node.a], slots[node.b]));
+    }
+    return slots;
+}
+
+/**
+ * @brief Record a program as a Formula whose outputs are all slots.
+ */
+inline uncertainties::Formula record_formula(const ExpressionProgram& program) {
+    using uncertainties::FormulaVar;
+    return uncertainties::Formula::record(program.num_leaves(),
+        [&program](const std::vector<FormulaVar>& inputs) {
+            std::vector<FormulaVar> slots(inputs.begin(), inputs.end());
+            slots.reserve(program.num_slots());
+            for (const Node& node : program.nodes) {
+                slots.push_back(apply_node(node, slots[node.a], slots[node.b]));
+            }
+            return slots;
+        });
+}
+
+/**
+ * @brief Evaluate a program with the dense reference propagator.
+ * @return Value of every slot, leaves first
+ */
+inline std::vector<ReferenceValue> evaluate_reference(const ExpressionProgram& program) {
+    const std::size_t n = program.num_leaves();
+    std::vector<ReferenceValue> slots;
+    slots.reserve(program.num_slots());
+    for (std::size_t i = 0; i < n; ++i) {
+        slots.push_back(ReferenceValue::leaf(program.leaf_nominals[i], i, n));
+    }
+
+    for (const Node& node : program.nodes) {
+        const ReferenceValue& a = slots[node.a];
+        const ReferenceValue& b = slots[node.b];
+        const double x = a.value;
+        const double y = b.value;
+        const double c = node.constant;
+        ReferenceValue r;
+        switch (node.op) {
+            case Op::Add: case Op::AddAssign:
+                r = ReferenceValue::combine(x + y, 1.0, a, 1.0, b); break;
+            case Op::Sub: case Op::SubAssign:
+                r = ReferenceValue::combine(x - y, 1.0, a, -1.0, b); break;
+            case Op::Mul: case Op::MulAssign:
+                r = ReferenceValue::combine(x * y, y, a, x, b); break;
+            case Op::Div: case Op::DivAssign:
+                r = ReferenceValue::combine(x / y, 1.0 / y, a, -x / (y * y), b); break;
+            case Op::Pow: {
+                double v = std::pow(x, y);
+                r = ReferenceValue::combine(v, y * std::pow(x, y - 1.0), a, v * std::log(x), b);
+                break;
+            }
+            case Op::Atan2: {
+                double d = x * x + y * y;
+                r = ReferenceValue::combine(std::atan2(x, y), y / d, a, -x / d, b);
+                break;
+            }
+            case Op::Hypot: {
+                double h = std::hypot(x, y);
+                r = ReferenceValue::combine(h, x / h, a, y / h, b);
+                break;
+            }
+            case Op::Neg: r = ReferenceValue::chain(-x, -1.0, a); break;
+            case Op::ScaleConst: r = ReferenceValue::chain(x * c, c, a); break;
+            case Op::AddConst: r = ReferenceValue::chain(x + c, 1.0, a); break;
+            case Op::DivConst: r = ReferenceValue::chain(x / c, 1.0 / c, a); break;
+            case Op::ConstDiv: r = ReferenceValue::chain(c / x, -c / (x * x), a); break;
+            case Op::Sin: r = ReferenceValue::chain(std::sin(x), std::cos(x), a); break;
+            case Op::Cos: r = ReferenceValue::chain(std::cos(x), -std::sin(x), a); break;
+            case Op::Tan: {
+                double t = std::tan(x);
+                r = ReferenceValue::chain(t, 1.0 + t * t, a);
+                break;
+            }
+            case Op::Asin: r = ReferenceValue::chain(std::asin(x), 1.0 / std::sqrt(1.0 - x * x), a); break;
+            case Op::Acos: r = ReferenceValue::chain(std::acos(x), -1.0 / std::sqrt(1.0 - x * x), a); break;
+            case Op::Atan: r = ReferenceValue::chain(std::atan(x), 1.0 / (1.0 + x * x), a); break;
+            case Op::Sinh: r = ReferenceValue::chain(std::sinh(x), std::cosh(x), a); break;
+            case Op::Cosh: r = ReferenceValue::chain(std::cosh(x), std::sinh(x), a); break;
+            case Op::Tanh: {
+                double t = std::tanh(x);
+                r = ReferenceValue::chain(t, 1.0 - t * t, a);
+                break;
+            }
+            case Op::Asinh: r = ReferenceValue::chain(std::asinh(x), 1.0 / std::sqrt(x * x + 1.0), a); break;
+            case Op::Acosh: r = ReferenceValue::chain(std::acosh(x), 1.0 / std::sqrt(x * x - 1.0), a); break;
+            case Op::Atanh: r = ReferenceValue::chain(std::atanh(x), 1.0 / (1.0 - x * x), a); break;
+            case Op::Exp: r = ReferenceValue::chain(std::exp(x), std::exp(x), a); break;
+            case Op::Log: r = ReferenceValue::chain(std::log(x), 1.0 / x, a); break;
+            case Op::Log10: r = ReferenceValue::chain(std::log10(x), 1.0 / (x * std::log(10.0)), a); break;
+            case Op::Sqrt: r = ReferenceValue::chain(std::sqrt(x), 0.5 / std::sqrt(x), a); break;
+            case Op::Abs: r = ReferenceValue::chain(std::abs(x), x > 0.0 ? 1.0 : -1.0, a); break;
+            case Op::Count: break;
+        }
+        slots.push_back(std::move(r));
+    }
+    return slots;
+}
+
+/// Relative/absolute closeness used by all comparisons
+inline bool close(double expected, double actual, double tolerance) {
+    if (std::isnan(expected) || std::isnan(actual)) {
+        return std::isnan(expected) && std::isnan(actual);
+    }
+    double scale = std::max({1.0, std::abs(expected), std::abs(actual)});
+    return std::abs(expected - actual) <= tolerance * scale;
+}
+
+/**
+ * @brief Compare a udouble against the reference value of the same slot.
+ * @param reference The reference value
+ * @param actual The value computed by the library
+ * @param leaves The atomic leaves of the program
+ * @param sigmas The leaf standard deviations
+ * @param tolerance Relative tolerance
+ * @return Empty string on agreement, otherwise a description of the mismatch
+ */
+inline std::string compare_with_reference(const ReferenceValue& reference,
+                                          const uncertainties::udouble& actual,
+                                          const std::vector<uncertainties::udouble>& leaves,
+                                          const std::vector<double>& sigmas,
+                                          double tolerance) {
+    if (!close(reference.value, actual.nominal_value(), tolerance)) {
+        return "nominal " + std::to_string(actual.nominal_value()) +
+               " != " + std::to_string(reference.value);
+    }
+
+    std::size_t matched = 0;
+    for (std::size_t i = 0; i < leaves.size(); ++i) {
+        uint64_t id = leaves[i].derivatives().begin()->first;
+        auto it = actual.derivatives().find(id);
+        double deriv = (it == actual.derivatives().end()) ? 0.0 : it->second;
+        matched += (it != actual.derivatives().end());
+        if (!close(reference.grad[i], deriv, tolerance)) {
+            return "derivative w.r.t. leaf " + std::to_string(i) + ": " +
+                   std::to_string(deriv) + " != " + std::to_string(reference.grad[i]);
+        }
+    }
+    if (matched != actual.num_variables()) {
+        return "derivative map contains IDs that are not leaves";
+    }
+
+    if (!close(reference.stddev(sigmas), actual.stddev(), tolerance)) {
+        return "stddev " + std::to_string(actual.stddev()) +
+               " != " + std::to_string(reference.stddev(sigmas));
+    }
+    return {};
+}
+
+} // namespace differential
@@ -0,0 +1,34 @@
+// libFuzzer entry point for the differential harness.
+//
+// Build with -DUNCERTAINTIES_BUILD_FUZZERS=ON using Clang, then run e.g.
+//   ./fuzz_differential -max_total_time=60
+// Any disagreement with the reference propagator aborts with a message.
+#include <cstdio>
+#include <cstdlib>
+#include "differential_harness.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size < 4) {
+        return 0;
+    }
+
+    differential::ByteChoices choices(data, size);
+    std::size_t num_leaves = 1 + choices.next(8);
+    std::size_t num_nodes = 1 + choices.next(64);
+    auto program = differential::generate_program(choices, num_leaves, num_nodes);
+
+    std::vector<uncertainties::udouble> leaves;
+    auto actual = differential::evaluate_udouble(program, leaves);
+    auto reference = differential::evaluate_reference(program);
+
+    for (std::size_t slot = 0; slot < actual.size(); ++slot) {
+        std::string mismatch = differential::compare_with_reference(
+            reference[slot], actual[slot], leaves, program.leaf_stddevs, 1e-9);
+        if (!mismatch.empty()) {
+            std::fprintf(stderr, "slot %zu: %s\n", slot, mismatch.c_str());
+            std::abort();
+        }
+    }
+    return 0;
+}
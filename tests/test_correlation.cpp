@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <thread>
+#include <vector>
 #include "uncertainties/udouble.hpp"
 #include "uncertainties/umath.hpp"
 
@@ -320,3 +322,182 @@ TEST_F(CorrelationTest, HypotSameVariable) {
     // d/dx(sqrt(2)*x) = sqrt(2)
     EXPECT_NEAR(result.stddev(), std::sqrt(2.0) * 0.1, 1e-10);
 }
+
+// Lazy registration of atomics
+
+TEST_F(CorrelationTest, AtomicsRegisterOnFirstCombination) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    udouble x(10.0, 0.5);
+
+    // Printing, comparing and querying leave the registry untouched
+    EXPECT_NEAR(x.stddev(), 0.5, 1e-12);
+    EXPECT_FALSE(x.to_string().empty());
+    EXPECT_TRUE(x > udouble(1.0));
+    EXPECT_EQ(registry.size(), 0u);
+
+    udouble y = x * 2.0;
+    EXPECT_EQ(registry.size(), 1u);
+    EXPECT_NEAR(y.stddev(), 1.0, 1e-12);
+}
+
+TEST_F(CorrelationTest, CopiesBeforeRegistrationStayCorrelated) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    udouble x(10.0, 0.5);
+    udouble copy = x;
+
+    udouble result = x - copy;
+
+    EXPECT_NEAR(result.stddev(), 0.0, 1e-12);
+    EXPECT_EQ(registry.size(), 1u);
+}
+
+TEST_F(CorrelationTest, DerivativesAccessorRegistersId) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    udouble x(1.0, 0.25);
+
+    uint64_t id = x.derivatives().begin()->first;
+
+    EXPECT_NEAR(registry.get_stddev(id), 0.25, 1e-12);
+}
+
+TEST_F(CorrelationTest, StoredDerivativesLeaveRegistryUntouched) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    udouble x(1.0, 0.25);
+
+    static_assert(noexcept(x.stored_derivatives()), "stored_derivatives() must not throw");
+    const auto& derivs = x.stored_derivatives();
+
+    ASSERT_EQ(derivs.size(), 1u);
+    EXPECT_EQ(derivs.begin()->second, 1.0);
+    EXPECT_EQ(registry.size(), 0u);
+    EXPECT_EQ(&derivs, &x.derivatives());
+    EXPECT_EQ(registry.size(), 1u);
+}
+
+TEST_F(CorrelationTest, InPlaceUpdateOfUnregisteredAtomic) {
+    udouble x(3.0, 0.1);
+    udouble original = x;
+
+    x *= 2.0;
+    x += 1.0;
+
+    EXPECT_FALSE(x.is_atomic());
+    EXPECT_NEAR(x.nominal_value(), 7.0, 1e-12);
+    EXPECT_NEAR(x.stddev(), 0.2, 1e-12);
+    EXPECT_NEAR((x - 2.0 * original).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(CorrelationTest, SetStddevCreatesUnregisteredAtomic) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    udouble x(3.0, 0.1);
+    udouble y = x + 1.0;
+    EXPECT_EQ(registry.size(), 1u);
+
+    x.set_stddev(0.3);
+
+    EXPECT_EQ(registry.size(), 1u);
+    EXPECT_NEAR(x.stddev(), 0.3, 1e-12);
+    EXPECT_NEAR((x - y).stddev(), std::sqrt(0.09 + 0.01), 1e-12);
+}
+
+TEST_F(CorrelationTest, ConcurrentFirstUseOfSharedAtomic) {
+    const udouble x(2.0, 0.1);
+    std::vector<udouble> results(8);
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&x, &results, i]() { results[i] = x * x; });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(uncertainties::detail::VariableRegistry::instance().size(), 1u);
+    for (const auto& r : results) {
+        EXPECT_NEAR(r.stddev(), 0.4, 1e-12);
+    }
+}
+
+// Cached standard deviation
+
+TEST_F(CorrelationTest, RepeatedStddevQueriesAgree) {
+    udouble x(1.0, 0.3);
+    udouble y(2.0, 0.4);
+    udouble z = x * y + x;
+
+    double first = z.stddev();
+    EXPECT_NEAR(first, std::sqrt(9.0 * 0.09 + 0.16), 1e-12);
+    EXPECT_EQ(z.stddev(), first);
+    EXPECT_EQ(udouble(z).stddev(), first);
+}
+
+TEST_F(CorrelationTest, CachedStddevFollowsRegistryChange) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    udouble x(1.0, 0.1);
+    udouble y = 2.0 * x;
+    udouble copy_before_registration = x;
+    EXPECT_NEAR(y.stddev(), 0.2, 1e-12);
+    EXPECT_NEAR(x.stddev(), 0.1, 1e-12);
+
+    uint64_t id = x.derivatives().begin()->first;
+    uint64_t generation = registry.generation();
+    registry.set_stddev(id, 0.5);
+
+    EXPECT_GT(registry.generation(), generation);
+    EXPECT_NEAR(y.stddev(), 1.0, 1e-12);
+    EXPECT_NEAR(x.stddev(), 0.5, 1e-12);
+    EXPECT_NEAR(copy_before_registration.stddev(), 0.5, 1e-12);
+}
+
+TEST_F(CorrelationTest, CachedStddevInvalidatedByInPlaceUpdate) {
+    udouble x(1.0, 0.1);
+    udouble y(1.0, 0.2);
+    udouble sum = x + y;
+    EXPECT_NEAR(sum.stddev(), std::sqrt(0.05), 1e-12);
+
+    sum += x;
+    EXPECT_NEAR(sum.stddev(), std::sqrt(0.04 + 0.04), 1e-12);
+    sum *= 0.5;
+    EXPECT_NEAR(sum.stddev(), std::sqrt(0.02), 1e-12);
+
+    sum.set_stddev(0.7);
+    EXPECT_NEAR(sum.stddev(), 0.7, 1e-12);
+}
+
+TEST_F(CorrelationTest, RegistrySetStddevValidation) {
+    auto& registry = uncertainties::detail::VariableRegistry::instance();
+    EXPECT_THROW(registry.set_stddev(12345, 1.0), std::runtime_error);
+
+    uint64_t id = registry.register_variable(1.0);
+    EXPECT_THROW(registry.set_stddev(id, -1.0), std::invalid_argument);
+}
+
+TEST_F(CorrelationTest, ConcurrentStddevQueries) {
+    std::vector<udouble> terms;
+    for (int i = 0; i < 50; ++i) {
+        terms.emplace_back(1.0, 0.01 * (i + 1));
+    }
+    udouble total;
+    for (const auto& t : terms) {
+        total += t;
+    }
+    const udouble shared = total;
+    const double expected = total.stddev();
+
+    std::vector<double> seen(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        threads.emplace_back([&shared, &seen, i]() {
+            for (int k = 0; k < 1000; ++k) {
+                seen[i] = shared.stddev();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (double s : seen) {
+        EXPECT_DOUBLE_EQ(s, expected);
+    }
+}
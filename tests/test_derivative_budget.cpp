@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+#include "uncertainties/derivative_budget.hpp"
+#include "uncertainties/sparse.hpp"
+
+using uncertainties::udouble;
+using uncertainties::BudgetAction;
+using uncertainties::DerivativeBudget;
+using uncertainties::ScopedDerivativeBudget;
+
+// Reset the thread's budget and counters between tests
+class DerivativeBudgetTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+        uncertainties::set_derivative_budget(DerivativeBudget{});
+        uncertainties::reset_derivative_budget_stats();
+    }
+
+    void TearDown() override {
+        uncertainties::set_derivative_budget(DerivativeBudget{});
+    }
+
+    // Sum of n independent atomics with increasing uncertainty
+    static udouble sum_of_atomics(int n) {
+        udouble sum;
+        for (int i = 1; i <= n; ++i) {
+            sum += udouble(1.0, 0.01 * i);
+        }
+        return sum;
+    }
+};
+
+TEST_F(DerivativeBudgetTest, DefaultHasNoLimits) {
+    udouble sum = sum_of_atomics(100);
+
+    EXPECT_EQ(sum.num_variables(), 100u);
+    EXPECT_EQ(uncertainties::derivative_budget_stats().exceeded, 0u);
+}
+
+TEST_F(DerivativeBudgetTest, ThrowOnEntryLimit) {
+    DerivativeBudget budget;
+    budget.max_entries = 10;
+    budget.action = BudgetAction::Throw;
+    ScopedDerivativeBudget scope(budget);
+
+    EXPECT_THROW(sum_of_atomics(11), uncertainties::derivative_budget_exceeded);
+
+    auto stats = uncertainties::derivative_budget_stats();
+    EXPECT_EQ(stats.exceeded, 1u);
+    EXPECT_EQ(stats.thrown, 1u);
+}
+
+TEST_F(DerivativeBudgetTest, CompoundAssignmentIsUnchangedAfterThrow) {
+    udouble a(1.0, 0.1);
+    udouble b(2.0, 0.2);
+    udouble c(3.0, 0.3);
+    udouble x = a + b;
+
+    DerivativeBudget budget;
+    budget.max_entries = 2;
+    ScopedDerivativeBudget scope(budget);
+
+    EXPECT_THROW(x += c, uncertainties::derivative_budget_exceeded);
+    EXPECT_THROW(x -= c, uncertainties::derivative_budget_exceeded);
+    EXPECT_THROW(x *= c, uncertainties::derivative_budget_exceeded);
+    EXPECT_THROW(x /= c, uncertainties::derivative_budget_exceeded);
+    EXPECT_DOUBLE_EQ(x.nominal_value(), 3.0);
+    EXPECT_EQ(x.num_variables(), 2u);
+    EXPECT_NEAR(x.stddev(), std::hypot(0.1, 0.2), 1e-15);
+
+    // Within the budget the operators still work
+    x *= a;
+    EXPECT_DOUBLE_EQ(x.nominal_value(), 3.0);
+    EXPECT_EQ(x.num_variables(), 2u);
+}
+
+TEST_F(DerivativeBudgetTest, CompoundAssignmentEnforcesTheBudgetOnce) {
+    udouble a(1.0, 0.1);
+    udouble b(2.0, 0.2);
+    udouble c(3.0, 0.3);
+    udouble x = a + b;
+
+    DerivativeBudget budget;
+    budget.max_entries = 1;
+    budget.action = BudgetAction::Callback;
+    ScopedDerivativeBudget scope(budget);
+
+    udouble product = x * c;
+    EXPECT_EQ(uncertainties::derivative_budget_stats().callbacks, 1u);
+    x *= c;
+    EXPECT_EQ(uncertainties::derivative_budget_stats().callbacks, 2u);
+    x /= c;
+    EXPECT_EQ(uncertainties::derivative_budget_stats().callbacks, 3u);
+    EXPECT_EQ(uncertainties::derivative_budget_stats().exceeded, 3u);
+
+    // Pruning sees the complete result, rhs contributions included
+    budget.max_entries = 2;
+    budget.action = BudgetAction::Prune;
+    ScopedDerivativeBudget prune(budget);
+    udouble y = a + b;
+    udouble big(1.0, 10.0);
+    udouble expected = y * big;
+    y *= big;
+    EXPECT_EQ(y.num_variables(), 2u);
+    EXPECT_EQ(y.derivatives().count(big.derivatives().begin()->first), 1u);
+    EXPECT_NEAR(y.stddev(), expected.stddev(), 1e-15);
+}
+
+TEST_F(DerivativeBudgetTest, ExceptionReportsSize) {
+    DerivativeBudget budget;
+    budget.max_entries = 3;
+    ScopedDerivativeBudget scope(budget);
+
+    try {
+        sum_of_atomics(4);
+        FAIL() << "Expected derivative_budget_exceeded";
+    } catch (const uncertainties::derivative_budget_exceeded& e) {
+        EXPECT_EQ(e.entries(), 4u);
+        EXPECT_GT(e.bytes(), 0u);
+    }
+}
+
+TEST_F(DerivativeBudgetTest, PruneKeepsLargestContributions) {
+    DerivativeBudget budget;
+    budget.max_entries = 5;
+    budget.action = BudgetAction::Prune;
+    ScopedDerivativeBudget scope(budget);
+
+    udouble sum = sum_of_atomics(20);
+
+    EXPECT_EQ(sum.num_variables(), 5u);
+    EXPECT_NEAR(sum.nominal_value(), 20.0, 1e-12);
+
+    // The five largest sigmas (0.16 .. 0.20) survive
+    double expected = 0.0;
+    for (int i = 16; i <= 20; ++i) {
+        expected += (0.01 * i) * (0.01 * i);
+    }
+    EXPECT_NEAR(sum.stddev(), std::sqrt(expected), 1e-12);
+
+    auto stats = uncertainties::derivative_budget_stats();
+    EXPECT_EQ(stats.pruned, stats.exceeded);
+    EXPECT_GT(stats.entries_pruned, 0u);
+}
+
+TEST_F(DerivativeBudgetTest, PruneOnByteLimit) {
+    DerivativeBudget budget;
+    budget.max_bytes = 4096;
+    budget.action = BudgetAction::Prune;
+    ScopedDerivativeBudget scope(budget);
+
+    udouble sum = sum_of_atomics(1000);
+
+    EXPECT_LT(sum.num_variables(), 1000u);
+    EXPECT_GT(uncertainties::derivative_budget_stats().pruned, 0u);
+}
+
+TEST_F(DerivativeBudgetTest, PrunedMapsFitTheByteLimit) {
+    udouble big = sum_of_atomics(1000);
+    for (std::size_t max_bytes : {256u, 1000u, 4096u, 10000u, 65536u}) {
+        DerivativeBudget budget;
+        budget.max_bytes = max_bytes;
+        budget.action = BudgetAction::Prune;
+        ScopedDerivativeBudget scope(budget);
+
+        udouble scaled = 2.0 * big;
+        EXPECT_LE(uncertainties::detail::estimate_map_bytes(scaled.derivatives()), max_bytes);
+        EXPECT_GT(scaled.num_variables(), 0u);
+    }
+}
+
+TEST_F(DerivativeBudgetTest, CallbackLeavesMapUnchanged) {
+    std::size_t reported = 0;
+    DerivativeBudget budget;
+    budget.max_entries = 8;
+    budget.action = BudgetAction::Callback;
+    budget.callback = [&reported](std::size_t entries, std::size_t) {
+        reported = entries;
+    };
+    ScopedDerivativeBudget scope(budget);
+
+    udouble sum = sum_of_atomics(10);
+
+    EXPECT_EQ(sum.num_variables(), 10u);
+    EXPECT_EQ(reported, 10u);
+    EXPECT_EQ(uncertainties::derivative_budget_stats().callbacks, 2u);
+}
+
+TEST_F(DerivativeBudgetTest, EnforcedInMathFunctions) {
+    udouble sum = sum_of_atomics(10);
+
+    DerivativeBudget budget;
+    budget.max_entries = 5;
+    ScopedDerivativeBudget scope(budget);
+
+    EXPECT_THROW(uncertainties::sin(sum), uncertainties::derivative_budget_exceeded);
+    EXPECT_THROW(uncertainties::hypot(sum, sum), uncertainties::derivative_budget_exceeded);
+}
+
+TEST_F(DerivativeBudgetTest, ScopeRestoresPreviousBudget) {
+    {
+        DerivativeBudget budget;
+        budget.max_entries = 2;
+        ScopedDerivativeBudget scope(budget);
+        EXPECT_EQ(uncertainties::derivative_budget().max_entries, 2u);
+    }
+
+    EXPECT_EQ(uncertainties::derivative_budget().max_entries, 0u);
+    EXPECT_NO_THROW(sum_of_atomics(10));
+}
+
+TEST_F(DerivativeBudgetTest, BudgetIsPerThread) {
+    DerivativeBudget budget;
+    budget.max_entries = 2;
+    ScopedDerivativeBudget scope(budget);
+
+    std::size_t other_thread_size = 0;
+    std::thread worker([&other_thread_size]() {
+        other_thread_size = sum_of_atomics(10).num_variables();
+    });
+    worker.join();
+
+    EXPECT_EQ(other_thread_size, 10u);
+    EXPECT_THROW(sum_of_atomics(10), uncertainties::derivative_budget_exceeded);
+}
+
+TEST_F(DerivativeBudgetTest, WorkerThreadsUseTheCallersBudget) {
+    // Enough rows for several threads; every row depends on four atomics
+    const std::size_t rows = 4096;
+    std::vector<uncertainties::SparseEntry> entries;
+    for (std::size_t i = 0; i < rows; ++i) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            entries.push_back({i, j, udouble(1.0, 0.1 * (j + 1))});
+        }
+    }
+    uncertainties::SparseUMatrix A(rows, 4, entries);
+    std::vector<double> x{1.0, 1.0, 1.0, 1.0};
+
+    DerivativeBudget budget;
+    budget.max_entries = 2;
+    budget.action = BudgetAction::Prune;
+    ScopedDerivativeBudget scope(budget);
+
+    uncertainties::SparseOptions options;
+    options.threads = 4;
+    std::vector<udouble> y = uncertainties::spmv(A, x, options);
+    for (const udouble& v : y) {
+        ASSERT_EQ(v.num_variables(), 2u);
+    }
+    auto stats = uncertainties::derivative_budget_stats();
+    EXPECT_EQ(stats.pruned, rows);
+    EXPECT_EQ(stats.entries_pruned, 2 * rows);
+
+    // Throwing in a worker reaches the caller
+    budget.action = BudgetAction::Throw;
+    ScopedDerivativeBudget strict(budget);
+    EXPECT_THROW(uncertainties::spmv(A, x, options), uncertainties::derivative_budget_exceeded);
+}
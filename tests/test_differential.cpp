@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "differential_harness.hpp"
+
+using uncertainties::udouble;
+
+// Relative tolerance for agreement with the reference propagator
+constexpr double TOLERANCE = 1e-9;
+
+class DifferentialTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // Generate a program from `seed` and compare every slot with the reference
+    static void check_program(uint64_t seed, std::size_t num_leaves, std::size_t num_nodes) {
+        differential::SeededChoices choices(seed);
+        auto program = differential::generate_program(choices, num_leaves, num_nodes);
+
+        std::vector<udouble> leaves;
+        auto actual = differential::evaluate_udouble(program, leaves);
+        auto reference = differential::evaluate_reference(program);
+
+        ASSERT_EQ(actual.size(), reference.size());
+        for (std::size_t slot = 0; slot < actual.size(); ++slot) {
+            std::string mismatch = differential::compare_with_reference(
+                reference[slot], actual[slot], leaves, program.leaf_stddevs, TOLERANCE);
+            ASSERT_TRUE(mismatch.empty())
+                << "seed " << seed << ", slot " << slot << ": " << mismatch;
+        }
+    }
+};
+
+// Record a program as a Formula, run it on the leaves and compare every
+// output with the reference
+static void check_formula(uint64_t seed, std::size_t num_leaves, std::size_t num_nodes) {
+    differential::SeededChoices choices(seed);
+    auto program = differential::generate_program(choices, num_leaves, num_nodes);
+
+    std::vector<udouble> leaves;
+    differential::evaluate_udouble(program, leaves);
+    auto formula = differential::record_formula(program);
+    auto actual = formula.apply(leaves);
+    auto reference = differential::evaluate_reference(program);
+
+    ASSERT_EQ(actual.size(), reference.size());
+    for (std::size_t slot = 0; slot < actual.size(); ++slot) {
+        std::string mismatch = differential::compare_with_reference(
+            reference[slot], actual[slot], leaves, program.leaf_stddevs, TOLERANCE);
+        ASSERT_TRUE(mismatch.empty())
+            << "formula, seed " << seed << ", slot " << slot << ": " << mismatch;
+    }
+}
+
+TEST_F(DifferentialTest, SingleLeafPrograms) {
+    for (uint64_t seed = 1; seed <= 100; ++seed) {
+        check_program(seed, 1, 30);
+    }
+}
+
+TEST_F(DifferentialTest, FewLeafPrograms) {
+    for (uint64_t seed = 1; seed <= 200; ++seed) {
+        check_program(1000 + seed, 4, 40);
+    }
+}
+
+TEST_F(DifferentialTest, ManyLeafPrograms) {
+    for (uint64_t seed = 1; seed <= 20; ++seed) {
+        check_program(5000 + seed, 64, 200);
+    }
+}
+
+TEST_F(DifferentialTest, FormulaProgramsMatchReference) {
+    for (uint64_t seed = 1; seed <= 100; ++seed) {
+        check_formula(seed, 1, 30);
+        check_formula(1000 + seed, 4, 40);
+    }
+    for (uint64_t seed = 1; seed <= 10; ++seed) {
+        check_formula(5000 + seed, 64, 200);
+    }
+}
+
+TEST_F(DifferentialTest, GeneratorIsDeterministic) {
+    differential::SeededChoices first(42), second(42);
+    auto a = differential::generate_program(first, 3, 50);
+    auto b = differential::generate_program(second, 3, 50);
+
+    ASSERT_EQ(a.nodes.size(), b.nodes.size());
+    for (std::size_t i = 0; i < a.nodes.size(); ++i) {
+        EXPECT_EQ(a.nodes[i].op, b.nodes[i].op);
+        EXPECT_EQ(a.nodes[i].a, b.nodes[i].a);
+        EXPECT_EQ(a.nodes[i].b, b.nodes[i].b);
+    }
+}
+
+TEST_F(DifferentialTest, GeneratorCoversAllOperations) {
+    differential::SeededChoices choices(7);
+    auto program = differential::generate_program(choices, 4, 5000);
+
+    std::vector<bool> seen(static_cast<std::size_t>(differential::Op::Count), false);
+    for (const auto& node : program.nodes) {
+        seen[static_cast<std::size_t>(node.op)] = true;
+    }
+    for (std::size_t op = 0; op < seen.size(); ++op) {
+        EXPECT_TRUE(seen[op]) << "operation " << op << " never generated";
+    }
+}
+
+TEST_F(DifferentialTest, ByteChoicesDecodeFuzzerInput) {
+    const uint8_t data[] = {0x12, 0x34, 0xff, 0x00, 0x7f, 0x80};
+    differential::ByteChoices choices(data, sizeof(data));
+    auto program = differential::generate_program(choices, 2, 20);
+
+    std::vector<udouble> leaves;
+    auto actual = differential::evaluate_udouble(program, leaves);
+    auto reference = differential::evaluate_reference(program);
+    for (std::size_t slot = 0; slot < actual.size(); ++slot) {
+        EXPECT_TRUE(differential::compare_with_reference(
+            reference[slot], actual[slot], leaves, program.leaf_stddevs, TOLERANCE).empty());
+    }
+}
@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "uncertainties/distributed.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#define UNCERTAINTIES_HAVE_FORK 1
+#endif
+
+using uncertainties::udouble;
+using Registry = uncertainties::detail::VariableRegistry;
+
+class DistributedTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Registry::instance().clear();
+    }
+
+#ifdef UNCERTAINTIES_HAVE_FORK
+    // Run `work` in a forked child and return what it serialized
+    static std::string run_worker(const std::function<void(std::ostream&)>& work) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            ADD_FAILURE() << "pipe failed";
+            return {};
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            int status = 0;
+            try {
+                std::ostringstream out;
+                work(out);
+                std::string data = out.str();
+                const char* p = data.data();
+                std::size_t left = data.size();
+                while (left > 0) {
+                    ssize_t written = write(fds[1], p, left);
+                    if (written <= 0) {
+                        status = 2;
+                        break;
+                    }
+                    p += written;
+                    left -= static_cast<std::size_t>(written);
+                }
+            } catch (...) {
+                status = 1;
+            }
+            close(fds[1]);
+            _exit(status);
+        }
+        close(fds[1]);
+        std::string data;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+            data.append(buffer, static_cast<std::size_t>(n));
+        }
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        return data;
+    }
+#endif
+};
+
+TEST_F(DistributedTest, NamespacesPrefixIds) {
+    udouble a(1.0, 0.1);
+    uint64_t first = a.derivatives().begin()->first;
+    EXPECT_EQ(Registry::namespace_of(first), 0u);
+
+    uncertainties::set_id_namespace(7);
+    EXPECT_EQ(uncertainties::id_namespace(), 7u);
+    udouble b(2.0, 0.2);
+    uint64_t second = b.derivatives().begin()->first;
+    EXPECT_EQ(Registry::namespace_of(second), 7u);
+    // The local counter carries over
+    EXPECT_GT(Registry::local_part(second), Registry::local_part(first));
+    // Existing atomics keep working
+    EXPECT_NEAR((a + b).stddev(), std::hypot(0.1, 0.2), 1e-15);
+
+    EXPECT_THROW(uncertainties::set_id_namespace(Registry::MAX_ID_NAMESPACE + 1), std::invalid_argument);
+}
+
+TEST_F(DistributedTest, RoundTripIsExact) {
+    udouble x(1.0 / 3.0, 0.01);
+    udouble y(std::sqrt(2.0), 1e-7);
+    std::vector<udouble> values{x * y, sin(x) + y, udouble(5.0), x};
+
+    std::stringstream stream;
+    uncertainties::serialize(stream, values);
+    std::vector<udouble> restored = uncertainties::deserialize(stream);
+
+    ASSERT_EQ(restored.size(), values.size());
+    for (std::size_t k = 0; k < values.size(); ++k) {
+        EXPECT_EQ(restored[k].nominal_value(), values[k].nominal_value());
+        EXPECT_EQ(restored[k].stddev(), values[k].stddev());
+        EXPECT_EQ((restored[k] - values[k]).stddev(), 0.0);
+    }
+}
+
+TEST_F(DistributedTest, ImportedIdsAreNotReissued) {
+    std::stringstream stream;
+    uncertainties::set_id_namespace(3);
+    udouble remote(1.0, 0.5);
+    uncertainties::serialize(stream, {remote});
+
+    Registry::instance().clear();
+    uncertainties::set_id_namespace(3);
+    auto imported = uncertainties::deserialize(stream);
+    udouble local(1.0, 0.25);
+
+    EXPECT_NEAR((imported[0] + local).stddev(), std::hypot(0.5, 0.25), 1e-15);
+}
+
+TEST_F(DistributedTest, MalformedInput) {
+    std::stringstream wrong_tag("something-else atomics 0 values 0");
+    EXPECT_THROW(uncertainties::deserialize(wrong_tag), std::runtime_error);
+    std::stringstream truncated("uncertainties-udouble-v1 atomics 1 5");
+    EXPECT_THROW(uncertainties::deserialize(truncated), std::runtime_error);
+    std::stringstream undeclared("uncertainties-udouble-v1 atomics 0 values 1 0x1p+0 1 99 0x1p+0");
+    EXPECT_THROW(uncertainties::deserialize(undeclared), std::runtime_error);
+}
+
+#ifdef UNCERTAINTIES_HAVE_FORK
+
+TEST_F(DistributedTest, WorkerProcessesMergeExactly) {
+    // Broadcast parameter, created before the workers fork
+    udouble gain(2.0, 0.1);
+    gain.derivatives();
+
+    std::vector<std::string> outputs;
+    for (int k = 0; k < 2; ++k) {
+        outputs.push_back(run_worker([&, k](std::ostream& out) {
+            uncertainties::set_id_namespace(static_cast<uint64_t>(k + 1));
+            udouble noise(0.0, 0.05 * (k + 1));
+            udouble reading = gain * (k + 1.0) + noise;
+            uncertainties::serialize(out, {reading, noise});
+        }));
+    }
+
+    std::istringstream first(outputs[0]);
+    std::istringstream second(outputs[1]);
+    auto r1 = uncertainties::deserialize(first);
+    auto r2 = uncertainties::deserialize(second);
+
+    // reading_k = (k + 1) gain + noise_k, sharing gain and nothing else
+    EXPECT_NEAR(r1[0].stddev(), std::hypot(0.1, 0.05), 1e-15);
+    EXPECT_NEAR(r2[0].stddev(), std::hypot(0.2, 0.1), 1e-15);
+    EXPECT_NEAR((r2[0] - 2.0 * r1[0]).stddev(), std::hypot(0.1, 2.0 * 0.05), 1e-15);
+    EXPECT_NEAR((r1[0] - gain - r1[1]).stddev(), 0.0, 1e-15);
+    EXPECT_NEAR((r1[1] + r2[1]).stddev(), std::hypot(0.05, 0.1), 1e-15);
+}
+
+TEST_F(DistributedTest, CollidingWorkersAreDetected) {
+    std::vector<std::string> outputs;
+    for (int k = 0; k < 2; ++k) {
+        // No namespace: both workers allocate the same ID
+        outputs.push_back(run_worker([k](std::ostream& out) {
+            udouble noise(0.0, 0.05 * (k + 1));
+            uncertainties::serialize(out, {noise});
+        }));
+    }
+    // The coordinator has a namespace of its own
+    uncertainties::set_id_namespace(9);
+
+    std::istringstream first(outputs[0]);
+    std::istringstream second(outputs[1]);
+    uncertainties::deserialize(first);
+    EXPECT_THROW(uncertainties::deserialize(second), std::runtime_error);
+}
+
+TEST_F(DistributedTest, CollisionsWithEqualStddevsAreDetected) {
+    uncertainties::set_id_namespace(9);
+    std::vector<std::string> outputs;
+    for (int k = 0; k < 2; ++k) {
+        // Same namespace and same stddev: the IDs agree, the atomics do not
+        outputs.push_back(run_worker([](std::ostream& out) {
+            uncertainties::set_id_namespace(1);
+            udouble noise(0.0, 0.05);
+            uncertainties::serialize(out, {noise});
+        }));
+    }
+
+    std::istringstream first(outputs[0]);
+    std::istringstream second(outputs[1]);
+    auto r1 = uncertainties::deserialize(first);
+    EXPECT_THROW(uncertainties::deserialize(second), std::runtime_error);
+
+    // The same writer may send more than once
+    std::istringstream again(outputs[0]);
+    auto r2 = uncertainties::deserialize(again);
+    EXPECT_EQ((r1[0] - r2[0]).stddev(), 0.0);
+}
+
+TEST_F(DistributedTest, WritersInTheReadersNamespaceAreRejected) {
+    udouble local(1.0, 0.05);
+    local.derivatives();
+    std::string output = run_worker([](std::ostream& out) {
+        // An unrelated process allocating from the same counter state
+        Registry::instance().clear();
+        udouble noise(0.0, 0.05);
+        uncertainties::serialize(out, {noise});
+    });
+
+    std::istringstream in(output);
+    EXPECT_THROW(uncertainties::deserialize(in), std::runtime_error);
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "uncertainties/filter.hpp"
+#include "uncertainties/udouble.hpp"
+
+using uncertainties::udouble;
+using uncertainties::FilterMode;
+using uncertainties::FilterOptions;
+
+class FilterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    static std::vector<udouble> independent_signal(std::size_t n) {
+        std::mt19937_64 rng(5);
+        std::normal_distribution<double> noise(0.0, 1.0);
+        std::vector<udouble> xs;
+        for (std::size_t i = 0; i < n; ++i) {
+            xs.emplace_back(std::sin(0.1 * static_cast<double>(i)) + 0.1 * noise(rng),
+                            0.05 + 0.01 * std::abs(noise(rng)));
+        }
+        return xs;
+    }
+
+    // Every sample shares a calibration gain, so the samples are correlated
+    static std::vector<udouble> correlated_signal(std::size_t n) {
+        udouble gain(1.0, 0.03);
+        auto xs = independent_signal(n);
+        for (std::size_t i = 0; i < n; i += 2) {
+            xs[i] = xs[i] * gain;
+        }
+        return xs;
+    }
+
+    // Full convolution written with udouble arithmetic
+    static std::vector<udouble> reference_full(const std::vector<udouble>& xs,
+                                               const std::vector<double>& h) {
+        std::vector<udouble> out(xs.size() + h.size() - 1, udouble(0.0));
+        for (std::size_t m = 0; m < out.size(); ++m) {
+            for (std::size_t j = 0; j < h.size(); ++j) {
+                if (m >= j && m - j < xs.size()) {
+                    out[m] += h[j] * xs[m - j];
+                }
+            }
+        }
+        return out;
+    }
+
+    static void expect_matches(const uncertainties::FilterResult& result,
+                               const std::vector<udouble>& expected, std::size_t offset) {
+        for (std::size_t k = 0; k < result.size(); ++k) {
+            const udouble& e = expected[k + offset];
+            EXPECT_NEAR(result.nominal()[k], e.nominal_value(), 1e-12);
+            EXPECT_NEAR(result.stddev()[k], e.stddev(), 1e-12);
+        }
+    }
+};
+
+TEST_F(FilterTest, ConvolutionModesMatchUdoubleLoop) {
+    const std::vector<double> h = {0.25, -0.5, 1.0, 0.125};
+    for (bool correlated : {false, true}) {
+        auto xs = correlated ? correlated_signal(50) : independent_signal(50);
+        auto expected = reference_full(xs, h);
+
+        auto full = uncertainties::convolve(xs, h);
+        auto same = uncertainties::convolve(xs, h, FilterMode::Same);
+        auto valid = uncertainties::convolve(xs, h, FilterMode::Valid);
+
+        ASSERT_EQ(full.size(), 53u);
+        ASSERT_EQ(same.size(), 50u);
+        ASSERT_EQ(valid.size(), 47u);
+        expect_matches(full, expected, 0);
+        expect_matches(same, expected, 1);
+        expect_matches(valid, expected, 3);
+    }
+}
+
+TEST_F(FilterTest, BandAndCoefficients) {
+    auto xs = independent_signal(10);
+    auto result = uncertainties::convolve(xs, {1.0, 2.0, 3.0});
+
+    EXPECT_EQ(result.band_begin(0), 0u);
+    EXPECT_EQ(result.band_end(0), 1u);
+    EXPECT_EQ(result.band_begin(5), 3u);
+    EXPECT_EQ(result.band_end(5), 6u);
+    EXPECT_EQ(result.band_end(11), 10u);
+    EXPECT_DOUBLE_EQ(result.coefficient(5, 5), 1.0);
+    EXPECT_DOUBLE_EQ(result.coefficient(5, 3), 3.0);
+    EXPECT_DOUBLE_EQ(result.coefficient(5, 2), 0.0);
+}
+
+TEST_F(FilterTest, MovingAverageOfCorrelatedSamples) {
+    udouble offset(2.0, 0.5);
+    std::vector<udouble> xs;
+    for (int i = 0; i < 8; ++i) {
+        xs.push_back(udouble(static_cast<double>(i), 0.1) + offset);
+    }
+
+    auto result = uncertainties::moving_average(xs, 4);
+
+    ASSERT_EQ(result.size(), 5u);
+    EXPECT_NEAR(result.nominal()[0], 3.5, 1e-14);
+    // The common offset does not average out
+    EXPECT_NEAR(result.stddev()[0], std::sqrt(0.25 + 4 * 0.01 / 16), 1e-14);
+}
+
+TEST_F(FilterTest, MaterializedValuesAreCorrelated) {
+    auto xs = correlated_signal(40);
+    FilterOptions options;
+    options.threads = 3;
+    auto result = uncertainties::moving_average(xs, 5, options);
+    auto values = result.values();
+
+    ASSERT_EQ(values.size(), 36u);
+    for (std::size_t k = 1; k < values.size(); ++k) {
+        EXPECT_NEAR(values[k].stddev(), result.stddev()[k], 1e-12);
+        // Consecutive windows differ by one sample entering and one leaving
+        udouble step = values[k] - values[k - 1] - (xs[k + 4] - xs[k - 1]) / 5.0;
+        EXPECT_NEAR(step.stddev(), 0.0, 1e-12);
+    }
+}
+
+TEST_F(FilterTest, ExponentialSmoothingMatchesRecursion) {
+    const double alpha = 0.3;
+    for (bool correlated : {false, true}) {
+        auto xs = correlated ? correlated_signal(120) : independent_signal(120);
+
+        auto result = uncertainties::exponential_smoothing(xs, alpha);
+
+        udouble y = xs[0];
+        for (std::size_t k = 0; k < xs.size(); ++k) {
+            if (k > 0) {
+                y = alpha * xs[k] + (1.0 - alpha) * y;
+            }
+            EXPECT_NEAR(result.nominal()[k], y.nominal_value(), 1e-12);
+            EXPECT_NEAR(result.stddev()[k], y.stddev(), 1e-12);
+        }
+        EXPECT_NEAR((result.value(119) - y).stddev(), 0.0, 1e-12);
+    }
+}
+
+TEST_F(FilterTest, ExponentialSmoothingBandIsTruncated) {
+    auto xs = independent_signal(500);
+    auto result = uncertainties::exponential_smoothing(xs, 0.5);
+
+    EXPECT_EQ(result.band_end(400), 401u);
+    EXPECT_GT(result.band_begin(400), 300u);
+    EXPECT_DOUBLE_EQ(result.coefficient(3, 0), 0.125);
+    EXPECT_DOUBLE_EQ(result.coefficient(3, 2), 0.25);
+    EXPECT_DOUBLE_EQ(result.coefficient(3, 4), 0.0);
+}
+
+TEST_F(FilterTest, InvalidArguments) {
+    auto xs = independent_signal(5);
+    EXPECT_THROW(uncertainties::convolve(xs, {}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::moving_average(xs, 0), std::invalid_argument);
+    EXPECT_THROW(uncertainties::exponential_smoothing(xs, 0.0), std::invalid_argument);
+    EXPECT_THROW(uncertainties::exponential_smoothing(xs, 1.5), std::invalid_argument);
+    EXPECT_EQ(uncertainties::moving_average(xs, 6).size(), 0u);
+    EXPECT_THROW(uncertainties::moving_average(xs, 6).value(0), std::out_of_range);
+}
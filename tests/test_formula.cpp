@@ -0,0 +1,443 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "uncertainties/formula.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::Formula;
+using uncertainties::FormulaInput;
+using uncertainties::FormulaAdjoints;
+using uncertainties::FormulaOptions;
+using uncertainties::FormulaReverseOptions;
+using uncertainties::FormulaTangents;
+using uncertainties::FormulaVar;
+
+class FormulaTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // Written once, used with both udouble and FormulaVar
+    template <typename T>
+    static T model(const T& x, const T& y, const T& gain) {
+        using namespace uncertainties;
+        return gain * sin(x) * exp(y / 4.0) + sqrt(x * x + 1.0) - 2.0 / (1.0 + y * y);
+    }
+
+    static Formula model_formula() {
+        return Formula::record(3, [](const std::vector<FormulaVar>& in) {
+            return model(in[0], in[1], in[2]);
+        });
+    }
+};
+
+// Recording
+
+TEST_F(FormulaTest, RecordsInputsAndOutputs) {
+    Formula f = model_formula();
+    EXPECT_EQ(f.num_inputs(), 3u);
+    EXPECT_EQ(f.num_outputs(), 1u);
+    EXPECT_GT(f.size(), 0u);
+    EXPECT_LT(f.num_registers(), f.size());
+}
+
+TEST_F(FormulaTest, ConstantsAreFoldedWhileRecording) {
+    Formula f = Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        FormulaVar two = FormulaVar(1.0) + 1.0;
+        EXPECT_TRUE(two.is_constant());
+        EXPECT_DOUBLE_EQ(uncertainties::exp(FormulaVar(0.0)).constant_value(), 1.0);
+        return in[0] * two;
+    });
+    // Input and one scaled multiply
+    EXPECT_EQ(f.size(), 2u);
+}
+
+TEST_F(FormulaTest, UnusedInputsAreDropped) {
+    Formula f = Formula::record(3, [](const std::vector<FormulaVar>& in) {
+        return in[1] * 2.0;
+    });
+    EXPECT_EQ(f.size(), 2u);
+    EXPECT_EQ(f.num_registers(), 2u);
+}
+
+TEST_F(FormulaTest, ConstantDomainErrorsThrowWhileRecording) {
+    EXPECT_THROW(Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        return in[0] + uncertainties::log(FormulaVar(-1.0));
+    }), std::invalid_argument);
+    EXPECT_THROW(Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        return in[0] / 0.0;
+    }), std::runtime_error);
+}
+
+// Common subexpressions and constant folding
+
+TEST_F(FormulaTest, RepeatedSubexpressionsAreShared) {
+    auto expr = [](const auto& x) {
+        using namespace uncertainties;
+        return sin(x) * sin(x) + cos(x) * sin(x);
+    };
+    Formula f = Formula::record(1, [&](const std::vector<FormulaVar>& in) {
+        return expr(in[0]);
+    });
+    // Input, sin, sin*sin, cos, cos*sin, add
+    EXPECT_EQ(f.size(), 6u);
+
+    udouble x(0.4, 0.03);
+    udouble expected = expr(x);
+    udouble actual = f.apply({x})[0];
+    EXPECT_NEAR(actual.nominal_value(), expected.nominal_value(), 1e-14);
+    EXPECT_NEAR(actual.stddev(), expected.stddev(), 1e-14);
+}
+
+TEST_F(FormulaTest, CommutativeOperandsAreShared) {
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return in[0] * in[1] - in[1] * in[0] + uncertainties::hypot(in[0], in[1]) /
+               uncertainties::hypot(in[1], in[0]);
+    });
+    // 2 inputs, mul, sub, hypot, div, add
+    EXPECT_EQ(f.size(), 7u);
+}
+
+TEST_F(FormulaTest, ExactIdentitiesAreRemoved) {
+    Formula f = Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        FormulaVar x = in[0];
+        FormulaVar one = uncertainties::exp(FormulaVar(0.0));
+        return -(-(x * one + 0.0)) / 1.0 + x * -1.0 - (-x);
+    });
+    // Input, neg, add, sub
+    EXPECT_EQ(f.size(), 4u);
+
+    udouble x(2.0, 0.1);
+    udouble actual = f.apply({x})[0];
+    EXPECT_DOUBLE_EQ(actual.nominal_value(), 2.0);
+    EXPECT_NEAR(actual.stddev(), 0.1, 1e-14);
+}
+
+TEST_F(FormulaTest, ConstantSubtreesAreFolded) {
+    Formula f = Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        using namespace uncertainties;
+        FormulaVar c = sqrt(FormulaVar(2.0)) * atan2(FormulaVar(1.0), FormulaVar(1.0)) + pow(FormulaVar(2.0), 3.0);
+        return in[0] * c + c;
+    });
+    // Input, scaled multiply, add constant
+    EXPECT_EQ(f.size(), 3u);
+
+    const double c = std::sqrt(2.0) * std::atan2(1.0, 1.0) + 8.0;
+    udouble actual = f.apply({udouble(1.0, 0.5)})[0];
+    EXPECT_NEAR(actual.nominal_value(), 2.0 * c, 1e-12);
+    EXPECT_NEAR(actual.stddev(), 0.5 * c, 1e-12);
+}
+
+// Single evaluation on udouble arguments
+
+TEST_F(FormulaTest, ApplyMatchesUdouble) {
+    udouble x(0.7, 0.01);
+    udouble y(1.3, 0.02);
+    udouble gain(2.0, 0.05);
+    udouble expected = model(x, y, gain);
+
+    std::vector<udouble> actual = model_formula().apply({x, y, gain});
+
+    ASSERT_EQ(actual.size(), 1u);
+    EXPECT_NEAR(actual[0].nominal_value(), expected.nominal_value(), 1e-12);
+    EXPECT_NEAR(actual[0].stddev(), expected.stddev(), 1e-12);
+    // Correlated with the arguments
+    EXPECT_NEAR((actual[0] - expected).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(FormulaTest, ScalarDivisionMatchesUdoubleExactly) {
+    const double divisors[] = {3.0, 49.0, 1e-310};
+    const double numerators[] = {7.0, 0.1, 1e-5};
+    for (std::size_t k = 0; k < 3; ++k) {
+        const double c = divisors[k];
+        Formula f = Formula::record(1, [c](const std::vector<FormulaVar>& in) {
+            return in[0] / c;
+        });
+        udouble x(numerators[k], 0.01);
+        udouble expected = x / c;
+
+        udouble actual = f.apply({x})[0];
+        EXPECT_EQ(actual.nominal_value(), expected.nominal_value()) << numerators[k] << " / " << c;
+        EXPECT_EQ(actual.stddev(), expected.stddev()) << numerators[k] << " / " << c;
+
+        auto result = f.evaluate({FormulaInput::column(std::vector<double>{numerators[k]},
+                                                       std::vector<double>{0.01})}, 1);
+        EXPECT_EQ(result.nominal()[0], expected.nominal_value()) << numerators[k] << " / " << c;
+    }
+}
+
+TEST_F(FormulaTest, MultipleOutputs) {
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return std::vector<FormulaVar>{in[0] + in[1], in[0] - in[1], FormulaVar(3.0)};
+    });
+    udouble x(1.0, 0.1);
+    udouble y(2.0, 0.2);
+
+    auto out = f.apply({x, y});
+
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_NEAR(out[0].nominal_value(), 3.0, 1e-12);
+    EXPECT_NEAR(out[1].nominal_value(), -1.0, 1e-12);
+    EXPECT_NEAR(out[2].nominal_value(), 3.0, 1e-12);
+    EXPECT_NEAR(out[2].stddev(), 0.0, 1e-12);
+    EXPECT_NEAR((out[0] + out[1] - 2.0 * x).stddev(), 0.0, 1e-12);
+}
+
+// Columnar evaluation
+
+TEST_F(FormulaTest, ColumnsMatchRowByRowUdouble) {
+    const std::size_t rows = 1000;
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(0.1, 2.0);
+    std::vector<double> xn(rows), xs(rows), yn(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        xn[i] = uniform(rng);
+        xs[i] = 0.01 * uniform(rng);
+        yn[i] = uniform(rng);
+    }
+    udouble gain(1.5, 0.02);
+
+    FormulaOptions options;
+    options.block_size = 64;
+    options.threads = 3;
+    auto result = model_formula().evaluate(
+        {FormulaInput::column(xn, xs), FormulaInput::column(yn), FormulaInput::parameter(gain)},
+        rows, options);
+
+    ASSERT_EQ(result.rows(), rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        udouble x(xn[i], xs[i]);
+        udouble expected = model(x, udouble(yn[i]), gain);
+        EXPECT_NEAR(result.nominal()[i], expected.nominal_value(), 1e-12);
+        EXPECT_NEAR(result.stddev()[i], expected.stddev(), 1e-12);
+    }
+}
+
+TEST_F(FormulaTest, ValuesAreCorrelatedThroughParameters) {
+    std::vector<double> xn = {1.0, 2.0, 3.0};
+    std::vector<double> xs = {0.1, 0.1, 0.1};
+    udouble gain(2.0, 0.3);
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return in[0] * in[1];
+    });
+
+    auto result = f.evaluate({FormulaInput::column(xn, xs), FormulaInput::parameter(gain)}, 3);
+    std::vector<udouble> values = result.values();
+
+    ASSERT_EQ(values.size(), 3u);
+    EXPECT_NEAR(values[1].stddev(), result.stddev()[1], 1e-12);
+    // Rows share the gain: row1 - 2*row0 only keeps the row uncertainties
+    udouble diff = values[1] - 2.0 * values[0];
+    EXPECT_NEAR(diff.stddev(), std::sqrt(std::pow(2.0 * 0.1, 2) + std::pow(4.0 * 0.1, 2)), 1e-12);
+    // Re-materializing a row gives the same atomics
+    EXPECT_NEAR((result.value(2) - values[2]).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(FormulaTest, DerivativeColumns) {
+    std::vector<double> xn = {1.0, 2.0};
+    std::vector<double> yn = {3.0, 5.0};
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return in[0] * in[1] + in[0];
+    });
+
+    auto result = f.evaluate({FormulaInput::column(xn), FormulaInput::column(yn)}, 2);
+
+    EXPECT_DOUBLE_EQ(result.derivative(0, 0)[1], 6.0);
+    EXPECT_DOUBLE_EQ(result.derivative(0, 1)[1], 2.0);
+    EXPECT_DOUBLE_EQ(result.stddev()[0], 0.0);
+}
+
+TEST_F(FormulaTest, WithoutDerivativesKeepsStddev) {
+    std::vector<double> xn = {4.0};
+    std::vector<double> xs = {0.4};
+    Formula f = Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        return uncertainties::sqrt(in[0]);
+    });
+    FormulaOptions options;
+    options.keep_derivatives = false;
+
+    auto result = f.evaluate({FormulaInput::column(xn, xs)}, 1, options);
+
+    EXPECT_NEAR(result.stddev()[0], 0.1, 1e-12);
+    EXPECT_THROW(result.derivative(0, 0), std::runtime_error);
+    EXPECT_THROW(result.values(), std::runtime_error);
+}
+
+TEST_F(FormulaTest, DomainErrorsReportTheRow) {
+    std::vector<double> xn = {1.0, 2.0, -1.0, 4.0};
+    Formula f = Formula::record(1, [](const std::vector<FormulaVar>& in) {
+        return uncertainties::log(in[0]);
+    });
+    try {
+        f.evaluate({FormulaInput::column(xn)}, xn.size());
+        FAIL() << "expected std::invalid_argument";
+    } catch (const std::invalid_argument& e) {
+        EXPECT_NE(std::string(e.what()).find("row 2"), std::string::npos);
+    }
+}
+
+TEST_F(FormulaTest, InputValidation) {
+    Formula f = model_formula();
+    std::vector<double> short_column(2);
+    EXPECT_THROW(f.evaluate({FormulaInput::column(short_column)}, 2), std::invalid_argument);
+    EXPECT_THROW(f.evaluate({FormulaInput::column(short_column), FormulaInput::column(short_column),
+                             FormulaInput::column(short_column)}, 5),
+                 std::invalid_argument);
+    EXPECT_THROW(FormulaInput::column(std::vector<double>(3), std::vector<double>(2)),
+                 std::invalid_argument);
+}
+
+TEST_F(FormulaTest, EmptyEvaluation) {
+    std::vector<double> empty;
+    auto result = model_formula().evaluate(
+        {FormulaInput::column(empty), FormulaInput::column(empty), FormulaInput::parameter(1.0)}, 0);
+    EXPECT_EQ(result.rows(), 0u);
+    EXPECT_TRUE(result.nominal().empty());
+    EXPECT_TRUE(result.values().empty());
+}
+
+// Directional derivatives at single points
+
+TEST_F(FormulaTest, TangentsAlongSeedDirections) {
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return std::vector<FormulaVar>{in[0] * in[1], uncertainties::sin(in[0]) + in[1]};
+    });
+    FormulaTangents tangents(f, 2);
+    const double x[] = {0.5, 3.0};
+    // Lane 0 along (1, 2), lane 1 along (0, 1)
+    const double seeds[] = {1.0, 0.0,
+                            2.0, 1.0};
+    double y[2];
+    double dy[4];
+
+    tangents.evaluate(x, seeds, y, dy);
+
+    EXPECT_DOUBLE_EQ(y[0], 1.5);
+    EXPECT_DOUBLE_EQ(dy[0], 3.0 + 2.0 * 0.5);
+    EXPECT_DOUBLE_EQ(dy[1], 0.5);
+    EXPECT_DOUBLE_EQ(dy[2], std::cos(0.5) + 2.0);
+    EXPECT_DOUBLE_EQ(dy[3], 1.0);
+
+    // Registers are reused between points
+    const double x2[] = {1.0, -1.0};
+    tangents.evaluate(x2, seeds, y, dy);
+    EXPECT_DOUBLE_EQ(y[0], -1.0);
+    EXPECT_DOUBLE_EQ(dy[0], -1.0 + 2.0);
+}
+
+// Reverse mode
+
+namespace {
+    // Many inputs, a few outputs, every binary operation kind
+    Formula wide_formula(std::size_t n) {
+        return Formula::record(n, [n](const std::vector<FormulaVar>& in) {
+            using namespace uncertainties;
+            FormulaVar sum = 0.0;
+            FormulaVar prod = 1.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += sin(in[i]) * in[(i + 1) % n];
+                prod *= 1.0 + in[i] * in[i] / 10.0;
+            }
+            return std::vector<FormulaVar>{sum / prod, atan2(in[0], in[1]) + hypot(in[2], in[3]),
+                                           pow(prod, in[4]) - exp(sum / 8.0), in[5]};
+        });
+    }
+
+    // Forward-mode Jacobian, row-major outputs × inputs
+    std::vector<double> forward_jacobian(const Formula& f, const std::vector<double>& x) {
+        const std::size_t n = f.num_inputs();
+        FormulaTangents tangents(f, n);
+        std::vector<double> seeds(n * n, 0.0);
+        for (std::size_t i = 0; i < n; ++i) {
+            seeds[i * n + i] = 1.0;
+        }
+        std::vector<double> y(f.num_outputs());
+        std::vector<double> J(f.num_outputs() * n);
+        tangents.evaluate(x.data(), seeds.data(), y.data(), J.data());
+        return J;
+    }
+}
+
+TEST_F(FormulaTest, AdjointsPullBackWeightedOutputs) {
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return std::vector<FormulaVar>{in[0] * in[1], uncertainties::sin(in[0]) + in[1]};
+    });
+    FormulaAdjoints adjoints(f, 2);
+    const double x[] = {0.5, 3.0};
+    // Lane 0 weights (1, 2), lane 1 weights (0, 1)
+    const double weights[] = {1.0, 0.0,
+                              2.0, 1.0};
+    double y[2];
+    double g[4];
+
+    adjoints.evaluate(x, weights, y, g);
+
+    EXPECT_DOUBLE_EQ(y[0], 1.5);
+    EXPECT_DOUBLE_EQ(y[1], std::sin(0.5) + 3.0);
+    EXPECT_DOUBLE_EQ(g[0], 3.0 + 2.0 * std::cos(0.5));
+    EXPECT_DOUBLE_EQ(g[1], std::cos(0.5));
+    EXPECT_DOUBLE_EQ(g[2], 0.5 + 2.0);
+    EXPECT_DOUBLE_EQ(g[3], 1.0);
+}
+
+TEST_F(FormulaTest, JacobianMatchesForwardMode) {
+    const std::size_t n = 12;
+    Formula f = wide_formula(n);
+    std::vector<double> x(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = 0.3 + 0.1 * static_cast<double>(i);
+    }
+    std::vector<double> expected = forward_jacobian(f, x);
+
+    for (std::size_t checkpoints : {0, 1, 3, 64}) {
+        for (std::size_t lanes : {1, 16}) {
+            FormulaReverseOptions options;
+            options.checkpoints = checkpoints;
+            options.lanes = lanes;
+            options.threads = 3;
+            std::vector<double> J = f.jacobian(x, options);
+            ASSERT_EQ(J.size(), expected.size());
+            for (std::size_t k = 0; k < J.size(); ++k) {
+                EXPECT_NEAR(J[k], expected[k], 1e-12 * (1.0 + std::abs(expected[k])))
+                    << "checkpoints " << checkpoints << ", lanes " << lanes << ", entry " << k;
+            }
+        }
+    }
+    EXPECT_THROW(f.jacobian({1.0}), std::invalid_argument);
+}
+
+TEST_F(FormulaTest, CheckpointedSweepOfLongProgram) {
+    // Long chain whose registers are reused throughout
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        FormulaVar u = in[0];
+        for (int step = 0; step < 400; ++step) {
+            u = uncertainties::sin(u) * 0.9 + 0.1 * in[1] * u;
+        }
+        return u;
+    });
+    ASSERT_GT(f.size(), 1000u);
+    const double x[] = {0.7, 1.3};
+    const double weight = 1.0;
+    double taped[2];
+    double checkpointed[2];
+    double y_taped;
+    double y_checkpointed;
+
+    FormulaAdjoints full(f, 1);
+    full.evaluate(x, &weight, &y_taped, taped);
+    FormulaReverseOptions options;
+    options.checkpoints = 5;
+    FormulaAdjoints bounded(f, 1, options);
+    bounded.evaluate(x, &weight, &y_checkpointed, checkpointed);
+
+    EXPECT_EQ(y_checkpointed, y_taped);
+    EXPECT_EQ(checkpointed[0], taped[0]);
+    EXPECT_EQ(checkpointed[1], taped[1]);
+    std::vector<double> forward = forward_jacobian(f, {0.7, 1.3});
+    EXPECT_NEAR(taped[0], forward[0], 1e-12);
+    EXPECT_NEAR(taped[1], forward[1], 1e-12);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "uncertainties/integrate.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::IntegrationOptions;
+using uncertainties::SampleRule;
+
+class IntegrateTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+};
+
+// Sampled data
+
+TEST_F(IntegrateTest, TrapezoidWeights) {
+    std::vector<double> x = {0.0, 1.0, 3.0, 3.5};
+    auto w = uncertainties::integration_weights(x);
+    ASSERT_EQ(w.size(), 4u);
+    EXPECT_DOUBLE_EQ(w[0], 0.5);
+    EXPECT_DOUBLE_EQ(w[1], 1.5);
+    EXPECT_DOUBLE_EQ(w[2], 1.25);
+    EXPECT_DOUBLE_EQ(w[3], 0.25);
+}
+
+TEST_F(IntegrateTest, SimpsonIsExactForQuadraticsOnUnevenGrids) {
+    auto quadratic = [](double x) { return 3.0 * x * x - 2.0 * x + 1.0; };
+    auto antiderivative = [](double x) { return x * x * x - x * x + x; };
+    // Even and odd numbers of intervals
+    for (std::vector<double> x : {std::vector<double>{0.0, 0.3, 1.0, 1.2, 2.0},
+                                  std::vector<double>{0.0, 0.3, 1.0, 1.2, 2.0, 2.7}}) {
+        auto w = uncertainties::integration_weights(x, SampleRule::Simpson);
+        double sum = 0.0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            sum += w[i] * quadratic(x[i]);
+        }
+        EXPECT_NEAR(sum, antiderivative(x.back()) - antiderivative(x.front()), 1e-12);
+    }
+}
+
+TEST_F(IntegrateTest, SamplesMatchUdoubleSum) {
+    udouble gain(1.1, 0.05);
+    std::vector<double> x;
+    std::vector<udouble> y;
+    for (int i = 0; i <= 20; ++i) {
+        x.push_back(0.25 * i);
+        y.push_back(gain * udouble(std::sin(0.25 * i) + 2.0, 0.1));
+    }
+
+    udouble expected(0.0);
+    for (std::size_t i = 0; i + 1 < x.size(); ++i) {
+        expected += 0.5 * (x[i + 1] - x[i]) * (y[i] + y[i + 1]);
+    }
+    udouble actual = uncertainties::integrate_samples(x, y);
+
+    EXPECT_NEAR(actual.nominal_value(), expected.nominal_value(), 1e-12);
+    EXPECT_NEAR(actual.stddev(), expected.stddev(), 1e-12);
+    EXPECT_NEAR((actual - expected).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(IntegrateTest, InvalidSamples) {
+    EXPECT_THROW(uncertainties::integration_weights({1.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::integration_weights({0.0, 2.0, 1.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::integrate_samples({0.0, 1.0}, {udouble(1.0)}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::weighted_sum({1.0}, {}), std::invalid_argument);
+}
+
+// Integrands with uncertain parameters
+
+TEST_F(IntegrateTest, GaussLegendreIsExactForPolynomials) {
+    std::vector<double> nodes, weights;
+    uncertainties::detail::gauss_legendre(5, nodes, weights);
+    double integral = 0.0;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        integral += weights[i] * std::pow(nodes[i], 8);
+    }
+    EXPECT_NEAR(integral, 2.0 / 9.0, 1e-15);
+    EXPECT_LT(nodes.front(), nodes.back());
+}
+
+TEST_F(IntegrateTest, ParametersPropagateThroughQuadrature) {
+    udouble k(2.0, 0.1);
+    udouble tau(5.0, 0.2);
+
+    udouble actual = uncertainties::integrate(
+        [&](double t) { return k * uncertainties::exp(-t / tau); }, 0.0, 10.0);
+    udouble expected = k * tau * (1.0 - uncertainties::exp(-10.0 / tau));
+
+    EXPECT_NEAR(actual.nominal_value(), expected.nominal_value(), 1e-12);
+    EXPECT_NEAR(actual.stddev(), expected.stddev(), 1e-12);
+    EXPECT_NEAR((actual - expected).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(IntegrateTest, UncertainLimits) {
+    udouble slope(3.0, 0.1);
+    udouble a(1.0, 0.05);
+    udouble b(2.0, 0.02);
+
+    udouble actual = uncertainties::integrate([&](double t) { return slope * t; }, a, b);
+    udouble expected = slope * (b * b - a * a) / 2.0;
+
+    EXPECT_NEAR(actual.nominal_value(), expected.nominal_value(), 1e-12);
+    EXPECT_NEAR((actual - expected).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(IntegrateTest, ResultDoesNotDependOnThreadCount) {
+    udouble w(1.3, 0.1);
+    auto f = [&](double t) { return uncertainties::sin(w * t) / (1.0 + t); };
+    IntegrationOptions one;
+    one.panels = 32;
+    one.threads = 1;
+    IntegrationOptions many = one;
+    many.threads = 4;
+
+    udouble a = uncertainties::integrate(f, 0.0, 6.0, one);
+    udouble b = uncertainties::integrate(f, 0.0, 6.0, many);
+
+    EXPECT_EQ(a.nominal_value(), b.nominal_value());
+    EXPECT_EQ(a.stddev(), b.stddev());
+}
+
+TEST_F(IntegrateTest, ExactIntegrandAndReversedLimits) {
+    double forward = uncertainties::integrate([](double t) { return udouble(t * t); }, 0.0, 3.0)
+                         .nominal_value();
+    double backward = uncertainties::integrate([](double t) { return udouble(t * t); }, 3.0, 0.0)
+                          .nominal_value();
+    EXPECT_NEAR(forward, 9.0, 1e-12);
+    EXPECT_NEAR(backward, -9.0, 1e-12);
+
+    IntegrationOptions none;
+    none.panels = 0;
+    EXPECT_THROW(uncertainties::integrate([](double t) { return udouble(t); }, 0.0, 1.0, none),
+                 std::invalid_argument);
+}
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <Eigen/Dense>
+#include "uncertainties/linalg.hpp"
+
+using uncertainties::udouble;
+
+using MatrixXu = Eigen::Matrix<udouble, Eigen::Dynamic, Eigen::Dynamic>;
+
+class LinalgTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // Symmetric matrix sharing one atomic between (i, j) and (j, i)
+    static MatrixXu random_symmetric(int n) {
+        MatrixXu A(n, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j <= i; ++j) {
+                A(i, j) = udouble(std::sin(1.0 + i * 3 + j * 7) + (i == j ? n : 0), 0.01 * (1 + i + j));
+                A(j, i) = A(i, j);
+            }
+        }
+        return A;
+    }
+};
+
+TEST_F(LinalgTest, TwoByTwoEigenvaluesMatchClosedForm) {
+    udouble a(2.0, 0.1);
+    udouble b(0.7, 0.05);
+    udouble c(3.0, 0.2);
+    MatrixXu A(2, 2);
+    A << a, b,
+         b, c;
+
+    auto lambda = uncertainties::eigenvalues(A);
+
+    udouble mean = (a + c) / 2.0;
+    udouble half_gap = (a - c) / 2.0;
+    udouble radius = sqrt(half_gap * half_gap + b * b);
+    udouble low = mean - radius;
+    udouble high = mean + radius;
+    ASSERT_EQ(lambda.size(), 2);
+    EXPECT_NEAR(lambda(0).nominal_value(), low.nominal_value(), 1e-13);
+    EXPECT_NEAR(lambda(1).nominal_value(), high.nominal_value(), 1e-13);
+    EXPECT_NEAR((lambda(0) - low).stddev(), 0.0, 1e-13);
+    EXPECT_NEAR((lambda(1) - high).stddev(), 0.0, 1e-13);
+    EXPECT_NEAR(lambda(1).stddev(), high.stddev(), 1e-13);
+}
+
+TEST_F(LinalgTest, EigenvaluesPreserveTraceAndEigenvectors) {
+    MatrixXu A = random_symmetric(5);
+
+    auto eig = uncertainties::symmetric_eigen(A);
+
+    // Σ λ = tr A holds exactly, so it holds for the derivatives too
+    EXPECT_NEAR((eig.eigenvalues.sum() - A.trace()).stddev(), 0.0, 1e-13);
+    for (int k = 0; k < 5; ++k) {
+        Eigen::VectorXd v = eig.eigenvectors.col(k);
+        Eigen::VectorXd Av = uncertainties::detail::nominal_matrix(A) * v;
+        EXPECT_NEAR((Av - eig.eigenvalues(k).nominal_value() * v).norm(), 0.0, 1e-12);
+        EXPECT_GT(eig.eigenvalues(k).stddev(), 0.0);
+    }
+}
+
+TEST_F(LinalgTest, EigenvaluesMatchFiniteDifferences) {
+    const int n = 4;
+    MatrixXu A = random_symmetric(n);
+    auto lambda = uncertainties::eigenvalues(A);
+
+    // Perturb the (2, 1) atomic, which appears twice
+    const double h = 1e-6;
+    Eigen::MatrixXd N = uncertainties::detail::nominal_matrix(A);
+    Eigen::MatrixXd plus = N, minus = N;
+    plus(2, 1) += h;
+    plus(1, 2) += h;
+    minus(2, 1) -= h;
+    minus(1, 2) -= h;
+    Eigen::VectorXd lp = Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>(plus).eigenvalues();
+    Eigen::VectorXd lm = Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>(minus).eigenvalues();
+
+    uint64_t id = A(2, 1).derivatives().begin()->first;
+    for (int k = 0; k < n; ++k) {
+        double fd = (lp(k) - lm(k)) / (2 * h);
+        EXPECT_NEAR(lambda(k).derivatives().at(id), fd, 1e-7);
+    }
+}
+
+TEST_F(LinalgTest, SingularValuesOfRectangularMatrix) {
+    MatrixXu A(3, 2);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            A(i, j) = udouble(1.0 + i - 2.0 * j + 0.3 * i * j, 0.05);
+        }
+    }
+
+    auto result = uncertainties::svd(A);
+
+    ASSERT_EQ(result.singular_values.size(), 2);
+    EXPECT_GE(result.singular_values(0).nominal_value(), result.singular_values(1).nominal_value());
+    // Σ σ² = ‖A‖_F² holds exactly
+    udouble sigma_sq = result.singular_values(0) * result.singular_values(0) +
+                       result.singular_values(1) * result.singular_values(1);
+    udouble frobenius_sq(0.0);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            frobenius_sq += A(i, j) * A(i, j);
+        }
+    }
+    EXPECT_NEAR(sigma_sq.nominal_value(), frobenius_sq.nominal_value(), 1e-12);
+    EXPECT_NEAR((sigma_sq - frobenius_sq).stddev(), 0.0, 1e-12);
+    EXPECT_EQ(result.U.rows(), 3);
+    EXPECT_EQ(result.V.rows(), 2);
+}
+
+TEST_F(LinalgTest, SingularValuesOfDiagonalMatrixAreAbsoluteValues) {
+    udouble d0(-3.0, 0.2);
+    udouble d1(1.5, 0.1);
+    MatrixXu A(2, 2);
+    A << d0, udouble(0.0),
+         udouble(0.0), d1;
+
+    auto sigma = uncertainties::singular_values(A);
+
+    EXPECT_NEAR(sigma(0).nominal_value(), 3.0, 1e-14);
+    EXPECT_NEAR((sigma(0) + d0).stddev(), 0.0, 1e-14);
+    EXPECT_NEAR(sigma(1).nominal_value(), 1.5, 1e-14);
+    EXPECT_NEAR((sigma(1) - d1).stddev(), 0.0, 1e-14);
+}
+
+TEST_F(LinalgTest, InvalidArguments) {
+    MatrixXu rectangular(2, 3);
+    rectangular.setConstant(udouble(1.0));
+    EXPECT_THROW(uncertainties::eigenvalues(rectangular), std::invalid_argument);
+
+    MatrixXu skew(2, 2);
+    skew << udouble(1.0), udouble(2.0),
+            udouble(-2.0), udouble(1.0);
+    EXPECT_THROW(uncertainties::eigenvalues(skew), std::invalid_argument);
+}
+
+TEST_F(LinalgTest, CholeskyReconstructsMatrix) {
+    const int n = 4;
+    MatrixXu B(n, n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            B(i, j) = udouble(std::cos(1.0 + 2 * i + 5 * j), 0.02);
+        }
+    }
+    MatrixXu A = B * B.transpose();
+    for (int i = 0; i < n; ++i) {
+        A(i, i) += udouble(1.0, 0.01);
+    }
+
+    MatrixXu L = uncertainties::cholesky(A);
+    MatrixXu rebuilt = L * L.transpose();
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            EXPECT_NEAR(rebuilt(i, j).nominal_value(), A(i, j).nominal_value(), 1e-12);
+            EXPECT_NEAR((rebuilt(i, j) - A(i, j)).stddev(), 0.0, 1e-12);
+            if (j > i) {
+                EXPECT_EQ(L(i, j).nominal_value(), 0.0);
+                EXPECT_EQ(L(i, j).stddev(), 0.0);
+            }
+        }
+        EXPECT_GT(L(i, i).nominal_value(), 0.0);
+    }
+}
+
+TEST_F(LinalgTest, CholeskyOfTwoByTwoMatchesClosedForm) {
+    udouble a(4.0, 0.2);
+    udouble b(1.0, 0.1);
+    udouble c(3.0, 0.3);
+    MatrixXu A(2, 2);
+    // The upper triangle is not read
+    A << a, udouble(99.0, 5.0),
+         b, c;
+
+    MatrixXu L = uncertainties::cholesky(A);
+
+    udouble l00 = sqrt(a);
+    udouble l10 = b / l00;
+    udouble l11 = sqrt(c - l10 * l10);
+    EXPECT_NEAR((L(0, 0) - l00).stddev(), 0.0, 1e-14);
+    EXPECT_NEAR((L(1, 0) - l10).stddev(), 0.0, 1e-14);
+    EXPECT_NEAR(L(1, 1).nominal_value(), l11.nominal_value(), 1e-14);
+    EXPECT_NEAR((L(1, 1) - l11).stddev(), 0.0, 1e-14);
+}
+
+TEST_F(LinalgTest, QrReconstructsMatrixWithOrthonormalQ) {
+    const int rows = 5;
+    const int cols = 3;
+    MatrixXu A(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            A(i, j) = udouble(std::sin(0.5 + 3 * i - j) + (i == j ? 2.0 : 0.0), 0.01 * (1 + j));
+        }
+    }
+
+    auto [Q, R] = uncertainties::qr(A);
+    ASSERT_EQ(Q.rows(), rows);
+    ASSERT_EQ(Q.cols(), cols);
+    ASSERT_EQ(R.rows(), cols);
+
+    MatrixXu rebuilt = Q * R;
+    MatrixXu gram = Q.transpose() * Q;
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            EXPECT_NEAR(rebuilt(i, j).nominal_value(), A(i, j).nominal_value(), 1e-12);
+            EXPECT_NEAR((rebuilt(i, j) - A(i, j)).stddev(), 0.0, 1e-12);
+        }
+    }
+    for (int i = 0; i < cols; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            EXPECT_NEAR(gram(i, j).nominal_value(), i == j ? 1.0 : 0.0, 1e-12);
+            EXPECT_NEAR(gram(i, j).stddev(), 0.0, 1e-12);
+            if (i > j) {
+                EXPECT_EQ(R(i, j).stddev(), 0.0);
+            }
+        }
+        EXPECT_GT(R(i, i).nominal_value(), 0.0);
+    }
+}
+
+TEST_F(LinalgTest, QrOfSingleColumnNormalizes) {
+    udouble x(3.0, 0.1);
+    udouble y(-4.0, 0.2);
+    MatrixXu A(2, 1);
+    A << x, y;
+
+    auto result = uncertainties::qr(A);
+
+    udouble norm = sqrt(x * x + y * y);
+    EXPECT_NEAR(result.R(0, 0).nominal_value(), 5.0, 1e-14);
+    EXPECT_NEAR((result.R(0, 0) - norm).stddev(), 0.0, 1e-14);
+    EXPECT_NEAR((result.Q(1, 0) - y / norm).stddev(), 0.0, 1e-14);
+}
+
+TEST_F(LinalgTest, FactorizationErrors) {
+    MatrixXu indefinite(2, 2);
+    indefinite << udouble(1.0), udouble(2.0),
+                  udouble(2.0), udouble(1.0);
+    EXPECT_THROW(uncertainties::cholesky(indefinite), std::runtime_error);
+    EXPECT_THROW(uncertainties::cholesky(MatrixXu(2, 3)), std::invalid_argument);
+
+    MatrixXu wide(2, 3);
+    wide.setConstant(udouble(1.0));
+    EXPECT_THROW(uncertainties::qr(wide), std::invalid_argument);
+    MatrixXu rank_one(3, 2);
+    rank_one.setConstant(udouble(1.0, 0.1));
+    EXPECT_THROW(uncertainties::qr(rank_one), std::runtime_error);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <Eigen/Dense>
+#include <unsupported/Eigen/MatrixFunctions>
+#include "uncertainties/matrix_functions.hpp"
+
+using uncertainties::udouble;
+using uncertainties::MatrixXu;
+using uncertainties::MatrixFunctionOptions;
+
+class MatrixFunctionsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // Non-normal matrix with positive real spectrum shifted by `shift`
+    static MatrixXu test_matrix(int n, double shift, double sigma) {
+        MatrixXu A(n, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                double nominal = 0.3 * std::sin(1.0 + 3 * i + 7 * j) + (i == j ? shift : 0.0);
+                A(i, j) = udouble(nominal, sigma);
+            }
+        }
+        return A;
+    }
+
+    static void expect_linked(const MatrixXu& actual, const MatrixXu& expected, double tol) {
+        for (Eigen::Index i = 0; i < actual.rows(); ++i) {
+            for (Eigen::Index j = 0; j < actual.cols(); ++j) {
+                EXPECT_NEAR(actual(i, j).nominal_value(), expected(i, j).nominal_value(), tol);
+                EXPECT_NEAR((actual(i, j) - expected(i, j)).stddev(), 0.0, tol);
+            }
+        }
+    }
+
+    // Central differences of f along ∂A/∂id of one entry's atomic
+    template <typename F>
+    static void expect_matches_finite_differences(const MatrixXu& A, const MatrixXu& result, F&& f,
+                                                  Eigen::Index row, Eigen::Index col, double tol) {
+        const double h = 1e-6;
+        Eigen::MatrixXd N = uncertainties::detail::nominal_matrix(A);
+        Eigen::MatrixXd plus = N, minus = N;
+        plus(row, col) += h;
+        minus(row, col) -= h;
+        Eigen::MatrixXd fd = (f(plus) - f(minus)) / (2 * h);
+        // The entry is `chain` times its atomic
+        auto [id, chain] = *A(row, col).derivatives().begin();
+        for (Eigen::Index i = 0; i < A.rows(); ++i) {
+            for (Eigen::Index j = 0; j < A.cols(); ++j) {
+                const auto& derivatives = result(i, j).derivatives();
+                auto it = derivatives.find(id);
+                double d = it == derivatives.end() ? 0.0 : it->second;
+                EXPECT_NEAR(d, chain * fd(i, j), tol);
+            }
+        }
+    }
+};
+
+TEST_F(MatrixFunctionsTest, ExpmMatchesEigenAndFiniteDifferences) {
+    // Large enough norm to need squarings
+    MatrixXu A = test_matrix(4, 0.0, 0.01) * udouble(20.0);
+
+    MatrixXu E = uncertainties::expm(A);
+
+    Eigen::MatrixXd N = uncertainties::detail::nominal_matrix(A);
+    Eigen::MatrixXd reference = N.exp();
+    EXPECT_LT((uncertainties::detail::nominal_matrix(E) - reference).norm(), 1e-10 * reference.norm());
+    auto nominal_exp = [](const Eigen::MatrixXd& M) { return Eigen::MatrixXd(M.exp()); };
+    expect_matches_finite_differences(A, E, nominal_exp, 1, 2, 1e-5 * reference.norm());
+    expect_matches_finite_differences(A, E, nominal_exp, 3, 3, 1e-5 * reference.norm());
+}
+
+TEST_F(MatrixFunctionsTest, ExpmOfDiagonalAndCommutingSum) {
+    udouble a(0.5, 0.1);
+    udouble b(-1.2, 0.2);
+    MatrixXu D(2, 2);
+    D << a, udouble(0.0),
+         udouble(0.0), b;
+
+    MatrixXu E = uncertainties::expm(D);
+
+    MatrixXu expected(2, 2);
+    expected << exp(a), udouble(0.0),
+                udouble(0.0), exp(b);
+    expect_linked(E, expected, 1e-14);
+
+    // Rate matrix of a two-state chain: rows of exp(Qt) sum to one exactly
+    udouble k1(0.3, 0.02);
+    udouble k2(0.1, 0.01);
+    MatrixXu Q(2, 2);
+    Q << -k1, k1,
+          k2, -k2;
+    MatrixXu P = uncertainties::expm(Q * udouble(2.0));
+    for (int i = 0; i < 2; ++i) {
+        udouble row = P(i, 0) + P(i, 1);
+        EXPECT_NEAR(row.nominal_value(), 1.0, 1e-14);
+        EXPECT_NEAR(row.stddev(), 0.0, 1e-14);
+    }
+    EXPECT_GT(P(0, 1).stddev(), 0.0);
+}
+
+TEST_F(MatrixFunctionsTest, SqrtmSquaresBackToMatrix) {
+    MatrixXu A = test_matrix(4, 2.0, 0.02);
+    MatrixFunctionOptions options;
+    options.threads = 3;
+
+    MatrixXu X = uncertainties::sqrtm(A, options);
+
+    expect_linked(MatrixXu(X * X), A, 1e-12);
+    auto nominal_sqrt = [](const Eigen::MatrixXd& M) { return Eigen::MatrixXd(M.sqrt()); };
+    expect_matches_finite_differences(A, X, nominal_sqrt, 0, 3, 1e-7);
+}
+
+TEST_F(MatrixFunctionsTest, LogmInvertsExpm) {
+    MatrixXu A = test_matrix(3, 3.0, 0.05);
+
+    MatrixXu L = uncertainties::logm(A);
+
+    Eigen::MatrixXd N = uncertainties::detail::nominal_matrix(A);
+    EXPECT_LT((uncertainties::detail::nominal_matrix(L) - Eigen::MatrixXd(N.log())).norm(), 1e-12);
+    expect_linked(uncertainties::expm(L), A, 1e-11);
+    auto nominal_log = [](const Eigen::MatrixXd& M) { return Eigen::MatrixXd(M.log()); };
+    expect_matches_finite_differences(A, L, nominal_log, 2, 0, 1e-7);
+}
+
+TEST_F(MatrixFunctionsTest, ComplexEigenvaluesGiveRealResults) {
+    // Rotation-like block with eigenvalues 2 ± i
+    udouble a(2.0, 0.1);
+    udouble b(1.0, 0.05);
+    MatrixXu A(2, 2);
+    A << a, -b,
+         b, a;
+
+    MatrixXu X = uncertainties::sqrtm(A);
+    expect_linked(MatrixXu(X * X), A, 1e-13);
+    MatrixXu L = uncertainties::logm(A);
+    // log(a + ib) = log|z| + i arg z
+    udouble modulus = sqrt(a * a + b * b);
+    EXPECT_NEAR((L(0, 0) - log(modulus)).stddev(), 0.0, 1e-13);
+    EXPECT_NEAR((L(1, 0) - atan2(b, a)).stddev(), 0.0, 1e-13);
+}
+
+TEST_F(MatrixFunctionsTest, InvalidArguments) {
+    MatrixXu rectangular(2, 3);
+    rectangular.setConstant(udouble(1.0));
+    EXPECT_THROW(uncertainties::expm(rectangular), std::invalid_argument);
+    EXPECT_THROW(uncertainties::sqrtm(rectangular), std::invalid_argument);
+
+    MatrixXu negative(2, 2);
+    negative << udouble(-1.0, 0.1), udouble(0.0),
+                udouble(0.0), udouble(2.0);
+    EXPECT_THROW(uncertainties::sqrtm(negative), std::invalid_argument);
+    EXPECT_THROW(uncertainties::logm(negative), std::invalid_argument);
+}
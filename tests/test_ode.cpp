@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "uncertainties/ode.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::Formula;
+using uncertainties::FormulaVar;
+using uncertainties::OdeOptions;
+
+class OdeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    static Formula decay() {
+        return uncertainties::record_ode(1, 1, [](const FormulaVar&, const std::vector<FormulaVar>& y,
+                                                  const std::vector<FormulaVar>& p) {
+            return std::vector<FormulaVar>{-p[0] * y[0]};
+        });
+    }
+
+    // y0' = y1, y1' = -k y0 - c y1 + sin(t)
+    static Formula oscillator() {
+        return uncertainties::record_ode(2, 2, [](const FormulaVar& t, const std::vector<FormulaVar>& y,
+                                                  const std::vector<FormulaVar>& p) {
+            return std::vector<FormulaVar>{y[1], -p[0] * y[0] - p[1] * y[1] + uncertainties::sin(t)};
+        });
+    }
+};
+
+TEST_F(OdeTest, ExponentialDecayMatchesClosedForm) {
+    udouble y0(2.0, 0.05);
+    udouble k(0.7, 0.03);
+
+    auto sol = uncertainties::solve_ode(decay(), {y0}, {k}, 0.0, {0.5, 1.0, 3.0});
+
+    ASSERT_EQ(sol.times().size(), 3u);
+    EXPECT_EQ(sol.num_sensitivities(), 2u);
+    for (std::size_t i = 0; i < 3; ++i) {
+        double t = sol.times()[i];
+        udouble expected = y0 * uncertainties::exp(-k * t);
+        udouble actual = sol.value(i, 0);
+        EXPECT_NEAR(actual.nominal_value(), expected.nominal_value(), 1e-8);
+        EXPECT_NEAR(actual.stddev(), expected.stddev(), 1e-8);
+        // Linked to the same atomics
+        EXPECT_NEAR((actual - expected).stddev(), 0.0, 1e-8);
+    }
+}
+
+TEST_F(OdeTest, SensitivitiesMatchFiniteDifferences) {
+    const double k = 4.0;
+    const double c = 0.3;
+    const double t_end = 5.0;
+    OdeOptions options;
+    options.rtol = 1e-11;
+    options.atol = 1e-12;
+
+    auto sol = uncertainties::solve_ode(oscillator(), {udouble(1.0, 0.01), udouble(0.0)},
+                                        {udouble(k, 0.1), udouble(c, 0.02)}, 0.0, {t_end}, options);
+    ASSERT_EQ(sol.num_sensitivities(), 3u);
+
+    auto position = [&](double y0, double kk, double cc) {
+        auto s = uncertainties::solve_ode(oscillator(), {udouble(y0), udouble(0.0)},
+                                          {udouble(kk), udouble(cc)}, 0.0, {t_end}, options);
+        return s.nominal(0, 0);
+    };
+    const double h = 1e-5;
+    double d_y0 = (position(1.0 + h, k, c) - position(1.0 - h, k, c)) / (2 * h);
+    double d_k = (position(1.0, k + h, c) - position(1.0, k - h, c)) / (2 * h);
+    double d_c = (position(1.0, k, c + h) - position(1.0, k, c - h)) / (2 * h);
+
+    EXPECT_NEAR(sol.sensitivity(0, 0, 0), d_y0, 1e-6);
+    EXPECT_NEAR(sol.sensitivity(0, 0, 1), d_k, 1e-6);
+    EXPECT_NEAR(sol.sensitivity(0, 0, 2), d_c, 1e-6);
+    double expected_sigma = std::sqrt(std::pow(d_y0 * 0.01, 2) + std::pow(d_k * 0.1, 2) +
+                                      std::pow(d_c * 0.02, 2));
+    EXPECT_NEAR(sol.value(0, 0).stddev(), expected_sigma, 1e-6);
+}
+
+TEST_F(OdeTest, StatesAreCorrelatedThroughSharedParameters) {
+    udouble k(0.5, 0.05);
+    Formula rhs = uncertainties::record_ode(2, 1, [](const FormulaVar&, const std::vector<FormulaVar>& y,
+                                                     const std::vector<FormulaVar>& p) {
+        return std::vector<FormulaVar>{-p[0] * y[0], -p[0] * y[1]};
+    });
+
+    auto sol = uncertainties::solve_ode(rhs, {udouble(1.0), udouble(3.0)}, {k}, 0.0, {2.0});
+    auto state = sol.state(0);
+
+    // y1 = 3 y0 exactly, including the uncertainty from k
+    EXPECT_GT(state[0].stddev(), 0.0);
+    EXPECT_NEAR((state[1] - 3.0 * state[0]).stddev(), 0.0, 1e-9);
+}
+
+TEST_F(OdeTest, BackwardIntegrationAndInitialTime) {
+    udouble y0(1.0, 0.1);
+    udouble k(0.2, 0.0);
+
+    auto sol = uncertainties::solve_ode(decay(), {y0}, {k}, 1.0, {1.0, 0.0, -2.0});
+
+    EXPECT_EQ(sol.num_sensitivities(), 1u);
+    EXPECT_DOUBLE_EQ(sol.nominal(0, 0), 1.0);
+    EXPECT_NEAR(sol.nominal(1, 0), std::exp(0.2), 1e-8);
+    EXPECT_NEAR(sol.nominal(2, 0), std::exp(0.6), 1e-8);
+    EXPECT_NEAR(sol.value(2, 0).stddev(), 0.1 * std::exp(0.6), 1e-8);
+}
+
+TEST_F(OdeTest, InvalidArguments) {
+    EXPECT_THROW(uncertainties::solve_ode(decay(), {udouble(1.0), udouble(2.0)}, {udouble(1.0)}, 0.0, {1.0}),
+                 std::invalid_argument);
+    EXPECT_THROW(uncertainties::solve_ode(decay(), {udouble(1.0)}, {udouble(1.0)}, 0.0, {2.0, 1.0}),
+                 std::invalid_argument);
+
+    OdeOptions few;
+    few.max_steps = 3;
+    few.initial_step = 1e-3;
+    EXPECT_THROW(uncertainties::solve_ode(decay(), {udouble(1.0)}, {udouble(1.0)}, 0.0, {100.0}, few),
+                 std::runtime_error);
+
+    auto sol = uncertainties::solve_ode(decay(), {udouble(1.0)}, {udouble(1.0)}, 0.0, {1.0});
+    EXPECT_THROW(sol.nominal(1, 0), std::out_of_range);
+    EXPECT_EQ(sol.num_sensitivities(), 0u);
+    EXPECT_DOUBLE_EQ(sol.value(0, 0).stddev(), 0.0);
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "uncertainties/pipeline.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::BoundedQueue;
+using uncertainties::Pipeline;
+using uncertainties::PipelineOptions;
+using uncertainties::ThreadPool;
+
+class PipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    struct Readings {
+        std::vector<double> value;
+        std::vector<double> sigma;
+    };
+};
+
+TEST_F(PipelineTest, QueueBlocksWhenFullAndDrainsAfterClose) {
+    BoundedQueue<int> queue(2);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed);
+    EXPECT_EQ(queue.pop(), 1);
+    producer.join();
+    EXPECT_TRUE(pushed);
+
+    queue.close();
+    EXPECT_FALSE(queue.push(4));
+    EXPECT_EQ(queue.pop(), 2);
+    EXPECT_EQ(queue.pop(), 3);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+    EXPECT_THROW(BoundedQueue<int>(0), std::invalid_argument);
+}
+
+TEST_F(PipelineTest, ThreadPoolReturnsResultsAndExceptions) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.size(), 3u);
+    std::vector<std::future<int>> results;
+    for (int k = 0; k < 20; ++k) {
+        results.push_back(pool.submit([k] { return k * k; }));
+    }
+    for (int k = 0; k < 20; ++k) {
+        EXPECT_EQ(results[k].get(), k * k);
+    }
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+}
+
+TEST_F(PipelineTest, RegisterBatchCreatesIndependentAtomics) {
+    std::vector<udouble> x = uncertainties::register_batch({1.0, 2.0, 3.0}, {0.1, 0.0, 0.3});
+    ASSERT_EQ(x.size(), 3u);
+    EXPECT_DOUBLE_EQ(x[0].stddev(), 0.1);
+    EXPECT_EQ(x[1].num_variables(), 0u);
+    EXPECT_NEAR((x[0] + x[2]).stddev(), std::hypot(0.1, 0.3), 1e-15);
+    EXPECT_NEAR((x[0] - x[0]).stddev(), 0.0, 1e-15);
+    EXPECT_THROW(uncertainties::register_batch({1.0}, {}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::register_batch({1.0}, {-1.0}), std::invalid_argument);
+}
+
+TEST_F(PipelineTest, StagesRunInOrderWithBackpressure) {
+    ThreadPool pool(4);
+    PipelineOptions options;
+    options.queue_capacity = 1;
+    Pipeline pipeline(pool, options);
+
+    const int batches = 40;
+    std::atomic<int> produced{0};
+    std::atomic<int> consumed{0};
+    std::atomic<int> max_in_flight{0};
+    std::vector<std::string> report;
+
+    int next = 0;
+    pipeline.source([&]() -> std::optional<Readings> {
+                if (next == batches) {
+                    return std::nullopt;
+                }
+                Readings r;
+                for (int i = 0; i < 8; ++i) {
+                    r.value.push_back(1.0 + next + 0.1 * i);
+                    r.sigma.push_back(0.01);
+                }
+                ++next;
+                int in_flight = ++produced - consumed;
+                int seen = max_in_flight;
+                while (in_flight > seen && !max_in_flight.compare_exchange_weak(seen, in_flight)) {
+                }
+                return r;
+            })
+            .then([](Readings r) { return uncertainties::register_batch(r.value, r.sigma); })
+            .then([](std::vector<udouble> x) {
+                for (udouble& v : x) {
+                    v = log(v);
+                }
+                return x;
+            })
+            .sink([&](std::vector<udouble> x) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                report.push_back(std::to_string(x.front().nominal_value()) + " " +
+                                 std::to_string(x.front().stddev()));
+                ++consumed;
+            });
+    pipeline.wait();
+
+    ASSERT_EQ(report.size(), static_cast<std::size_t>(batches));
+    for (int k = 0; k < batches; ++k) {
+        double v = 1.0 + k;
+        EXPECT_EQ(report[k], std::to_string(std::log(v)) + " " + std::to_string(0.01 / v));
+    }
+    // Items held by the four stages plus the three single-slot queues
+    EXPECT_LE(max_in_flight, 7);
+}
+
+TEST_F(PipelineTest, FailingStageStopsThePipeline) {
+    ThreadPool pool(3);
+    Pipeline pipeline(pool);
+    std::atomic<int> produced{0};
+
+    pipeline.source([&]() -> std::optional<int> {
+                // Unbounded: only the failure below ends it
+                return ++produced;
+            })
+            .then([](int k) {
+                if (k == 10) {
+                    throw std::runtime_error("bad record");
+                }
+                return k;
+            })
+            .sink([](int) {});
+
+    EXPECT_THROW(pipeline.wait(), std::runtime_error);
+    EXPECT_LT(produced, 100);
+}
+
+TEST_F(PipelineTest, StagesNeedPoolThreads) {
+    ThreadPool pool(1);
+    Pipeline pipeline(pool);
+    int next = 0;
+    auto source = pipeline.source([&]() -> std::optional<int> {
+        return next < 100 ? std::optional<int>(next++) : std::nullopt;
+    });
+    EXPECT_THROW(source.sink([](int) {}), std::invalid_argument);
+    // The source sees its queue closed and finishes
+    EXPECT_NO_THROW(pipeline.wait());
+}
+
+TEST_F(PipelineTest, PipelinesSharingAPoolCountEachOthersStages) {
+    ThreadPool pool(2);
+    Pipeline first(pool);
+    Pipeline second(pool);
+    auto numbers = [] {
+        return [next = 0]() mutable -> std::optional<int> {
+            return next < 1000 ? std::optional<int>(next++) : std::nullopt;
+        };
+    };
+    auto a = first.source(numbers());
+    auto b = second.source(numbers());
+    // Both threads are taken by the sources
+    EXPECT_THROW(b.sink([](int) {}), std::invalid_argument);
+    // The first source has no consumer either; wait() stops it
+    EXPECT_NO_THROW(first.wait());
+    EXPECT_NO_THROW(second.wait());
+
+    // Once they are done, the threads can be claimed again
+    Pipeline third(pool);
+    int total = 0;
+    third.source(numbers()).sink([&](int k) { total += k; });
+    third.wait();
+    EXPECT_EQ(total, 999 * 1000 / 2);
+}
+
+TEST_F(PipelineTest, StageWithoutConsumerDoesNotBlock) {
+    ThreadPool pool(2);
+    std::atomic<int> produced{0};
+    {
+        PipelineOptions options;
+        options.queue_capacity = 2;
+        Pipeline pipeline(pool, options);
+        pipeline.source([&]() -> std::optional<int> { return ++produced; })
+                .then([](int k) { return 2 * k; });
+        // Destroyed without a sink: the unconsumed output is discarded
+    }
+    EXPECT_GT(produced, 0);
+
+    Pipeline pipeline(pool);
+    int sum = 0;
+    int next = 0;
+    pipeline.source([&]() -> std::optional<int> {
+                return next < 10 ? std::optional<int>(next++) : std::nullopt;
+            })
+            .sink([&](int k) { sum += k; });
+    pipeline.wait();
+    EXPECT_EQ(sum, 45);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "uncertainties/roots.hpp"
+#include "uncertainties/udouble.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::Formula;
+using uncertainties::FormulaVar;
+using uncertainties::RootOptions;
+
+class RootsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+};
+
+TEST_F(RootsTest, CubeRootMatchesClosedForm) {
+    udouble a(2.0, 0.01);
+
+    udouble x = uncertainties::find_root([](const FormulaVar& x, const std::vector<FormulaVar>& p) {
+        return x * x * x - p[0];
+    }, 0.0, 2.0, {a});
+
+    udouble expected = pow(a, 1.0 / 3.0);
+    EXPECT_NEAR(x.nominal_value(), expected.nominal_value(), 1e-14);
+    EXPECT_NEAR(x.stddev(), expected.stddev(), 1e-14);
+    // Linked to the same atomic as the parameter
+    EXPECT_NEAR((x - expected).stddev(), 0.0, 1e-14);
+}
+
+TEST_F(RootsTest, TranscendentalEquationMatchesImplicitDerivatives) {
+    // x = cos(a x) + b
+    udouble a(0.8, 0.02);
+    udouble b(0.1, 0.01);
+    Formula f = Formula::record(3, [](const std::vector<FormulaVar>& in) {
+        return in[0] - uncertainties::cos(in[1] * in[0]) - in[2];
+    });
+
+    udouble x = uncertainties::find_root(f, 0.0, 2.0, {a, b});
+
+    double xn = x.nominal_value();
+    EXPECT_NEAR(xn - std::cos(0.8 * xn) - 0.1, 0.0, 1e-14);
+    double f_x = 1.0 + 0.8 * std::sin(0.8 * xn);
+    double dx_da = -(xn * std::sin(0.8 * xn)) / f_x;
+    double dx_db = 1.0 / f_x;
+    EXPECT_NEAR(x.stddev(), std::hypot(dx_da * 0.02, dx_db * 0.01), 1e-14);
+    // Linear in the parameters to first order
+    EXPECT_NEAR((x - dx_da * a - dx_db * b).stddev(), 0.0, 1e-14);
+}
+
+TEST_F(RootsTest, CorrelatedParametersAndExactOnes) {
+    udouble u(1.5, 0.1);
+    // Both parameters depend on u; the third is exact
+    std::vector<udouble> params{2.0 * u, u * u, udouble(3.0)};
+
+    // p0 x - p1 - p2 = 0  =>  x = (u^2 + 3) / (2 u)
+    udouble x = uncertainties::find_root([](const FormulaVar& x, const std::vector<FormulaVar>& p) {
+        return p[0] * x - p[1] - p[2];
+    }, -10.0, 10.0, params);
+
+    udouble expected = (u * u + 3.0) / (2.0 * u);
+    EXPECT_NEAR(x.nominal_value(), expected.nominal_value(), 1e-13);
+    EXPECT_NEAR((x - expected).stddev(), 0.0, 1e-13);
+}
+
+TEST_F(RootsTest, ImplicitRootOfExternallyFoundRoot) {
+    udouble c(4.0, 0.2);
+    Formula f = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return in[0] * in[0] - in[1];
+    });
+
+    // Negative branch of sqrt(c): dx/dc = -1 / (2 sqrt(c))
+    udouble x = uncertainties::implicit_root(f, -2.0, {c});
+    EXPECT_DOUBLE_EQ(x.nominal_value(), -2.0);
+    EXPECT_NEAR(x.stddev(), 0.2 / 4.0, 1e-15);
+    EXPECT_NEAR((x + 0.25 * c).stddev(), 0.0, 1e-15);
+}
+
+TEST_F(RootsTest, RootAtBracketEndAndAtZero) {
+    udouble p(0.0, 0.5);
+    auto linear = [](const FormulaVar& x, const std::vector<FormulaVar>& p) { return 3.0 * x - p[0]; };
+
+    udouble x = uncertainties::find_root(linear, 0.0, 1.0, {p});
+    EXPECT_DOUBLE_EQ(x.nominal_value(), 0.0);
+    EXPECT_NEAR(x.stddev(), 0.5 / 3.0, 1e-15);
+
+    udouble y = uncertainties::find_root(linear, -1.0, 2.0, {p});
+    EXPECT_NEAR(y.nominal_value(), 0.0, 1e-300);
+    EXPECT_NEAR(y.stddev(), 0.5 / 3.0, 1e-15);
+}
+
+TEST_F(RootsTest, InvalidArguments) {
+    auto square = [](const FormulaVar& x, const std::vector<FormulaVar>& p) { return x * x - p[0]; };
+    udouble c(1.0, 0.1);
+
+    // No sign change
+    EXPECT_THROW(uncertainties::find_root(square, 2.0, 3.0, {c}), std::invalid_argument);
+
+    // Wrong signature
+    Formula two_outputs = Formula::record(2, [](const std::vector<FormulaVar>& in) {
+        return std::vector<FormulaVar>{in[0], in[1]};
+    });
+    EXPECT_THROW(uncertainties::find_root(two_outputs, 0.0, 1.0, {c}), std::invalid_argument);
+    Formula one_input = Formula::record(1, [](const std::vector<FormulaVar>& in) { return in[0]; });
+    EXPECT_THROW(uncertainties::implicit_root(one_input, 0.0, {c}), std::invalid_argument);
+
+    // Double root: ∂f/∂x vanishes
+    EXPECT_THROW(uncertainties::implicit_root(Formula::record(2, [](const std::vector<FormulaVar>& in) {
+                     return in[0] * in[0] - in[1];
+                 }), 0.0, {udouble(0.0, 0.1)}),
+                 std::runtime_error);
+
+    RootOptions few;
+    few.max_iterations = 2;
+    EXPECT_THROW(uncertainties::find_root([](const FormulaVar& x, const std::vector<FormulaVar>& p) {
+        return uncertainties::exp(x) - p[0];
+    }, -50.0, 50.0, {c}, few), std::runtime_error);
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "uncertainties/scan.hpp"
+#include "uncertainties/udouble.hpp"
+
+using uncertainties::udouble;
+using uncertainties::ScanOp;
+using uncertainties::ScanOptions;
+
+class ScanTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // Sequential reference with operator+= / operator*=
+    static std::vector<udouble> reference(const std::vector<udouble>& xs, ScanOp op) {
+        std::vector<udouble> out;
+        udouble running(op == ScanOp::Sum ? 0.0 : 1.0);
+        for (const auto& x : xs) {
+            if (op == ScanOp::Sum) {
+                running += x;
+            } else {
+                running *= x;
+            }
+            out.push_back(running);
+        }
+        return out;
+    }
+
+    // Inputs that share a common systematic term, so they are correlated
+    static std::vector<udouble> correlated_inputs(std::size_t n, double low, double high) {
+        std::mt19937_64 rng(11);
+        std::uniform_real_distribution<double> uniform(low, high);
+        udouble systematic(1.0, 0.02);
+        std::vector<udouble> xs;
+        for (std::size_t i = 0; i < n; ++i) {
+            udouble x(uniform(rng), 0.05 * uniform(rng));
+            xs.push_back(i % 3 == 0 ? x * systematic : x);
+        }
+        return xs;
+    }
+};
+
+TEST_F(ScanTest, InclusiveSumMatchesSequentialLoop) {
+    auto xs = correlated_inputs(200, 0.5, 2.0);
+    ScanOptions options;
+    options.block_size = 16;
+    options.threads = 3;
+
+    auto result = uncertainties::inclusive_scan(xs, ScanOp::Sum, options);
+    auto expected = reference(xs, ScanOp::Sum);
+
+    ASSERT_EQ(result.size(), xs.size());
+    for (std::size_t k = 0; k < xs.size(); ++k) {
+        EXPECT_NEAR(result.nominal()[k], expected[k].nominal_value(), 1e-12);
+        EXPECT_NEAR(result.stddev()[k], expected[k].stddev(), 1e-12);
+    }
+}
+
+TEST_F(ScanTest, InclusiveProductMatchesSequentialLoop) {
+    auto xs = correlated_inputs(60, 0.8, 1.25);
+    ScanOptions options;
+    options.block_size = 7;
+
+    auto result = uncertainties::inclusive_scan(xs, ScanOp::Product, options);
+    auto expected = reference(xs, ScanOp::Product);
+
+    for (std::size_t k = 0; k < xs.size(); ++k) {
+        double scale = std::abs(expected[k].nominal_value());
+        EXPECT_NEAR(result.nominal()[k], expected[k].nominal_value(), 1e-12 * scale);
+        EXPECT_NEAR(result.stddev()[k], expected[k].stddev(), 1e-10 * scale);
+    }
+}
+
+TEST_F(ScanTest, ExclusiveScanShiftsByOne) {
+    std::vector<udouble> xs = {udouble(1.0, 0.1), udouble(2.0, 0.2), udouble(3.0, 0.3)};
+
+    auto sums = uncertainties::exclusive_scan(xs);
+    auto products = uncertainties::exclusive_scan(xs.begin(), xs.end(), ScanOp::Product);
+
+    ASSERT_EQ(sums.size(), 3u);
+    EXPECT_DOUBLE_EQ(sums.nominal()[0], 0.0);
+    EXPECT_DOUBLE_EQ(sums.stddev()[0], 0.0);
+    EXPECT_DOUBLE_EQ(sums.nominal()[2], 3.0);
+    EXPECT_NEAR(sums.stddev()[2], std::sqrt(0.01 + 0.04), 1e-14);
+    EXPECT_EQ(sums.row_length(0), 0u);
+    EXPECT_DOUBLE_EQ(products.nominal()[0], 1.0);
+    EXPECT_DOUBLE_EQ(products.nominal()[2], 2.0);
+    EXPECT_DOUBLE_EQ(products.coefficient(2, 0), 2.0);
+    EXPECT_DOUBLE_EQ(products.coefficient(2, 2), 0.0);
+}
+
+TEST_F(ScanTest, CoefficientsFormLowerTriangle) {
+    std::vector<udouble> xs = {udouble(2.0, 0.1), udouble(3.0, 0.1), udouble(5.0, 0.1)};
+
+    auto result = uncertainties::inclusive_scan(xs, ScanOp::Product);
+
+    EXPECT_DOUBLE_EQ(result.coefficient(1, 0), 3.0);
+    EXPECT_DOUBLE_EQ(result.coefficient(1, 1), 2.0);
+    EXPECT_DOUBLE_EQ(result.coefficient(1, 2), 0.0);
+    EXPECT_DOUBLE_EQ(result.coefficient(2, 1), 10.0);
+    EXPECT_EQ(result.row_length(2), 3u);
+}
+
+TEST_F(ScanTest, ProductWithZerosFollowsProductRule) {
+    std::vector<udouble> xs = {udouble(2.0, 0.1), udouble(0.0, 0.5), udouble(3.0, 0.2),
+                               udouble(0.0, 0.4), udouble(4.0, 0.1)};
+
+    auto result = uncertainties::inclusive_scan(xs, ScanOp::Product);
+    auto expected = reference(xs, ScanOp::Product);
+
+    for (std::size_t k = 0; k < xs.size(); ++k) {
+        EXPECT_DOUBLE_EQ(result.nominal()[k], expected[k].nominal_value());
+        EXPECT_NEAR(result.stddev()[k], expected[k].stddev(), 1e-14);
+    }
+    // One zero: only it contributes, with the product of the others
+    EXPECT_DOUBLE_EQ(result.coefficient(2, 1), 6.0);
+    EXPECT_DOUBLE_EQ(result.coefficient(2, 0), 0.0);
+    // Two zeros: nothing contributes
+    EXPECT_DOUBLE_EQ(result.stddev()[4], 0.0);
+}
+
+TEST_F(ScanTest, MaterializedValuesAreCorrelatedWithInputs) {
+    auto xs = correlated_inputs(30, 0.5, 2.0);
+    auto result = uncertainties::inclusive_scan(xs, ScanOp::Sum);
+    auto values = result.values();
+
+    ASSERT_EQ(values.size(), xs.size());
+    for (std::size_t k = 1; k < xs.size(); ++k) {
+        EXPECT_NEAR(values[k].stddev(), result.stddev()[k], 1e-12);
+        // Consecutive totals differ by exactly the next input
+        EXPECT_NEAR((values[k] - values[k - 1] - xs[k]).stddev(), 0.0, 1e-12);
+    }
+    EXPECT_NEAR((result.value(17) - values[17]).stddev(), 0.0, 1e-12);
+}
+
+TEST_F(ScanTest, MaterializedProductsMatchDirectRows) {
+    auto xs = correlated_inputs(20, 0.5, 2.0);
+    auto result = uncertainties::exclusive_scan(xs, ScanOp::Product);
+    auto values = result.values();
+    auto expected = reference(xs, ScanOp::Product);
+
+    ASSERT_EQ(values.size(), xs.size());
+    EXPECT_DOUBLE_EQ(values[0].nominal_value(), 1.0);
+    for (std::size_t k = 1; k < xs.size(); ++k) {
+        double scale = std::abs(expected[k - 1].nominal_value());
+        EXPECT_NEAR((values[k] - expected[k - 1]).stddev(), 0.0, 1e-12 * scale);
+        EXPECT_NEAR((result.value(k) - values[k]).stddev(), 0.0, 1e-12 * scale);
+    }
+}
+
+TEST_F(ScanTest, MaterializedValuesMatchValueAfterRescaling) {
+    // The running product overflows the scale range, and x0's contribution
+    // is below 1e-32 of the variance
+    std::vector<udouble> xs{udouble(1.0, 1e-20)};
+    for (int i = 0; i < 14; ++i) {
+        xs.emplace_back(1e10, 1e9);
+    }
+    auto result = uncertainties::inclusive_scan(xs, ScanOp::Product);
+    auto values = result.values();
+
+    ASSERT_EQ(values.size(), xs.size());
+    for (std::size_t k = 0; k < xs.size(); ++k) {
+        udouble direct = result.value(k);
+        ASSERT_EQ(values[k].num_variables(), direct.num_variables());
+        for (const auto& [id, deriv] : direct.derivatives()) {
+            EXPECT_NEAR(values[k].derivatives().at(id), deriv, 1e-12 * std::abs(deriv));
+        }
+    }
+}
+
+TEST_F(ScanTest, ResultDoesNotDependOnThreadCount) {
+    auto xs = correlated_inputs(1000, 0.5, 2.0);
+    ScanOptions one;
+    one.threads = 1;
+    one.block_size = 64;
+    ScanOptions many = one;
+    many.threads = 4;
+
+    auto a = uncertainties::inclusive_scan(xs, ScanOp::Sum, one);
+    auto b = uncertainties::inclusive_scan(xs, ScanOp::Sum, many);
+
+    EXPECT_EQ(a.nominal(), b.nominal());
+    EXPECT_EQ(a.stddev(), b.stddev());
+}
+
+TEST_F(ScanTest, EmptyInput) {
+    std::vector<udouble> xs;
+    auto result = uncertainties::exclusive_scan(xs, ScanOp::Product);
+    EXPECT_EQ(result.size(), 0u);
+    EXPECT_TRUE(result.values().empty());
+    EXPECT_THROW(result.value(0), std::out_of_range);
+}
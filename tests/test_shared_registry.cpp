@@ -0,0 +1,282 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "uncertainties/distributed.hpp"
+#include "uncertainties/shared_registry.hpp"
+#include "uncertainties/udouble.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#define UNCERTAINTIES_HAVE_FORK 1
+#endif
+
+using uncertainties::udouble;
+using Registry = uncertainties::detail::VariableRegistry;
+
+#ifdef UNCERTAINTIES_HAVE_FORK
+
+class SharedRegistryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Registry::instance().clear();
+        name_ = "/uncertainties-test-" + std::to_string(getpid());
+        uncertainties::remove_shared_registry(name_);
+    }
+
+    void TearDown() override {
+        uncertainties::detach_shared_registry();
+        uncertainties::remove_shared_registry(name_);
+        Registry::instance().clear();
+    }
+
+    // Run `work` in a forked child and return what it serialized
+    static std::string run_worker(const std::function<void(std::ostream&)>& work) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            ADD_FAILURE() << "pipe failed";
+            return {};
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            int status = 0;
+            try {
+                std::ostringstream out;
+                work(out);
+                std::string data = out.str();
+                if (write(fds[1], data.data(), data.size()) != static_cast<ssize_t>(data.size())) {
+                    status = 2;
+                }
+            } catch (...) {
+                status = 1;
+            }
+            close(fds[1]);
+            _exit(status);
+        }
+        close(fds[1]);
+        std::string data;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+            data.append(buffer, static_cast<std::size_t>(n));
+        }
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        return data;
+    }
+
+    std::string name_;
+};
+
+TEST_F(SharedRegistryTest, AttachAndDetach) {
+    udouble before(1.0, 0.1);
+    before.derivatives();
+
+    uncertainties::SharedRegistryOptions options;
+    options.capacity = 64;
+    uncertainties::attach_shared_registry(name_, options);
+    EXPECT_TRUE(uncertainties::shared_registry_attached());
+    EXPECT_THROW(uncertainties::attach_shared_registry(name_), std::runtime_error);
+
+    udouble after(2.0, 0.2);
+    // Atomics from before attaching stay usable and keep distinct IDs
+    EXPECT_NEAR((before + after).stddev(), std::hypot(0.1, 0.2), 1e-15);
+    EXPECT_NE(before.derivatives().begin()->first, after.derivatives().begin()->first);
+
+    uncertainties::detach_shared_registry();
+    EXPECT_FALSE(uncertainties::shared_registry_attached());
+    EXPECT_NEAR(before.stddev(), 0.1, 1e-15);
+}
+
+TEST_F(SharedRegistryTest, FullTableThrows) {
+    uncertainties::SharedRegistryOptions options;
+    options.capacity = 4;
+    uncertainties::attach_shared_registry(name_, options);
+    std::vector<udouble> atomics;
+    auto fill = [&] {
+        for (int k = 0; k < 16; ++k) {
+            atomics.emplace_back(1.0, 0.1);
+            atomics.back().derivatives();
+        }
+    };
+    EXPECT_THROW(fill(), std::runtime_error);
+}
+
+TEST_F(SharedRegistryTest, WorkersShareIdsAndStddevs) {
+    uncertainties::attach_shared_registry(name_);
+    // Broadcast parameter, created before the workers fork
+    udouble gain(2.0, 0.1);
+    gain.derivatives();
+
+    std::vector<std::string> outputs;
+    for (int k = 0; k < 2; ++k) {
+        // No ID namespaces: the shared counter keeps the workers apart
+        outputs.push_back(run_worker([&, k](std::ostream& out) {
+            udouble noise(0.0, 0.05 * (k + 1));
+            uncertainties::serialize(out, {gain * (k + 1.0) + noise, noise});
+        }));
+    }
+
+    std::istringstream first(outputs[0]);
+    std::istringstream second(outputs[1]);
+    auto r1 = uncertainties::deserialize(first);
+    auto r2 = uncertainties::deserialize(second);
+    EXPECT_NE(r1[1].derivatives().begin()->first, r2[1].derivatives().begin()->first);
+    EXPECT_NEAR((r2[0] - 2.0 * r1[0]).stddev(), std::hypot(0.1, 2.0 * 0.05), 1e-15);
+    EXPECT_NEAR((r1[1] + r2[1]).stddev(), std::hypot(0.05, 0.1), 1e-15);
+
+    // The workers' atomics are already in the shared table
+    double sigma = 0.0;
+    EXPECT_TRUE(Registry::instance().try_get_stddev(r2[1].derivatives().begin()->first, sigma));
+    EXPECT_EQ(sigma, 0.1);
+}
+
+TEST_F(SharedRegistryTest, StddevChangesAreVisibleAcrossProcesses) {
+    uncertainties::attach_shared_registry(name_);
+    udouble x(1.0, 0.1);
+    udouble y = 3.0 * x;
+    EXPECT_NEAR(y.stddev(), 0.3, 1e-15);
+    uint64_t id = x.derivatives().begin()->first;
+
+    run_worker([id](std::ostream&) { Registry::instance().set_stddev(id, 0.5); });
+
+    // The cached stddev is invalidated through the shared generation
+    EXPECT_NEAR(y.stddev(), 1.5, 1e-15);
+}
+
+TEST_F(SharedRegistryTest, AtomicsFromBeforeAttachDoNotCollide) {
+    // Both processes reserve ID 1 before attaching and register it afterwards
+    udouble b(1.0, 0.1);
+    uncertainties::attach_shared_registry(name_);
+
+    std::string output = run_worker([&](std::ostream& out) {
+        uncertainties::detach_shared_registry();
+        Registry::instance().clear();
+        udouble a(5.0, 1.0);
+        uncertainties::attach_shared_registry(name_);
+        out << (2.0 * a).stddev();
+    });
+    EXPECT_EQ(output, "2");
+    EXPECT_NEAR((2.0 * b).stddev(), 0.2, 1e-15);
+    EXPECT_FALSE(Registry::is_shared_id(b.derivatives().begin()->first));
+}
+
+TEST_F(SharedRegistryTest, ConflictingStddevThrows) {
+    uncertainties::attach_shared_registry(name_);
+    uint64_t id = Registry::instance().register_variable(0.1);
+    EXPECT_TRUE(Registry::is_shared_id(id));
+    EXPECT_NO_THROW(Registry::instance().register_id(id, 0.1));
+    EXPECT_THROW(Registry::instance().register_id(id, 0.2), std::runtime_error);
+}
+
+TEST_F(SharedRegistryTest, NanStddevIsRejected) {
+    uncertainties::attach_shared_registry(name_);
+    uint64_t id = Registry::instance().register_variable(0.1);
+    EXPECT_THROW(Registry::instance().register_variable(std::nan("")), std::invalid_argument);
+    EXPECT_THROW(Registry::instance().set_stddev(id, std::nan("")), std::invalid_argument);
+    EXPECT_EQ(Registry::instance().get_stddev(id), 0.1);
+}
+
+TEST_F(SharedRegistryTest, AbandonedSlotDoesNotHang) {
+    using Table = uncertainties::detail::SharedRegistryTable;
+    std::vector<unsigned char> memory(Table::bytes(8));
+    Table* table = Table::create(memory.data(), 8);
+    const uint64_t id = 42;
+
+    // A writer claimed the slot of `id` and died before publishing its ID
+    Table::Slot& slot = table->slots()[Table::hash(id) & 7];
+    slot.sigma_bits.store(Table::to_bits(0.5));
+
+    double sigma = 0.0;
+    EXPECT_FALSE(table->lookup(id, sigma));
+    EXPECT_THROW(table->insert(id, 0.1), std::runtime_error);
+
+    // Entries probed past the abandoned slot are still found
+    slot.id.store(7);
+    table->insert(id, 0.1);
+    slot.id.store(0);
+    EXPECT_TRUE(table->lookup(id, sigma));
+    EXPECT_EQ(sigma, 0.1);
+}
+
+TEST_F(SharedRegistryTest, ClearDetachesWithoutWipingTheTable) {
+    uncertainties::attach_shared_registry(name_);
+    uint64_t id = Registry::instance().register_variable(0.1);
+
+    run_worker([](std::ostream&) {
+        Registry::instance().clear();
+        if (uncertainties::shared_registry_attached()) {
+            throw std::runtime_error("clear() left the table attached");
+        }
+    });
+
+    // The worker's clear() left the entries of every other process alone
+    double sigma = 0.0;
+    EXPECT_TRUE(Registry::instance().try_get_stddev(id, sigma));
+    EXPECT_EQ(sigma, 0.1);
+
+    Registry::instance().clear();
+    EXPECT_FALSE(uncertainties::shared_registry_attached());
+    uncertainties::attach_shared_registry(name_);
+    EXPECT_TRUE(Registry::instance().try_get_stddev(id, sigma));
+    EXPECT_NE(Registry::instance().reserve_id(), id);
+}
+
+TEST_F(SharedRegistryTest, NamespacesStayPerProcess) {
+    uncertainties::attach_shared_registry(name_);
+    std::string output = run_worker([](std::ostream& out) {
+        Registry::instance().set_id_namespace(5);
+        udouble x(1.0, 0.1);
+        uncertainties::serialize(out, {x});
+    });
+    EXPECT_EQ(Registry::instance().id_namespace(), 0u);
+
+    std::istringstream in(output);
+    auto values = uncertainties::deserialize(in);
+    uint64_t remote = values[0].derivatives().begin()->first;
+    EXPECT_EQ(Registry::namespace_of(remote), 5u);
+    EXPECT_TRUE(Registry::is_shared_id(remote));
+
+    udouble y(2.0, 0.2);
+    uint64_t local = y.derivatives().begin()->first;
+    EXPECT_EQ(Registry::namespace_of(local), 0u);
+    EXPECT_NEAR((values[0] + y).stddev(), std::hypot(0.1, 0.2), 1e-15);
+}
+
+TEST_F(SharedRegistryTest, DetachWaitsForConcurrentReaders) {
+    uncertainties::attach_shared_registry(name_);
+    udouble x(1.0, 0.1);
+    x.derivatives();
+    uint64_t id = x.derivatives().begin()->first;
+
+    std::atomic<bool> started{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            double sigma = 0.0;
+            for (int k = 0; k < 20000; ++k) {
+                Registry::instance().generation();
+                Registry::instance().try_get_stddev(id, sigma);
+                started = true;
+            }
+        });
+    }
+    while (!started) {
+        std::this_thread::yield();
+    }
+    uncertainties::detach_shared_registry();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_FALSE(uncertainties::shared_registry_attached());
+}
+
+#endif
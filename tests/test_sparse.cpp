@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "uncertainties/sparse.hpp"
+#include "uncertainties/udouble.hpp"
+
+using uncertainties::udouble;
+using uncertainties::SparseEntry;
+using uncertainties::SparseOptions;
+using uncertainties::SparseUMatrix;
+using uncertainties::Triangle;
+
+class SparseTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // Banded lower-triangular matrix with a dominant diagonal
+    static SparseUMatrix banded_lower(std::size_t n, std::size_t bandwidth) {
+        std::vector<SparseEntry> entries;
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = i >= bandwidth ? i - bandwidth : 0; j <= i; ++j) {
+                double nominal = i == j ? 4.0 : std::sin(1.0 + i + 2.0 * j);
+                entries.push_back({i, j, udouble(nominal, 0.01)});
+            }
+        }
+        return SparseUMatrix(n, n, entries);
+    }
+
+    // Dense reference: y = A x in udouble arithmetic
+    static std::vector<udouble> dense_product(const SparseUMatrix& A, const std::vector<udouble>& x) {
+        std::vector<udouble> y(A.rows(), udouble(0.0));
+        for (std::size_t i = 0; i < A.rows(); ++i) {
+            for (std::size_t k = A.row_offsets()[i]; k < A.row_offsets()[i + 1]; ++k) {
+                y[i] += A.values()[k] * x[A.column_indices()[k]];
+            }
+        }
+        return y;
+    }
+};
+
+TEST_F(SparseTest, ConstructionSortsAndSumsDuplicates) {
+    udouble a(1.0, 0.1);
+    udouble b(2.0, 0.2);
+    SparseUMatrix A(2, 3, {{1, 2, a}, {0, 1, b}, {1, 0, a}, {1, 2, b}});
+
+    EXPECT_EQ(A.nonzeros(), 3u);
+    EXPECT_EQ(A.row_offsets(), (std::vector<std::size_t>{0, 1, 3}));
+    EXPECT_EQ(A.column_indices(), (std::vector<std::size_t>{1, 0, 2}));
+    EXPECT_NEAR((A.coeff(1, 2) - (a + b)).stddev(), 0.0, 1e-15);
+    EXPECT_DOUBLE_EQ(A.coeff(1, 2).nominal_value(), 3.0);
+    EXPECT_DOUBLE_EQ(A.coeff(0, 0).nominal_value(), 0.0);
+    EXPECT_DOUBLE_EQ(A.nominal_values()[0], 2.0);
+
+    SparseUMatrix T = A.transpose();
+    EXPECT_EQ(T.rows(), 3u);
+    EXPECT_EQ(T.cols(), 2u);
+    EXPECT_NEAR((T.coeff(2, 1) - A.coeff(1, 2)).stddev(), 0.0, 1e-15);
+    EXPECT_NEAR((T.coeff(1, 0) - b).stddev(), 0.0, 1e-15);
+}
+
+TEST_F(SparseTest, SpmvMatchesDenseArithmetic) {
+    SparseUMatrix A = banded_lower(600, 3);
+    std::vector<udouble> x;
+    for (std::size_t j = 0; j < 600; ++j) {
+        x.emplace_back(std::cos(0.1 * j), 0.02);
+    }
+    SparseOptions options;
+    options.threads = 4;
+
+    std::vector<udouble> y = uncertainties::spmv(A, x, options);
+    std::vector<udouble> expected = dense_product(A, x);
+
+    ASSERT_EQ(y.size(), 600u);
+    for (std::size_t i = 0; i < 600; i += 37) {
+        EXPECT_NEAR(y[i].nominal_value(), expected[i].nominal_value(), 1e-13);
+        EXPECT_NEAR(y[i].stddev(), expected[i].stddev(), 1e-13);
+        EXPECT_NEAR((y[i] - expected[i]).stddev(), 0.0, 1e-13);
+    }
+}
+
+TEST_F(SparseTest, SpmvWithExactVectorAndTranspose) {
+    udouble a(2.0, 0.1);
+    udouble b(-1.0, 0.2);
+    SparseUMatrix A(2, 2, {{0, 0, a}, {0, 1, b}, {1, 1, a}});
+    std::vector<double> x{3.0, 4.0};
+
+    std::vector<udouble> y = uncertainties::spmv(A, x);
+    EXPECT_NEAR((y[0] - (3.0 * a + 4.0 * b)).stddev(), 0.0, 1e-15);
+    EXPECT_NEAR((y[1] - 4.0 * a).stddev(), 0.0, 1e-15);
+
+    std::vector<udouble> z = uncertainties::spmv(A.transpose(), x);
+    EXPECT_NEAR(z[1].nominal_value(), -3.0 + 8.0, 1e-15);
+    EXPECT_NEAR((z[1] - (3.0 * b + 4.0 * a)).stddev(), 0.0, 1e-15);
+}
+
+TEST_F(SparseTest, TriangularSolveInvertsProduct) {
+    SparseUMatrix L = banded_lower(200, 4);
+    std::vector<udouble> x;
+    for (std::size_t j = 0; j < 200; ++j) {
+        x.emplace_back(1.0 + 0.01 * j, 0.05);
+    }
+    SparseOptions options;
+    options.threads = 4;
+
+    // L (L⁻¹ b) = b exactly, derivatives included
+    std::vector<udouble> b = uncertainties::spmv(L, x, options);
+    std::vector<udouble> solved = uncertainties::triangular_solve(L, b, Triangle::Lower, options);
+    for (std::size_t i = 0; i < 200; i += 13) {
+        EXPECT_NEAR(solved[i].nominal_value(), x[i].nominal_value(), 1e-12);
+        EXPECT_NEAR((solved[i] - x[i]).stddev(), 0.0, 1e-12);
+    }
+
+    // Same through the upper-triangular transpose: Lᵀ y = c
+    std::vector<udouble> c = uncertainties::spmv(L.transpose(), x, options);
+    std::vector<udouble> back = uncertainties::triangular_solve(L.transpose(), c, Triangle::Upper, options);
+    for (std::size_t i = 0; i < 200; i += 13) {
+        EXPECT_NEAR((back[i] - x[i]).stddev(), 0.0, 1e-12);
+    }
+}
+
+TEST_F(SparseTest, TriangularSolveMatchesClosedForm) {
+    udouble a(2.0, 0.1);
+    udouble c(0.5, 0.05);
+    udouble d(4.0, 0.2);
+    udouble b0(1.0, 0.01);
+    udouble b1(3.0, 0.03);
+    // Upper triangle entry (0, 1) is ignored for a lower solve
+    SparseUMatrix L(2, 2, {{0, 0, a}, {0, 1, udouble(7.0, 1.0)}, {1, 0, c}, {1, 1, d}});
+
+    auto x = uncertainties::triangular_solve(L, {b0, b1}, Triangle::Lower);
+
+    udouble x0 = b0 / a;
+    udouble x1 = (b1 - c * x0) / d;
+    EXPECT_NEAR(x[0].nominal_value(), x0.nominal_value(), 1e-15);
+    EXPECT_NEAR((x[0] - x0).stddev(), 0.0, 1e-15);
+    EXPECT_NEAR(x[1].nominal_value(), x1.nominal_value(), 1e-15);
+    EXPECT_NEAR((x[1] - x1).stddev(), 0.0, 1e-15);
+}
+
+TEST_F(SparseTest, InvalidArguments) {
+    EXPECT_THROW(SparseUMatrix(2, 2, {{2, 0, udouble(1.0)}}), std::invalid_argument);
+
+    SparseUMatrix A(2, 3, {{0, 0, udouble(1.0)}});
+    EXPECT_THROW(A.coeff(2, 0), std::out_of_range);
+    EXPECT_THROW(uncertainties::spmv(A, std::vector<double>{1.0, 2.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::triangular_solve(A, {udouble(1.0), udouble(1.0)}, Triangle::Lower),
+                 std::invalid_argument);
+
+    SparseUMatrix missing_diagonal(2, 2, {{0, 0, udouble(1.0)}, {1, 0, udouble(1.0)}});
+    EXPECT_THROW(uncertainties::triangular_solve(missing_diagonal, {udouble(1.0), udouble(1.0)},
+                                                 Triangle::Lower),
+                 std::runtime_error);
+}
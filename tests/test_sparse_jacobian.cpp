@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "uncertainties/sparse_jacobian.hpp"
+#include "uncertainties/umath.hpp"
+
+using uncertainties::udouble;
+using uncertainties::Formula;
+using uncertainties::FormulaVar;
+using uncertainties::SparseJacobian;
+using uncertainties::SparsityPattern;
+
+class SparseJacobianTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    // y_i = sin(x_i) * x_{i+1} for i < n - 1, and y_{n-1} = x_{n-1}²
+    static Formula banded_formula(std::size_t n) {
+        return Formula::record(n, [n](const std::vector<FormulaVar>& in) {
+            std::vector<FormulaVar> out;
+            for (std::size_t i = 0; i + 1 < n; ++i) {
+                out.push_back(uncertainties::sin(in[i]) * in[i + 1]);
+            }
+            out.push_back(in[n - 1] * in[n - 1]);
+            return out;
+        });
+    }
+
+    static double entry(const SparseJacobian& J, std::size_t row, std::size_t col) {
+        for (std::size_t k = J.row_offsets[row]; k < J.row_offsets[row + 1]; ++k) {
+            if (J.column_indices[k] == col) {
+                return J.values[k];
+            }
+        }
+        return 0.0;
+    }
+};
+
+TEST_F(SparseJacobianTest, BandedFormulaNeedsTwoColors) {
+    const std::size_t n = 200;
+    Formula f = banded_formula(n);
+
+    SparsityPattern pattern = uncertainties::sparsity_pattern(f);
+    EXPECT_EQ(pattern.rows, n);
+    EXPECT_EQ(pattern.cols, n);
+    EXPECT_EQ(pattern.nonzeros(), 2 * n - 1);
+    std::size_t colors = 0;
+    uncertainties::color_columns(pattern, colors);
+    EXPECT_EQ(colors, 2u);
+
+    std::vector<double> x(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = 0.1 * static_cast<double>(i) - 3.0;
+    }
+    SparseJacobian J = uncertainties::sparse_jacobian(f, x);
+    ASSERT_EQ(J.nonzeros(), 2 * n - 1);
+    EXPECT_TRUE(J.ids.empty());
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        EXPECT_DOUBLE_EQ(entry(J, i, i), std::cos(x[i]) * x[i + 1]);
+        EXPECT_DOUBLE_EQ(entry(J, i, i + 1), std::sin(x[i]));
+    }
+    EXPECT_DOUBLE_EQ(entry(J, n - 1, n - 1), 2.0 * x[n - 1]);
+}
+
+TEST_F(SparseJacobianTest, ColorsSeparateColumnsSharingARow) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::size_t> pick(0, 59);
+    SparsityPattern pattern;
+    pattern.rows = 40;
+    pattern.cols = 60;
+    pattern.row_offsets.assign(1, 0);
+    for (std::size_t r = 0; r < pattern.rows; ++r) {
+        std::vector<std::size_t> row;
+        for (int k = 0; k < 5; ++k) {
+            row.push_back(pick(rng));
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        pattern.column_indices.insert(pattern.column_indices.end(), row.begin(), row.end());
+        pattern.row_offsets.push_back(pattern.column_indices.size());
+    }
+
+    std::size_t colors = 0;
+    std::vector<std::size_t> color = uncertainties::color_columns(pattern, colors);
+    ASSERT_EQ(color.size(), pattern.cols);
+    EXPECT_LT(colors, pattern.cols);
+    for (std::size_t r = 0; r < pattern.rows; ++r) {
+        for (std::size_t a = pattern.row_offsets[r]; a < pattern.row_offsets[r + 1]; ++a) {
+            EXPECT_LT(color[pattern.column_indices[a]], colors);
+            for (std::size_t b = a + 1; b < pattern.row_offsets[r + 1]; ++b) {
+                EXPECT_NE(color[pattern.column_indices[a]], color[pattern.column_indices[b]]);
+            }
+        }
+    }
+}
+
+TEST_F(SparseJacobianTest, UdoubleArgumentsGiveAtomicColumns) {
+    udouble a(1.0, 0.1);
+    udouble b(2.0, 0.2);
+    udouble c(-0.5, 0.05);
+    // Arguments share atomics
+    std::vector<udouble> args{a, a + b, 3.0 * c, udouble(4.0)};
+    Formula f = Formula::record(4, [](const std::vector<FormulaVar>& in) {
+        return std::vector<FormulaVar>{in[0] * in[1], uncertainties::exp(in[2]) + in[3], in[3]};
+    });
+
+    SparseJacobian J = uncertainties::sparse_jacobian(f, args);
+
+    ASSERT_EQ(J.cols, 3u);
+    ASSERT_EQ(J.ids.size(), 3u);
+    EXPECT_TRUE(std::is_sorted(J.ids.begin(), J.ids.end()));
+    EXPECT_EQ(J.sigma, (std::vector<double>{0.1, 0.2, 0.05}));
+    // Output 0 = a (a + b) depends on a and b, output 1 on c, output 2 is exact
+    EXPECT_EQ(J.row_offsets, (std::vector<std::size_t>{0, 2, 3, 3}));
+    EXPECT_DOUBLE_EQ(entry(J, 0, 0), 2.0 * 1.0 + 2.0);
+    EXPECT_DOUBLE_EQ(entry(J, 0, 1), 1.0);
+    EXPECT_DOUBLE_EQ(entry(J, 1, 2), 3.0 * std::exp(-1.5));
+
+    // J diag(σ²) Jᵀ reproduces udouble's stddevs
+    std::vector<udouble> outputs = f.apply(args);
+    for (std::size_t o = 0; o < J.rows; ++o) {
+        double variance = 0.0;
+        for (std::size_t k = J.row_offsets[o]; k < J.row_offsets[o + 1]; ++k) {
+            double contribution = J.values[k] * J.sigma[J.column_indices[k]];
+            variance += contribution * contribution;
+        }
+        EXPECT_NEAR(std::sqrt(variance), outputs[o].stddev(), 1e-15);
+    }
+}
+
+TEST_F(SparseJacobianTest, InputCountMismatchThrows) {
+    Formula f = banded_formula(3);
+    EXPECT_THROW(uncertainties::sparse_jacobian(f, std::vector<double>{1.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::sparse_jacobian(f, std::vector<udouble>{udouble(1.0, 0.1)}),
+                 std::invalid_argument);
+}
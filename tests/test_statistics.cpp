@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "uncertainties/statistics.hpp"
+
+using uncertainties::udouble;
+using uncertainties::SampleAccumulator;
+using uncertainties::JointSampleAccumulator;
+
+class StatisticsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        uncertainties::detail::VariableRegistry::instance().clear();
+    }
+
+    static std::vector<double> samples(std::size_t n, double mean, double sigma, unsigned seed) {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<double> dist(mean, sigma);
+        std::vector<double> out(n);
+        for (double& x : out) {
+            x = dist(rng);
+        }
+        return out;
+    }
+
+    static void two_pass(const std::vector<double>& x, double& mean, double& variance) {
+        mean = 0.0;
+        for (double v : x) {
+            mean += v;
+        }
+        mean /= static_cast<double>(x.size());
+        variance = 0.0;
+        for (double v : x) {
+            variance += (v - mean) * (v - mean);
+        }
+        variance /= static_cast<double>(x.size() - 1);
+    }
+};
+
+TEST_F(StatisticsTest, StreamingBatchedAndParallelAgree) {
+    // Large offset: naive sum-of-squares formulas would lose all digits
+    std::vector<double> x = samples(100003, 1e6, 0.5, 1);
+    double mean = 0.0;
+    double variance = 0.0;
+    two_pass(x, mean, variance);
+
+    SampleAccumulator streamed;
+    for (double v : x) {
+        streamed.add(v);
+    }
+    SampleAccumulator batched;
+    batched.add(x.data(), 10);
+    batched.add(x.data() + 10, x.size() - 10);
+    uncertainties::StatisticsOptions options;
+    options.threads = 4;
+    SampleAccumulator parallel = uncertainties::accumulate(x, options);
+
+    for (const SampleAccumulator* acc : {&streamed, &batched, &parallel}) {
+        EXPECT_EQ(acc->count(), x.size());
+        EXPECT_NEAR(acc->mean(), mean, 1e-13 * mean);
+        EXPECT_NEAR(acc->variance(), variance, 1e-9 * variance);
+    }
+    EXPECT_NEAR(parallel.standard_error(), std::sqrt(variance / x.size()), 1e-12);
+}
+
+TEST_F(StatisticsTest, MergeCombinesDisjointStreams) {
+    std::vector<double> a = samples(500, 3.0, 1.0, 2);
+    std::vector<double> b = samples(1500, 5.0, 2.0, 3);
+    SampleAccumulator left;
+    left.add(a);
+    SampleAccumulator right;
+    right.add(b);
+    left.merge(right);
+    left.merge(SampleAccumulator());
+
+    std::vector<double> all(a);
+    all.insert(all.end(), b.begin(), b.end());
+    double mean = 0.0;
+    double variance = 0.0;
+    two_pass(all, mean, variance);
+    EXPECT_EQ(left.count(), 2000u);
+    EXPECT_NEAR(left.mean(), mean, 1e-12);
+    EXPECT_NEAR(left.variance(), variance, 1e-10);
+}
+
+TEST_F(StatisticsTest, ResultIsAnAtomicWithTheStandardError) {
+    SampleAccumulator first;
+    first.add({1.0, 2.0, 3.0, 4.0});
+    SampleAccumulator second;
+    second.add({10.0, 12.0});
+
+    udouble g1 = first.result();
+    udouble g2 = second.result();
+
+    EXPECT_DOUBLE_EQ(g1.nominal_value(), 2.5);
+    EXPECT_DOUBLE_EQ(g1.stddev(), std::sqrt((5.0 / 3.0) / 4.0));
+    EXPECT_EQ(g1.num_variables(), 1u);
+    EXPECT_NEAR((g1 - g2).stddev(), std::hypot(g1.stddev(), g2.stddev()), 1e-15);
+
+    SampleAccumulator single;
+    single.add(1.0);
+    EXPECT_THROW(single.result(), std::runtime_error);
+    EXPECT_THROW(SampleAccumulator().variance(), std::runtime_error);
+}
+
+TEST_F(StatisticsTest, JointMeansAreCorrelated) {
+    // Current and voltage read from the same shot: v = 2 i + noise
+    std::vector<double> i = samples(4000, 1.0, 0.1, 4);
+    std::vector<double> noise = samples(4000, 0.0, 0.05, 5);
+    std::vector<double> rows;
+    for (std::size_t k = 0; k < i.size(); ++k) {
+        rows.push_back(i[k]);
+        rows.push_back(2.0 * i[k] + noise[k]);
+    }
+
+    JointSampleAccumulator streamed(2);
+    for (std::size_t k = 0; k < i.size(); ++k) {
+        streamed.add(rows.data() + 2 * k);
+    }
+    JointSampleAccumulator batched(2);
+    batched.add(rows.data(), 1000);
+    JointSampleAccumulator rest(2);
+    rest.add(rows.data() + 2000, 3000);
+    batched.merge(rest);
+
+    std::vector<double> c1 = streamed.covariance();
+    std::vector<double> c2 = batched.covariance();
+    for (std::size_t k = 0; k < 4; ++k) {
+        EXPECT_NEAR(c1[k], c2[k], 1e-12);
+    }
+    EXPECT_NEAR(streamed.mean()[1], batched.mean()[1], 1e-12);
+
+    std::vector<udouble> m = batched.means();
+    const double n = 4000.0;
+    EXPECT_NEAR(m[0].stddev(), std::sqrt(c2[0] / n), 1e-15);
+    EXPECT_NEAR(m[1].stddev(), std::sqrt(c2[3] / n), 1e-15);
+    // The common current cancels in v - 2 i
+    udouble residual = m[1] - 2.0 * m[0];
+    EXPECT_NEAR(residual.stddev(), std::sqrt((c2[3] - 4.0 * c2[1] + 4.0 * c2[0]) / n), 1e-12);
+    EXPECT_LT(residual.stddev(), 0.5 * m[1].stddev());
+
+    EXPECT_THROW(batched.add({1.0}), std::invalid_argument);
+    EXPECT_THROW(batched.merge(JointSampleAccumulator(3)), std::invalid_argument);
+}
+
+TEST_F(StatisticsTest, CorrelatedValuesFromCovariance) {
+    std::vector<double> cov{4.0, 1.0, 0.0,
+                            1.0, 2.0, -0.5,
+                            0.0, -0.5, 1.0};
+    std::vector<udouble> v = uncertainties::correlated_values({1.0, 2.0, 3.0}, cov);
+
+    ASSERT_EQ(v.size(), 3u);
+    EXPECT_DOUBLE_EQ(v[1].nominal_value(), 2.0);
+    EXPECT_NEAR(v[0].stddev(), 2.0, 1e-15);
+    EXPECT_NEAR(v[2].stddev(), 1.0, 1e-15);
+    // var(a + b) = var a + var b + 2 cov(a, b)
+    EXPECT_NEAR((v[0] + v[1]).stddev(), std::sqrt(4.0 + 2.0 + 2.0), 1e-14);
+    EXPECT_NEAR((v[1] - v[2]).stddev(), std::sqrt(2.0 + 1.0 + 1.0), 1e-14);
+
+    // Perfectly correlated (semidefinite)
+    std::vector<udouble> same = uncertainties::correlated_values({0.0, 0.0}, {1.0, 1.0, 1.0, 1.0});
+    EXPECT_NEAR((same[0] - same[1]).stddev(), 0.0, 1e-15);
+
+    EXPECT_THROW(uncertainties::correlated_values({0.0, 0.0}, {1.0, 0.5, 0.0, 1.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::correlated_values({0.0, 0.0}, {1.0, 2.0, 2.0, 1.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::correlated_values({0.0}, {1.0, 0.0}), std::invalid_argument);
+}
+
+TEST_F(StatisticsTest, IndefiniteCovarianceWithZeroPivotThrows) {
+    EXPECT_THROW(uncertainties::correlated_values({0.0, 0.0}, {0.0, 1.0, 1.0, 0.0}), std::invalid_argument);
+    EXPECT_THROW(uncertainties::correlated_values({0.0, 0.0}, {1e-20, 1.0, 1.0, 1.0}), std::invalid_argument);
+
+    // A zero-variance value uncorrelated with the rest is fine
+    std::vector<udouble> v = uncertainties::correlated_values({1.0, 2.0}, {0.0, 0.0, 0.0, 1.0});
+    EXPECT_EQ(v[0].stddev(), 0.0);
+    EXPECT_NEAR((v[0] + v[1]).stddev(), 1.0, 1e-15);
+}